@@ -0,0 +1,152 @@
+// Bind count benchmark: a scene of 10k objects over 200 models, drawn in the order the
+// objects are visited and in LveRenderQueue key order. Counts the binds LveCommandRecorder
+// would issue for each order the way LveRenderSystem records them, plus the instanced draws
+// and indirect batches, and times the sort. In the engine, LveRenderSystem::setSortDraws and
+// LodStats::commands give the same comparison for a real frame.
+
+#include "lve_render_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+using lve::LveRenderQueue;
+
+constexpr uint32_t OBJECT_COUNT = 10000;
+constexpr uint32_t MODEL_COUNT = 200;
+constexpr uint32_t LOD_COUNT = 4;
+constexpr int RUNS = 50;
+
+// what LveRenderSystem reads off a model to bind it
+struct Model {
+	uint32_t pipeline;   // quantized or full vertices
+	uint32_t arena;      // quantized models have their own arena, full ones fill two
+	uint32_t indexType;  // 1 for 32 bit indices
+};
+
+struct Object {
+	uint32_t model;
+	uint32_t lod;
+	float distance;
+};
+
+struct Counts {
+	uint32_t pipelineBinds = 0;
+	uint32_t vertexBufferBinds = 0;
+	uint32_t indexBufferBinds = 0;
+	uint32_t draws = 0;             // instanced, one per run of the same model and LOD
+	uint32_t indirectBatches = 0;   // runs of the same pipeline and buffers
+};
+
+// binds before every draw and drops what repeats the bound state, as the recorder does
+Counts countBinds(const std::vector<Model> &models, const std::vector<Object> &objects, const std::vector<uint32_t> &order) {
+	Counts counts{};
+	uint32_t pipeline = ~0u, arena = ~0u, indexType = ~0u;
+	uint32_t lastModel = ~0u, lastLod = ~0u;
+	for (uint32_t index : order) {
+		const Object &object = objects[index];
+		if (object.model == lastModel && object.lod == lastLod) continue;
+		lastModel = object.model;
+		lastLod = object.lod;
+		counts.draws++;
+
+		const Model &model = models[object.model];
+		const bool batchBreak = model.pipeline != pipeline || model.arena != arena || model.indexType != indexType;
+		if (batchBreak) counts.indirectBatches++;
+		if (model.pipeline != pipeline) {
+			pipeline = model.pipeline;
+			counts.pipelineBinds++;
+		}
+		if (model.arena != arena) {
+			arena = model.arena;
+			counts.vertexBufferBinds++;
+			// another arena is another index buffer
+			indexType = ~0u;
+		}
+		if (model.indexType != indexType) {
+			indexType = model.indexType;
+			counts.indexBufferBinds++;
+		}
+	}
+	return counts;
+}
+
+void print(const char *name, const Counts &counts) {
+	std::printf(
+		"%-10s pipeline %5u  vertex buffer %5u  index buffer %5u  draws %5u  indirect batches %5u\n",
+		name,
+		counts.pipelineBinds,
+		counts.vertexBufferBinds,
+		counts.indexBufferBinds,
+		counts.draws,
+		counts.indirectBatches);
+}
+
+}
+
+int main() {
+	std::mt19937 rng{1};
+
+	std::vector<Model> models(MODEL_COUNT);
+	for (uint32_t i = 0; i < MODEL_COUNT; i++) {
+		const bool quantized = i % 2 == 1;
+		models[i].pipeline = quantized ? 1 : 0;
+		models[i].arena = quantized ? 2 : (i < MODEL_COUNT / 2 ? 0 : 1);
+		models[i].indexType = i % 8 == 0 ? 1 : 0;
+	}
+
+	// coarser LODs further out
+	std::uniform_int_distribution<uint32_t> modelIndex{0, MODEL_COUNT - 1};
+	std::uniform_real_distribution<float> distance{1.f, 200.f};
+	std::vector<Object> objects(OBJECT_COUNT);
+	for (auto &object : objects) {
+		object.model = modelIndex(rng);
+		object.distance = distance(rng);
+		object.lod = std::min(static_cast<uint32_t>(object.distance / 50.f), LOD_COUNT - 1);
+	}
+
+	// the game objects live in a hash map, they are visited in no particular order
+	std::vector<uint32_t> visited(OBJECT_COUNT);
+	std::iota(visited.begin(), visited.end(), 0u);
+	std::shuffle(visited.begin(), visited.end(), rng);
+
+	// the key LveRenderSystem::collectDrawItems builds, arena and index type as geometry
+	LveRenderQueue queue{};
+	queue.reserve(OBJECT_COUNT);
+	double best = 1e30;
+	for (int run = 0; run < RUNS; run++) {
+		auto start = std::chrono::steady_clock::now();
+		queue.clear();
+		for (uint32_t index : visited) {
+			const Object &object = objects[index];
+			const Model &model = models[object.model];
+			queue.push(
+				LveRenderQueue::makeKey(
+					LveRenderQueue::Pass::Opaque,
+					model.pipeline,
+					model.arena << 1 | model.indexType,
+					object.model,
+					object.lod,
+					LveRenderQueue::depthKey(object.distance)),
+				index);
+		}
+		queue.sort();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+	}
+	std::vector<uint32_t> sorted;
+	sorted.reserve(OBJECT_COUNT);
+	for (const auto &packet : queue.getPackets()) sorted.push_back(packet.index);
+
+	std::printf("%u objects, %u models, %u LODs\n", OBJECT_COUNT, MODEL_COUNT, LOD_COUNT);
+	print("visited", countBinds(models, objects, visited));
+	print("sorted", countBinds(models, objects, sorted));
+	std::printf("keys + sort: %.1f us\n", best);
+	return 0;
+}
@@ -0,0 +1,87 @@
+// CPU frustum culling benchmark: 100k bounding spheres scattered around a camera, culled
+// with every path LveFrustumCuller was compiled with and with LveFrustum::intersectsSphere
+// one sphere at a time.
+
+#include "lve_camera.hpp"
+#include "lve_frustum_culler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lve::LveFrustumCuller;
+
+constexpr size_t OBJECT_COUNT = 100000;
+constexpr int RUNS = 50;
+
+// best of RUNS, in microseconds
+double time(const std::function<void()> &run) {
+	double best = 1e30;
+	for (int i = 0; i < RUNS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		run();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+	}
+	return best;
+}
+
+}
+
+int main() {
+	lve::LveCamera camera{};
+	camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, 0.1f, 200.f);
+	camera.setViewDirection({0.f, -2.f, 0.f}, {0.f, 0.f, 1.f});
+	const lve::LveFrustum frustum = camera.getFrustum();
+
+	// about a sixth of the objects end up in view
+	std::mt19937 rng{1};
+	std::uniform_real_distribution<float> coordinate{-200.f, 200.f};
+	std::uniform_real_distribution<float> radius{0.1f, 3.f};
+	std::vector<glm::vec4> spheres(OBJECT_COUNT);
+	LveFrustumCuller culler{};
+	culler.reserve(OBJECT_COUNT);
+	for (auto &sphere : spheres) {
+		sphere.x = coordinate(rng);
+		sphere.y = coordinate(rng) * 0.1f;
+		sphere.z = coordinate(rng);
+		sphere.w = radius(rng);
+		culler.addSphere(glm::vec3(sphere), sphere.w);
+	}
+
+	std::vector<uint32_t> visible;
+	visible.reserve(OBJECT_COUNT);
+	double reference = time([&] {
+		visible.clear();
+		for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+			if (frustum.intersectsSphere(glm::vec3(spheres[i]), spheres[i].w)) visible.push_back(i);
+		}
+	});
+	std::printf("%zu objects, %zu visible\n", OBJECT_COUNT, visible.size());
+	std::printf("%-16s %9.1f us\n", "intersectsSphere", reference);
+
+	const std::pair<LveFrustumCuller::Path, const char *> paths[] = {
+		{LveFrustumCuller::Path::Scalar, "scalar"},
+		{LveFrustumCuller::Path::Sse, "sse"},
+		{LveFrustumCuller::Path::Avx, "avx"},
+	};
+	for (auto &path : paths) {
+		if (!LveFrustumCuller::isAvailable(path.first)) {
+			std::printf("%-16s not available\n", path.second);
+			continue;
+		}
+		double elapsed = time([&] {
+			visible.clear();
+			culler.cull(frustum, visible, path.first);
+		});
+		std::printf("%-16s %9.1f us, %.2fx\n", path.second, elapsed, reference / elapsed);
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+// Model loading benchmark, run from the repository root (make bench). Times the cold OBJ
+// parse + weld, opening the mesh cache, and welding a synthetic mesh of 10M indices with
+// LveVertexWelder against the unordered_map dedup it replaced. Also reports the post-transform
+// cache stats of every model before and after LveModel::Builder::optimize().
+
+#include "lve_mesh_cache.hpp"
+#include "lve_model.hpp"
+#include "lve_utils.hpp"
+#include "lve_vertex_welder.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace std {
+template <>
+struct hash<lve::LveModel::Vertex> {
+	size_t operator()(lve::LveModel::Vertex const &vertex) const {
+		size_t seed = 0;
+		lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+		return seed;
+	}
+};
+}
+
+namespace {
+
+using lve::LveMeshCache;
+using lve::LveModel;
+using lve::LveVertexWelder;
+
+constexpr int RUNS = 5;
+
+// best of RUNS, in milliseconds
+double time(const std::function<void()> &run) {
+	double best = 1e30;
+	for (int i = 0; i < RUNS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		run();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+void benchModel(const std::string &path) {
+	LveModel::Builder builder{};
+	double parse = time([&] { builder.loadModel(path); });
+
+	if (!LveMeshCache::write(path, builder)) {
+		std::printf("%-24s %9.3f ms parse, cache not writable\n", path.c_str(), parse);
+		return;
+	}
+	uint64_t checksum = 0;
+	double cacheHit = time([&] {
+		auto cache = LveMeshCache::open(path);
+		// touch the mapped indices, opening alone only maps the file
+		for (uint32_t i = 0; cache && i < cache->indexCount(); i++) checksum += cache->indices()[i];
+	});
+	std::printf(
+		"%-24s %9.3f ms parse, %9.3f ms cache hit, %zu vertices, %zu indices (%llu)\n",
+		path.c_str(),
+		parse,
+		cacheHit,
+		builder.vertices.size(),
+		builder.indices.size(),
+		static_cast<unsigned long long>(checksum));
+}
+
+// ACMR and ATVR of a 16 entry FIFO cache, as loaded and after optimize() with and without
+// overdraw reduction
+void reportVertexCache(const std::string &path) {
+	LveModel::Builder builder{};
+	builder.loadModel(path);
+	auto stats = builder.optimize();
+	double optimize = time([&] {
+		builder.loadModel(path);
+		builder.optimize();
+	});
+
+	LveModel::Builder overdraw{};
+	overdraw.loadModel(path);
+	auto overdrawStats = overdraw.optimize(true);
+
+	std::printf(
+		"%-24s ACMR %.3f -> %.3f (%.3f with overdraw), ATVR %.3f -> %.3f (%.3f with overdraw), %9.3f ms load + optimize\n",
+		path.c_str(),
+		stats.first.acmr,
+		stats.second.acmr,
+		overdrawStats.second.acmr,
+		stats.first.atvr,
+		stats.second.atvr,
+		overdrawStats.second.atvr,
+		optimize);
+}
+
+// A grid with every triangle corner emitted separately, as the OBJ loader sees it: about
+// six references to every unique vertex.
+std::vector<LveModel::Vertex> syntheticCorners(size_t indexCount) {
+	const uint32_t quads = static_cast<uint32_t>(indexCount / 6);
+	const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(quads))));
+	std::vector<LveModel::Vertex> corners;
+	corners.reserve(static_cast<size_t>(quads) * 6);
+	auto vertex = [side](uint32_t x, uint32_t y) {
+		LveModel::Vertex v{};
+		v.position = {static_cast<float>(x), 0.f, static_cast<float>(y)};
+		v.color = {1.f, 1.f, 1.f};
+		v.normal = {0.f, -1.f, 0.f};
+		v.uv = {static_cast<float>(x) / side, static_cast<float>(y) / side};
+		return v;
+	};
+	for (uint32_t q = 0; q < quads; q++) {
+		uint32_t x = q % side, y = q / side;
+		corners.push_back(vertex(x, y));
+		corners.push_back(vertex(x + 1, y));
+		corners.push_back(vertex(x + 1, y + 1));
+		corners.push_back(vertex(x, y));
+		corners.push_back(vertex(x + 1, y + 1));
+		corners.push_back(vertex(x, y + 1));
+	}
+	return corners;
+}
+
+void benchSynthetic(size_t indexCount) {
+	const std::vector<LveModel::Vertex> corners = syntheticCorners(indexCount);
+	std::vector<LveModel::Vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	double welder = time([&] {
+		vertices.clear();
+		indices.clear();
+		indices.reserve(corners.size());
+		LveVertexWelder weld{vertices, corners.size()};
+		for (const auto &corner : corners) indices.push_back(weld.weld(corner));
+	});
+	const size_t uniqueVertices = vertices.size();
+
+	double epsilon = time([&] {
+		vertices.clear();
+		indices.clear();
+		indices.reserve(corners.size());
+		LveVertexWelder weld{vertices, corners.size(), 1e-4f};
+		for (const auto &corner : corners) indices.push_back(weld.weld(corner));
+	});
+
+	double map = time([&] {
+		vertices.clear();
+		indices.clear();
+		indices.reserve(corners.size());
+		std::unordered_map<LveModel::Vertex, uint32_t> uniqueMap{};
+		for (const auto &corner : corners) {
+			if (uniqueMap.count(corner) == 0) {
+				uniqueMap[corner] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(corner);
+			}
+			indices.push_back(uniqueMap[corner]);
+		}
+	});
+
+	std::printf(
+		"synthetic %zu indices, %zu vertices: %9.3f ms welder, %9.3f ms welder with epsilon, %9.3f ms unordered_map\n",
+		corners.size(),
+		uniqueVertices,
+		welder,
+		epsilon,
+		map);
+}
+
+}
+
+int main() {
+	const char *models[] = {
+		"models/colored_cube.obj",
+		"models/cube.obj",
+		"models/flat_vase.obj",
+		"models/quad.obj",
+		"models/smooth_vase.obj",
+		"models/suzzane.obj",
+	};
+	for (const char *model : models) {
+		benchModel(model);
+	}
+	for (const char *model : models) {
+		reportVertexCache(model);
+	}
+	benchSynthetic(10'000'000);
+	return 0;
+}
@@ -6,11 +6,6 @@ layout(location=2) in vec3 fragNormalWorld;
 
 layout(location=0) out vec4 outColor;
 
-layout(push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
-
 struct PointLight {
   vec4 position;
   vec4 color;
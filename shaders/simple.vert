@@ -9,10 +9,20 @@ layout(location=0) out vec3 fragColor;
 layout(location=1) out vec3 fragPosWorld;
 layout(location=2) out vec3 fragNormalWorld;
 
-layout(push_constant) uniform Push {
+// LveModel::QuantizedVertex: the position is unorm (the model matrix already holds the
+// bounds transform), the normal is octahedral in xy and the color/uv are converted by the
+// vertex fetch
+layout(constant_id = 0) const bool QUANTIZED_VERTICES = false;
+
+// one per drawn object, instanced draws start at their group's firstInstance
+struct Instance {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+	Instance instances[];
+};
 
 struct PointLight {
   vec4 position;
@@ -28,11 +38,21 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0) {
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
+
 void main() {
-	vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+	Instance instance = instances[gl_InstanceIndex];
+	vec4 positionWorld = instance.modelMatrix * vec4(position, 1.0);
 	gl_Position = ubo.projection * ubo.view * positionWorld;
 
-	fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+	vec3 normalModel = QUANTIZED_VERTICES ? octDecode(normal.xy) : normal;
+	fragNormalWorld = normalize(mat3(instance.normalMatrix) * normalModel);
 	fragPosWorld = positionWorld.xyz;
 	fragColor = color;
 }
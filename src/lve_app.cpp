@@ -8,6 +8,7 @@
 #include "lve_renderer.hpp"
 #include "lve_buffer.hpp"
 #include "lve_render_system.hpp"
+#include "lve_gpu_culler.hpp"
 #include "lve_point_light_system.hpp"
 #include "lve_input.hpp"
 #include "vulkan/vulkan_core.h"
@@ -16,6 +17,7 @@
 #include <stdexcept>
 #include <array>
 #include <chrono>
+#include <memory>
 #include <numeric>
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -25,37 +27,42 @@
 namespace lve {
 
 LveApp::LveApp() {
+	// one dynamic uniform buffer serves every frame in flight
 	globalPool =
-      LveDescriptorPool::Builder(lveDevice).setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT).addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT).build();
+      LveDescriptorPool::Builder(lveDevice).setMaxSets(1).addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1).build();
+	// models stream in while the first frames render
 	loadGameObjects();
 }
 
 LveApp::~LveApp() { }
 
 void LveApp::run() {
-std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-	for (int i = 0; i < uboBuffers.size(); i++) {
-		uboBuffers[i] = std::make_unique<LveBuffer>(
-			lveDevice,
-			sizeof(GlobalUbo),
-			1,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-
-		uboBuffers[i]->map();
-	}
-
-	
-	auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS).build();
-
-	std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-	for (int i = 0; i < globalDescriptorSets.size(); i++) {
-		auto bufferInfo = uboBuffers[i]->descriptorInfo();
-		LveDescriptorWriter(*globalSetLayout, *globalPool).writeBuffer(0, &bufferInfo).build(globalDescriptorSets[i]);
-	}
-
-	LveRenderSystem simpleRenderSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+	// one instance per frame in flight, each frame binds its own with a dynamic offset
+	LveBuffer uboBuffer{
+		lveDevice,
+		sizeof(GlobalUbo),
+		LveSwapChain::MAX_FRAMES_IN_FLIGHT,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		lveDevice.properties.limits.minUniformBufferOffsetAlignment,
+		LveMemoryCategory::Uniforms};
+	uboBuffer.map();
+
+	auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice).addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT).build();
+
+	VkDescriptorSet globalDescriptorSet;
+	auto bufferInfo = uboBuffer.descriptorInfoForIndex(0);
+	LveDescriptorWriter(*globalSetLayout, *globalPool).writeBuffer(0, &bufferInfo).build(globalDescriptorSet);
+
+	LveRenderSystem simpleRenderSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(), lveRenderer.getFrameAllocator()};
+	LveOcclusionCuller occlusionCuller{};
+	simpleRenderSystem.setOcclusionCuller(&occlusionCuller);
 	LvePointLightSystem pointLightSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+	// culls on the GPU where the draws can pick their instance, on the CPU otherwise
+	std::unique_ptr<LveGpuCuller> gpuCuller;
+	if (LveGpuCuller::isSupported(lveDevice)) {
+		gpuCuller = std::make_unique<LveGpuCuller>(lveDevice, globalSetLayout->getDescriptorSetLayout(), lveRenderer.getSwapChainExtent());
+	}
 	LveCamera camera{};
 
 	auto viewerObject = LveGameObject::createGameObject();
@@ -65,6 +72,7 @@ std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_F
 
 	while (!lveWindow.shouldClose()) {
 		glfwPollEvents();
+		modelRegistry.update();
 
 		auto newTime = std::chrono::high_resolution_clock::now();
 		float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
@@ -85,8 +93,11 @@ std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_F
 				frameTime,
 				commandBuffer,
 				camera,
-				globalDescriptorSets[frameIndex],
-				gameObjects
+				globalDescriptorSet,
+				uboBuffer.dynamicOffsetForIndex(frameIndex),
+				gameObjects,
+				lveRenderer.getFrameAllocator(),
+				lveRenderer.getCommandRecorder()
 			};
 
 			// Update
@@ -95,14 +106,20 @@ std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_F
 			ubo.view = camera.getView();
 			ubo.inverseView = camera.getInverseView();
 			pointLightSystem.update(frameInfo, ubo);
-			uboBuffers[frameIndex]->writeToBuffer(&ubo);
-			uboBuffers[frameIndex]->flush();
+			uboBuffer.writeToIndex(&ubo, frameIndex);
+			uboBuffer.flushIndex(frameIndex);
 
 			// Render
+			if (gpuCuller) {
+				simpleRenderSystem.cullGameObjects(frameInfo, *gpuCuller);
+			}
 			lveRenderer.beginSwapChainRenderPass(commandBuffer);
 			simpleRenderSystem.renderGameObjects(frameInfo);
 			pointLightSystem.render(frameInfo);
 			lveRenderer.endSwapChainRenderPass(commandBuffer);
+			if (gpuCuller) {
+				gpuCuller->buildDepthPyramid(frameInfo, lveRenderer.getCurrentDepthAttachment());
+			}
 			lveRenderer.endFrame();
 		}
 	}
@@ -112,7 +129,7 @@ std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_F
 
 
 void LveApp::loadGameObjects() {
-	std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "models/flat_vase.obj");
+	LveModelHandle lveModel = modelRegistry.load("models/flat_vase.obj");
 	auto flatVase = LveGameObject::createGameObject();
 	flatVase.model = lveModel;
 	flatVase.transform.translation = {-.5f, .5f, 2.5f};
@@ -120,7 +137,7 @@ void LveApp::loadGameObjects() {
 	flatVase.transform.scale = {3.f, 1.5f, 3.f};
 	gameObjects.emplace(flatVase.getId(), std::move(flatVase));
 
-	lveModel = LveModel::createModelFromFile(lveDevice, "models/smooth_vase.obj");
+	lveModel = modelRegistry.load("models/smooth_vase.obj", LveModel::VertexFormat::Quantized);
 	auto smoothVase = LveGameObject::createGameObject();
 	smoothVase.model = lveModel;
 	smoothVase.transform.translation = {.5f, .5f, 2.5f};
@@ -128,11 +145,13 @@ void LveApp::loadGameObjects() {
 	smoothVase.transform.scale = {3.f, 1.5f, 3.f};
 	gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
 
-	lveModel = LveModel::createModelFromFile(lveDevice, "models/quad.obj");
+	lveModel = modelRegistry.load("models/quad.obj");
 	auto floor = LveGameObject::createGameObject();
 	floor.model = lveModel;
 	floor.transform.translation = {0.f, .5f, 0.f};
 	floor.transform.scale = {3.f, 1.f, 3.f};
+	// hides what lies beneath it
+	floor.occluder = LveOccluder::fromFile("models/quad.obj");
 	gameObjects.emplace(floor.getId(), std::move(floor));
 
 
@@ -6,6 +6,8 @@
 #include "lve_device.hpp"
 #include "lve_renderer.hpp"
 #include "lve_descriptors.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_model_registry.hpp"
 #include "vulkan/vulkan_core.h"
 
 #include <memory>
@@ -33,6 +35,9 @@ private:
 	LveDevice lveDevice{lveWindow};
 
 	LveRenderer lveRenderer{lveWindow, lveDevice};
+	// vertices and indices of every model, has to outlive gameObjects
+	LveGeometryArena geometryArena{lveDevice};
+	LveModelRegistry modelRegistry{lveDevice, geometryArena};
 
 	// order of declarations matters idk why
 	std::unique_ptr<LveDescriptorPool> globalPool{};
@@ -0,0 +1,66 @@
+#include "lve_asset_streamer.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace lve {
+
+LveAssetStreamer::LveAssetStreamer(LveDevice &device, LveGeometryArena &arena, unsigned threadCount)
+	: lveDevice{device}, geometryArena{arena}, threadPool{threadCount} {}
+
+LveAssetStreamer::~LveAssetStreamer() {
+	// workers blocked on a full result queue give up instead of waiting for update()
+	stopping.store(true, std::memory_order_relaxed);
+}
+
+void LveAssetStreamer::load(std::shared_ptr<LveModelHandle::Slot> slot) {
+	slot->state.store(LveModelHandle::State::Loading, std::memory_order_release);
+	pendingCount++;
+
+	// the worker only reads filepath and format, which don't change while loading
+	threadPool.submit([this, slot] {
+		Result result{slot, std::make_unique<LveModel::Builder>(), nullptr};
+		result.builder->vertexFormat = slot->format;
+		// the pool already keeps every core busy, parser threads on top would oversubscribe
+		result.builder->parseThreads = 1;
+		try {
+			result.cache = LveModel::prepareModelData(slot->filepath, *result.builder);
+			if (result.cache) {
+				result.builder.reset();
+			}
+		} catch (const std::exception &e) {
+			std::cerr << "failed to load " << slot->filepath << ": " << e.what() << std::endl;
+			result.builder.reset();
+		}
+
+		while (!results.tryPush(result)) {
+			if (stopping.load(std::memory_order_relaxed)) {
+				return;
+			}
+			std::this_thread::yield();
+		}
+	});
+}
+
+void LveAssetStreamer::update(uint32_t maxModels) {
+	Result result;
+	for (uint32_t i = 0; i < maxModels && results.tryPop(result); i++) {
+		pendingCount--;
+		auto &slot = *result.slot;
+		try {
+			if (result.cache) {
+				slot.setModel(std::make_shared<LveModel>(lveDevice, geometryArena, *result.cache, slot.format));
+			} else if (result.builder) {
+				slot.setModel(std::make_shared<LveModel>(lveDevice, geometryArena, *result.builder));
+			}
+		} catch (const std::exception &e) {
+			// e.g. the geometry arena is full
+			std::cerr << "failed to create " << slot.filepath << ": " << e.what() << std::endl;
+		}
+		slot.state.store(slot.model ? LveModelHandle::State::Ready : LveModelHandle::State::Failed, std::memory_order_release);
+		result = Result{};
+	}
+}
+
+}
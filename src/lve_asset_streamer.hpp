@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_lock_free_queue.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_model.hpp"
+#include "lve_model_handle.hpp"
+#include "lve_thread_pool.hpp"
+
+#include <atomic>
+#include <memory>
+
+namespace lve {
+
+// Loads models in the background. Workers parse, optimize and cache meshes (or map an
+// existing cache) and hand the result to the render thread through a lock-free queue;
+// update() turns them into models, whose uploads go out with the next upload batch submit.
+// Deduplication and eviction are LveModelRegistry's job.
+class LveAssetStreamer {
+public:
+	static constexpr size_t RESULT_QUEUE_CAPACITY = 256;
+	// models created per update(), keeps a burst of finished loads from stalling a frame
+	static constexpr uint32_t DEFAULT_MODELS_PER_UPDATE = 8;
+
+	LveAssetStreamer(LveDevice &device, LveGeometryArena &arena, unsigned threadCount = 0);
+	~LveAssetStreamer();
+
+	LveAssetStreamer(const LveAssetStreamer &) = delete;
+	LveAssetStreamer &operator=(const LveAssetStreamer &) = delete;
+
+	// loads slot->filepath in slot->format into slot->model
+	void load(std::shared_ptr<LveModelHandle::Slot> slot);
+
+	// render thread, once per frame
+	void update(uint32_t maxModels = DEFAULT_MODELS_PER_UPDATE);
+
+	uint32_t getPendingCount() const { return pendingCount; }
+
+private:
+	struct Result {
+		std::shared_ptr<LveModelHandle::Slot> slot;
+		std::unique_ptr<LveModel::Builder> builder;
+		std::unique_ptr<LveMeshCache> cache;
+	};
+
+	LveDevice &lveDevice;
+	LveGeometryArena &geometryArena;
+
+	uint32_t pendingCount = 0;
+	std::atomic<bool> stopping{false};
+
+	// declared last: workers are joined before the queue they push to goes away
+	LveLockFreeQueue<Result> results{RESULT_QUEUE_CAPACITY};
+	LveThreadPool threadPool;
+};
+
+}
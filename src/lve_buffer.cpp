@@ -25,7 +25,8 @@ LveBuffer::LveBuffer(
     uint32_t instanceCount,
     VkBufferUsageFlags usageFlags,
     VkMemoryPropertyFlags memoryPropertyFlags,
-    VkDeviceSize minOffsetAlignment)
+    VkDeviceSize minOffsetAlignment,
+    LveMemoryCategory memoryCategory)
     : lveDevice{device},
       instanceSize{instanceSize},
       instanceCount{instanceCount},
@@ -33,26 +34,28 @@ LveBuffer::LveBuffer(
       memoryPropertyFlags{memoryPropertyFlags} {
   alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
   bufferSize = alignmentSize * instanceCount;
-  device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+  device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory, memoryCategory);
 }
 
 LveBuffer::~LveBuffer() {
   unmap();
   vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-  vkFreeMemory(lveDevice.device(), memory, nullptr);
+  lveDevice.freeMemory(memory);
 }
 
+/**
+ * Host visible memory is mapped for as long as the allocator holds it, map() only hands out
+ * the part of that mapping belonging to this buffer.
+ */
 VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-  assert(buffer && memory && "Called map on buffer before create");
-  return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+  assert(buffer && memory.memory && "Called map on buffer before create");
+  assert(memory.mapped && "Cannot map a buffer that isn't host visible");
+  assert((size == VK_WHOLE_SIZE || offset + size <= bufferSize) && "Mapped range is outside of the buffer");
+  mapped = static_cast<char *>(memory.mapped) + offset;
+  return VK_SUCCESS;
 }
 
-void LveBuffer::unmap() {
-  if (mapped) {
-    vkUnmapMemory(lveDevice.device(), memory);
-    mapped = nullptr;
-  }
-}
+void LveBuffer::unmap() { mapped = nullptr; }
 
 void LveBuffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset) {
   assert(mapped && "Cannot copy to unmapped buffer");
@@ -67,20 +70,12 @@ void LveBuffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset
 }
 
 VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mappedRange = {};
-  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mappedRange.memory = memory;
-  mappedRange.offset = offset;
-  mappedRange.size = size;
+  VkMappedMemoryRange mappedRange = lveDevice.getMemoryAllocator().mappedRange(memory, size, offset);
   return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
 }
 
 VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-  VkMappedMemoryRange mappedRange = {};
-  mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  mappedRange.memory = memory;
-  mappedRange.offset = offset;
-  mappedRange.size = size;
+  VkMappedMemoryRange mappedRange = lveDevice.getMemoryAllocator().mappedRange(memory, size, offset);
   return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
 }
 
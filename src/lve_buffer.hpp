@@ -12,7 +12,8 @@ class LveBuffer {
       uint32_t instanceCount,
       VkBufferUsageFlags usageFlags,
       VkMemoryPropertyFlags memoryPropertyFlags,
-      VkDeviceSize minOffsetAlignment = 1);
+      VkDeviceSize minOffsetAlignment = 1,
+      LveMemoryCategory memoryCategory = LveMemoryCategory::Other);
   ~LveBuffer();
 
   LveBuffer(const LveBuffer&) = delete;
@@ -30,12 +31,16 @@ class LveBuffer {
   VkResult flushIndex(int index);
   VkDescriptorBufferInfo descriptorInfoForIndex(int index);
   VkResult invalidateIndex(int index);
+  // Offset of an instance for VK_DESCRIPTOR_TYPE_*_BUFFER_DYNAMIC bindings written with
+  // descriptorInfoForIndex(0). Needs minOffsetAlignment set to the device's minimum uniform
+  // or storage buffer offset alignment.
+  uint32_t dynamicOffsetForIndex(int index) const { return static_cast<uint32_t>(index * alignmentSize); }
 
   VkBuffer getBuffer() const { return buffer; }
   void* getMappedMemory() const { return mapped; }
   uint32_t getInstanceCount() const { return instanceCount; }
   VkDeviceSize getInstanceSize() const { return instanceSize; }
-  VkDeviceSize getAlignmentSize() const { return instanceSize; }
+  VkDeviceSize getAlignmentSize() const { return alignmentSize; }
   VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
   VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
   VkDeviceSize getBufferSize() const { return bufferSize; }
@@ -46,7 +51,7 @@ class LveBuffer {
   LveDevice& lveDevice;
   void* mapped = nullptr;
   VkBuffer buffer = VK_NULL_HANDLE;
-  VkDeviceMemory memory = VK_NULL_HANDLE;
+  LveMemoryAllocation memory{};
 
   VkDeviceSize bufferSize;
   uint32_t instanceCount;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "lve_frustum.hpp"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -20,6 +22,8 @@ public:
 	const glm::mat4& getView() const { return viewMatrix; }
 	const glm::mat4& getInverseView() const { return inverseViewMatrix; }
 	const glm::vec3 getPosition() const { return glm::vec3(inverseViewMatrix[3]); }
+	// world space planes of projection * view
+	LveFrustum getFrustum() const { return LveFrustum::fromMatrix(projectionMatrix * viewMatrix); }
 	
  private:
 	glm::mat4 projectionMatrix{1.f};
@@ -0,0 +1,120 @@
+#include "lve_command_recorder.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace lve {
+
+void LveCommandRecorder::begin(VkCommandBuffer commandBuffer) {
+	this->commandBuffer = commandBuffer;
+	stats = Stats{};
+	invalidate();
+}
+
+void LveCommandRecorder::invalidate() {
+	boundPipeline = VK_NULL_HANDLE;
+	descriptorSetsValid = false;
+	std::fill(std::begin(vertexBuffers), std::end(vertexBuffers), VK_NULL_HANDLE);
+	indexBuffer = VK_NULL_HANDLE;
+	pushConstantsValid = false;
+}
+
+void LveCommandRecorder::bindPipeline(VkPipeline pipeline) {
+	assert(commandBuffer != VK_NULL_HANDLE && "Can't record before begin");
+	if (pipeline == boundPipeline) {
+		count(BindPipeline, false);
+		return;
+	}
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	boundPipeline = pipeline;
+	pushConstantsValid = false;
+	count(BindPipeline, true);
+}
+
+void LveCommandRecorder::bindDescriptorSets(
+	VkPipelineLayout layout,
+	uint32_t firstSet,
+	uint32_t setCount,
+	const VkDescriptorSet *sets,
+	uint32_t dynamicOffsetCount,
+	const uint32_t *dynamicOffsets) {
+	assert(commandBuffer != VK_NULL_HANDLE && "Can't record before begin");
+	if (descriptorSetsValid && layout == descriptorSetLayout && firstSet == firstDescriptorSet &&
+			setCount == descriptorSetCount && dynamicOffsetCount == this->dynamicOffsetCount &&
+			std::equal(sets, sets + setCount, descriptorSets) &&
+			std::equal(dynamicOffsets, dynamicOffsets + dynamicOffsetCount, this->dynamicOffsets)) {
+		count(BindDescriptorSets, false);
+		return;
+	}
+
+	vkCmdBindDescriptorSets(
+		commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+	count(BindDescriptorSets, true);
+
+	// calls that don't fit aren't tracked, and nothing repeats them
+	descriptorSetsValid = setCount <= MAX_DESCRIPTOR_SETS && dynamicOffsetCount <= MAX_DYNAMIC_OFFSETS;
+	if (!descriptorSetsValid) return;
+	descriptorSetLayout = layout;
+	firstDescriptorSet = firstSet;
+	descriptorSetCount = setCount;
+	std::copy(sets, sets + setCount, descriptorSets);
+	this->dynamicOffsetCount = dynamicOffsetCount;
+	std::copy(dynamicOffsets, dynamicOffsets + dynamicOffsetCount, this->dynamicOffsets);
+}
+
+void LveCommandRecorder::bindVertexBuffers(
+	uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *buffers, const VkDeviceSize *offsets) {
+	assert(commandBuffer != VK_NULL_HANDLE && "Can't record before begin");
+	bool bound = firstBinding + bindingCount <= MAX_VERTEX_BINDINGS;
+	for (uint32_t i = 0; bound && i < bindingCount; i++) {
+		bound = vertexBuffers[firstBinding + i] == buffers[i] && vertexBufferOffsets[firstBinding + i] == offsets[i];
+	}
+	if (bound) {
+		count(BindVertexBuffers, false);
+		return;
+	}
+
+	vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, buffers, offsets);
+	count(BindVertexBuffers, true);
+	for (uint32_t i = 0; i < bindingCount && firstBinding + i < MAX_VERTEX_BINDINGS; i++) {
+		vertexBuffers[firstBinding + i] = buffers[i];
+		vertexBufferOffsets[firstBinding + i] = offsets[i];
+	}
+}
+
+void LveCommandRecorder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+	assert(commandBuffer != VK_NULL_HANDLE && "Can't record before begin");
+	if (buffer == indexBuffer && offset == indexBufferOffset && indexType == this->indexType) {
+		count(BindIndexBuffer, false);
+		return;
+	}
+	vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+	indexBuffer = buffer;
+	indexBufferOffset = offset;
+	this->indexType = indexType;
+	count(BindIndexBuffer, true);
+}
+
+void LveCommandRecorder::pushConstants(
+	VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *values) {
+	assert(commandBuffer != VK_NULL_HANDLE && "Can't record before begin");
+	if (pushConstantsValid && layout == pushConstantLayout && stages == pushConstantStages &&
+			offset == pushConstantOffset && size == pushConstantSize && std::memcmp(values, pushConstantData, size) == 0) {
+		count(PushConstants, false);
+		return;
+	}
+
+	vkCmdPushConstants(commandBuffer, layout, stages, offset, size, values);
+	count(PushConstants, true);
+
+	pushConstantsValid = size <= MAX_PUSH_CONSTANT_SIZE;
+	if (!pushConstantsValid) return;
+	pushConstantLayout = layout;
+	pushConstantStages = stages;
+	pushConstantOffset = offset;
+	pushConstantSize = size;
+	std::memcpy(pushConstantData, values, size);
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <array>
+#include <cstdint>
+
+namespace lve {
+
+// Records graphics state into a frame's command buffer and drops what would bind or push what
+// is already there, so systems can bind unconditionally before every draw. Draws and anything
+// else go straight to getCommandBuffer().
+//
+// Only what went through the recorder is tracked. Code recording pushes or binds directly
+// into the command buffer has to invalidate() afterwards.
+class LveCommandRecorder {
+public:
+	enum Command {
+		BindPipeline,
+		BindDescriptorSets,
+		BindVertexBuffers,
+		BindIndexBuffer,
+		PushConstants,
+		COMMAND_COUNT
+	};
+
+	struct Stats {
+		std::array<uint32_t, COMMAND_COUNT> issued{};
+		std::array<uint32_t, COMMAND_COUNT> elided{};
+	};
+
+	static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+	static constexpr uint32_t MAX_DYNAMIC_OFFSETS = 8;
+	static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+	// the smallest maxPushConstantsSize a device may have
+	static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+
+	// starts tracking a command buffer that was just begun, and the frame's stats
+	void begin(VkCommandBuffer commandBuffer);
+	// forgets the bound state, the next bind of everything is issued
+	void invalidate();
+
+	VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+	const Stats &getStats() const { return stats; }
+
+	void bindPipeline(VkPipeline pipeline);
+	// dropped when it repeats the previous call exactly
+	void bindDescriptorSets(
+		VkPipelineLayout layout,
+		uint32_t firstSet,
+		uint32_t setCount,
+		const VkDescriptorSet *sets,
+		uint32_t dynamicOffsetCount = 0,
+		const uint32_t *dynamicOffsets = nullptr);
+	void bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *buffers, const VkDeviceSize *offsets);
+	void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	// Dropped when it repeats the bytes last pushed to the same range of the same layout.
+	// Binding another pipeline forgets the pushed values, they may not survive it.
+	void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *values);
+
+private:
+	void count(Command command, bool issue) { (issue ? stats.issued : stats.elided)[command]++; }
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	Stats stats{};
+
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+
+	bool descriptorSetsValid = false;
+	VkPipelineLayout descriptorSetLayout = VK_NULL_HANDLE;
+	uint32_t firstDescriptorSet = 0;
+	uint32_t descriptorSetCount = 0;
+	VkDescriptorSet descriptorSets[MAX_DESCRIPTOR_SETS];
+	uint32_t dynamicOffsetCount = 0;
+	uint32_t dynamicOffsets[MAX_DYNAMIC_OFFSETS];
+
+	// VK_NULL_HANDLE where unknown
+	VkBuffer vertexBuffers[MAX_VERTEX_BINDINGS];
+	VkDeviceSize vertexBufferOffsets[MAX_VERTEX_BINDINGS];
+
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceSize indexBufferOffset = 0;
+	VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+
+	bool pushConstantsValid = false;
+	VkPipelineLayout pushConstantLayout = VK_NULL_HANDLE;
+	VkShaderStageFlags pushConstantStages = 0;
+	uint32_t pushConstantOffset = 0;
+	uint32_t pushConstantSize = 0;
+	uint8_t pushConstantData[MAX_PUSH_CONSTANT_SIZE];
+};
+
+}
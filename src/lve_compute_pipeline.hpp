@@ -0,0 +1,31 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "vulkan/vulkan_core.h"
+
+#include <string>
+
+namespace lve {
+
+// Compute counterpart of LvePipeline, the layout belongs to the caller
+class LveComputePipeline {
+public:
+	LveComputePipeline(
+		LveDevice& device,
+		const std::string& compFilePath,
+		VkPipelineLayout pipelineLayout,
+		const VkSpecializationInfo* specializationInfo = nullptr);
+	~LveComputePipeline();
+
+	LveComputePipeline(const LveComputePipeline&) = delete;
+	LveComputePipeline& operator=(const LveComputePipeline&) = delete;
+
+	void bind(VkCommandBuffer commandBuffer);
+
+private:
+	LveDevice& lveDevice;
+	VkPipeline computePipeline;
+	VkShaderModule compShaderModule;
+};
+
+}
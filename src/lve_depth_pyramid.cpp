@@ -0,0 +1,273 @@
+#include "lve_depth_pyramid.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+// enough for a 32768 texel wide level 0
+constexpr uint32_t MAX_MIP_LEVELS = 16;
+constexpr uint32_t WORKGROUP_SIZE = 8;
+
+struct DepthPyramidPushConstants {
+	int32_t sourceSize[2];
+	int32_t destinationSize[2];
+};
+
+uint32_t previousPowerOfTwo(uint32_t value) {
+	uint32_t result = 1;
+	while (result <= value / 2) result *= 2;
+	return result;
+}
+
+bool hasStencilComponent(VkFormat format) {
+	return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+}
+
+}  // namespace
+
+LveDepthPyramid::LveDepthPyramid(LveDevice& device, VkExtent2D depthExtent) : lveDevice{device} {
+	createPipeline();
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.minLod = 0.f;
+	samplerInfo.maxLod = static_cast<float>(MAX_MIP_LEVELS);
+	if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create depth pyramid sampler!");
+	}
+
+	createResources(depthExtent);
+}
+
+LveDepthPyramid::~LveDepthPyramid() {
+	destroyResources();
+	vkDestroySampler(lveDevice.device(), sampler, nullptr);
+	vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+}
+
+void LveDepthPyramid::createPipeline() {
+	const uint32_t setCount = LveSwapChain::MAX_FRAMES_IN_FLIGHT + MAX_MIP_LEVELS;
+	setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+		.build();
+	descriptorPool = LveDescriptorPool::Builder(lveDevice)
+		.setMaxSets(setCount)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount)
+		.build();
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(DepthPyramidPushConstants);
+
+	VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	pipeline = std::make_unique<LveComputePipeline>(lveDevice, "shaders/depth_pyramid.comp.spv", pipelineLayout);
+}
+
+void LveDepthPyramid::createResources(VkExtent2D depthExtent) {
+	this->depthExtent = depthExtent;
+	extent.width = previousPowerOfTwo(depthExtent.width);
+	extent.height = previousPowerOfTwo(depthExtent.height);
+	mipLevels = 1;
+	while ((std::max(extent.width, extent.height) >> mipLevels) > 0) mipLevels++;
+	mipLevels = std::min(mipLevels, MAX_MIP_LEVELS);
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = extent.width;
+	imageInfo.extent.height = extent.height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = VK_FORMAT_R32_SFLOAT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.flags = 0;
+	lveDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory, LveMemoryCategory::Depth);
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = VK_FORMAT_R32_SFLOAT;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+	if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create depth pyramid image view!");
+	}
+
+	mipViews.resize(mipLevels);
+	for (uint32_t level = 0; level < mipLevels; level++) {
+		viewInfo.subresourceRange.baseMipLevel = level;
+		viewInfo.subresourceRange.levelCount = 1;
+		if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &mipViews[level]) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create depth pyramid image view!");
+		}
+	}
+
+	// binding 0 of the level 0 sets is the depth attachment, written by build()
+	VkDescriptorImageInfo levelZeroInfo{VK_NULL_HANDLE, mipViews[0], VK_IMAGE_LAYOUT_GENERAL};
+	for (auto& set : depthDescriptorSets) {
+		if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), set)) {
+			throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+		}
+		LveDescriptorWriter(*setLayout, *descriptorPool).writeImage(1, &levelZeroInfo).overwrite(set);
+	}
+	mipDescriptorSets.resize(mipLevels, VK_NULL_HANDLE);
+	for (uint32_t level = 1; level < mipLevels; level++) {
+		VkDescriptorImageInfo sourceInfo{sampler, mipViews[level - 1], VK_IMAGE_LAYOUT_GENERAL};
+		VkDescriptorImageInfo destinationInfo{VK_NULL_HANDLE, mipViews[level], VK_IMAGE_LAYOUT_GENERAL};
+		if (!LveDescriptorWriter(*setLayout, *descriptorPool)
+				.writeImage(0, &sourceInfo)
+				.writeImage(1, &destinationInfo)
+				.build(mipDescriptorSets[level])) {
+			throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+		}
+	}
+
+	// cleared to the far plane, culling against a pyramid that was never built hides nothing
+	VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+	vkCmdPipelineBarrier(
+		commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkClearColorValue farPlane{};
+	farPlane.float32[0] = 1.f;
+	vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &farPlane, 1, &barrier.subresourceRange);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	vkCmdPipelineBarrier(
+		commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	lveDevice.endSingleTimeCommands(commandBuffer);
+}
+
+void LveDepthPyramid::destroyResources() {
+	descriptorPool->resetPool();
+	mipDescriptorSets.clear();
+	for (VkImageView view : mipViews) {
+		vkDestroyImageView(lveDevice.device(), view, nullptr);
+	}
+	mipViews.clear();
+	vkDestroyImageView(lveDevice.device(), imageView, nullptr);
+	vkDestroyImage(lveDevice.device(), image, nullptr);
+	lveDevice.freeMemory(imageMemory);
+	imageView = VK_NULL_HANDLE;
+	image = VK_NULL_HANDLE;
+}
+
+void LveDepthPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, const LveDepthAttachment& depth) {
+	if (depth.extent.width != depthExtent.width || depth.extent.height != depthExtent.height) {
+		// the swap chain was recreated, earlier frames may still sample the old pyramid
+		vkDeviceWaitIdle(lveDevice.device());
+		destroyResources();
+		createResources(depth.extent);
+	}
+
+	VkImageMemoryBarrier barriers[2]{};
+	barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[0].image = depth.image;
+	barriers[0].subresourceRange.aspectMask =
+		VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencilComponent(depth.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+	barriers[0].subresourceRange.levelCount = 1;
+	barriers[0].subresourceRange.layerCount = 1;
+
+	// the last culling pass is done reading before the pyramid is overwritten
+	barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barriers[1].image = image;
+	barriers[1].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr, 2, barriers);
+
+	VkDescriptorImageInfo depthInfo{sampler, depth.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	LveDescriptorWriter(*setLayout, *descriptorPool).writeImage(0, &depthInfo).overwrite(depthDescriptorSets[frameIndex]);
+
+	pipeline->bind(commandBuffer);
+	VkExtent2D sourceExtent = depth.extent;
+	for (uint32_t level = 0; level < mipLevels; level++) {
+		VkExtent2D levelExtent{std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u)};
+		VkDescriptorSet descriptorSet = level == 0 ? depthDescriptorSets[frameIndex] : mipDescriptorSets[level];
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+		DepthPyramidPushConstants push{};
+		push.sourceSize[0] = static_cast<int32_t>(sourceExtent.width);
+		push.sourceSize[1] = static_cast<int32_t>(sourceExtent.height);
+		push.destinationSize[0] = static_cast<int32_t>(levelExtent.width);
+		push.destinationSize[1] = static_cast<int32_t>(levelExtent.height);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidPushConstants), &push);
+		vkCmdDispatch(
+			commandBuffer,
+			(levelExtent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+			(levelExtent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+			1);
+
+		// the next level reads this one, and the culling pass of the next frame reads all of them
+		VkImageMemoryBarrier levelBarrier = barriers[1];
+		levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		levelBarrier.subresourceRange.baseMipLevel = level;
+		levelBarrier.subresourceRange.levelCount = 1;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &levelBarrier);
+		sourceExtent = levelExtent;
+	}
+}
+
+}
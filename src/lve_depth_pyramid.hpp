@@ -0,0 +1,65 @@
+#pragma once
+
+#include "lve_compute_pipeline.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+#include "vulkan/vulkan_core.h"
+
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+// Mip chain of the farthest depth of a depth attachment, for occlusion culling. Level 0 is
+// the largest power of two that fits the attachment, every texel of every level holds the
+// farthest depth of the area it covers, so anything whose nearest depth lies behind the
+// texels under its screen bounds is hidden. Two texels of the level where its bounds shrink
+// to a texel cover it.
+//
+// Lives in VK_IMAGE_LAYOUT_GENERAL, built and read by compute shaders on the graphics queue.
+class LveDepthPyramid {
+public:
+	LveDepthPyramid(LveDevice& device, VkExtent2D depthExtent);
+	~LveDepthPyramid();
+
+	LveDepthPyramid(const LveDepthPyramid&) = delete;
+	LveDepthPyramid& operator=(const LveDepthPyramid&) = delete;
+
+	// Records the build from a depth attachment whose render pass has ended, leaves it in
+	// SHADER_READ_ONLY_OPTIMAL. Recreates the pyramid (waiting for the device) when the
+	// attachment changed size.
+	void build(VkCommandBuffer commandBuffer, int frameIndex, const LveDepthAttachment& depth);
+
+	VkImageView getImageView() const { return imageView; }
+	VkSampler getSampler() const { return sampler; }
+	VkExtent2D getExtent() const { return extent; }
+	uint32_t getMipLevels() const { return mipLevels; }
+
+private:
+	void createPipeline();
+	void createResources(VkExtent2D depthExtent);
+	void destroyResources();
+
+	LveDevice& lveDevice;
+
+	std::unique_ptr<LveDescriptorSetLayout> setLayout;
+	std::unique_ptr<LveDescriptorPool> descriptorPool;
+	VkPipelineLayout pipelineLayout;
+	std::unique_ptr<LveComputePipeline> pipeline;
+	VkSampler sampler;
+
+	VkExtent2D depthExtent{0, 0};
+	VkExtent2D extent{0, 0};
+	uint32_t mipLevels = 0;
+	VkImage image = VK_NULL_HANDLE;
+	LveMemoryAllocation imageMemory{};
+	VkImageView imageView = VK_NULL_HANDLE;
+	std::vector<VkImageView> mipViews;
+	// set i reduces level i - 1 into level i, set 0 is unused
+	std::vector<VkDescriptorSet> mipDescriptorSets;
+	// reduce the depth attachment into level 0, rewritten by every frame
+	VkDescriptorSet depthDescriptorSets[LveSwapChain::MAX_FRAMES_IN_FLIGHT];
+};
+
+}
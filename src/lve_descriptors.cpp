@@ -5,6 +5,15 @@
 
 namespace lve {
 
+namespace {
+
+bool isDynamicBuffer(VkDescriptorType descriptorType) {
+  return descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+         descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+}
+
+}  // namespace
+
 // *************** Descriptor Set Layout Builder *********************
 
 LveDescriptorSetLayout::Builder &LveDescriptorSetLayout::Builder::addBinding(
@@ -34,6 +43,9 @@ LveDescriptorSetLayout::LveDescriptorSetLayout(
   std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
   for (auto kv : bindings) {
     setLayoutBindings.push_back(kv.second);
+    if (isDynamicBuffer(kv.second.descriptorType)) {
+      dynamicOffsetCount += kv.second.descriptorCount;
+    }
   }
 
   VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
@@ -143,6 +155,10 @@ LveDescriptorWriter &LveDescriptorWriter::writeBuffer(
   assert(
       bindingDescription.descriptorCount == 1 &&
       "Binding single descriptor info, but binding expects multiple");
+  // the dynamic offset moves the range around the buffer, it can't be the whole buffer
+  assert(
+      (!isDynamicBuffer(bindingDescription.descriptorType) || bufferInfo->range != VK_WHOLE_SIZE) &&
+      "Dynamic buffer bindings need the range of a single element");
 
   VkWriteDescriptorSet write{};
   write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
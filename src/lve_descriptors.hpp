@@ -33,11 +33,14 @@ class LveDescriptorSetLayout {
   LveDescriptorSetLayout &operator=(const LveDescriptorSetLayout &) = delete;
 
   VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+  // number of offsets vkCmdBindDescriptorSets expects for this layout, ordered by binding
+  uint32_t getDynamicOffsetCount() const { return dynamicOffsetCount; }
 
  private:
   LveDevice &lveDevice;
   VkDescriptorSetLayout descriptorSetLayout;
   std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
+  uint32_t dynamicOffsetCount = 0;
 
   friend class LveDescriptorWriter;
 };
@@ -1,7 +1,10 @@
 #include "lve_device.hpp"
+#include "lve_upload_batch.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -53,10 +56,19 @@ LveDevice::LveDevice(LveWindow &window) : window{window} {
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
+  memoryAllocator = std::make_unique<LveMemoryAllocator>(device_, physicalDevice);
+  hostVisibleDeviceLocalMemory = findHostVisibleDeviceLocalMemory();
   createCommandPool();
+  uploadBatch = std::make_unique<LveUploadBatch>(*this);
 }
 
 LveDevice::~LveDevice() {
+  // waits for uploads still in flight
+  uploadBatch.reset();
+  memoryAllocator.reset();
+  if (transferCommandPool != commandPool) {
+    vkDestroyCommandPool(device_, transferCommandPool, nullptr);
+  }
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -86,6 +98,19 @@ void LveDevice::createInstance() {
   createInfo.pApplicationInfo = &appInfo;
 
   auto extensions = getRequiredExtensions();
+
+  // optional, VK_EXT_memory_budget needs it on a Vulkan 1.0 instance
+  uint32_t availableCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, nullptr);
+  std::vector<VkExtensionProperties> availableExtensions(availableCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, availableExtensions.data());
+  for (const auto &extension : availableExtensions) {
+    if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+      extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+      physicalDeviceProperties2Enabled = true;
+    }
+  }
+
   createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
   createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -138,6 +163,9 @@ void LveDevice::createLogicalDevice() {
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
   std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  if (indices.transferFamilyHasValue) {
+    uniqueQueueFamilies.insert(indices.transferFamily);
+  }
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -149,8 +177,15 @@ void LveDevice::createLogicalDevice() {
     queueCreateInfos.push_back(queueCreateInfo);
   }
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // optional, indirect draws fall back to one command per call or to direct draws without them
+  deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+  deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+  enabledFeatures = deviceFeatures;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -159,8 +194,18 @@ void LveDevice::createLogicalDevice() {
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  std::vector<const char *> enabledExtensions = deviceExtensions;
+  memoryBudgetEnabled = physicalDeviceProperties2Enabled &&
+                        checkDeviceExtensionSupport(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  if (memoryBudgetEnabled) {
+    enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+  drawIndirectCountEnabled = checkDeviceExtensionSupport(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+  if (drawIndirectCountEnabled) {
+    enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+  }
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -175,22 +220,44 @@ void LveDevice::createLogicalDevice() {
     throw std::runtime_error("failed to create logical device!");
   }
 
+  if (memoryBudgetEnabled) {
+    getPhysicalDeviceMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(
+        instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+    memoryBudgetEnabled = getPhysicalDeviceMemoryProperties2 != nullptr;
+  }
+  if (drawIndirectCountEnabled) {
+    drawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(
+        device_, "vkCmdDrawIndexedIndirectCountKHR");
+    drawIndirectCountEnabled = drawIndexedIndirectCount != nullptr;
+  }
+
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+  // without a transfer only family uploads share the graphics queue
+  graphicsQueueFamily_ = indices.graphicsFamily;
+  transferQueueFamily_ = indices.transferFamilyHasValue ? indices.transferFamily : indices.graphicsFamily;
+  vkGetDeviceQueue(device_, transferQueueFamily_, 0, &transferQueue_);
 }
 
 void LveDevice::createCommandPool() {
-  QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
-
   VkCommandPoolCreateInfo poolInfo = {};
   poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-  poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+  poolInfo.queueFamilyIndex = graphicsQueueFamily_;
   poolInfo.flags =
       VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
   if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
+
+  transferCommandPool = commandPool;
+  if (hasDedicatedTransferQueue()) {
+    poolInfo.queueFamilyIndex = transferQueueFamily_;
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create transfer command pool!");
+    }
+  }
 }
 
 void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
@@ -317,6 +384,25 @@ bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device, const char *extensionName) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      device,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (strcmp(extension.extensionName, extensionName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -328,18 +414,24 @@ QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
 
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      indices.graphicsFamily = i;
-      indices.graphicsFamilyHasValue = true;
-    }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
-      indices.presentFamily = i;
-      indices.presentFamilyHasValue = true;
+    // keep scanning past the graphics/present families, transfer only ones tend to come last
+    if (!indices.isComplete()) {
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        indices.graphicsFamily = i;
+        indices.graphicsFamilyHasValue = true;
+      }
+      VkBool32 presentSupport = false;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      if (queueFamily.queueCount > 0 && presentSupport) {
+        indices.presentFamily = i;
+        indices.presentFamilyHasValue = true;
+      }
     }
-    if (indices.isComplete()) {
-      break;
+    if (!indices.transferFamilyHasValue && queueFamily.queueCount > 0 &&
+        (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+        !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+      indices.transferFamily = i;
+      indices.transferFamilyHasValue = true;
     }
 
     i++;
@@ -403,12 +495,34 @@ uint32_t LveDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags pr
   throw std::runtime_error("failed to find suitable memory type!");
 }
 
+bool LveDevice::findHostVisibleDeviceLocalMemory() {
+  const VkPhysicalDeviceMemoryProperties &memProperties = memoryAllocator->getMemoryProperties();
+  VkDeviceSize largestDeviceLocalHeap = 0;
+  for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+    if (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+      largestDeviceLocalHeap = std::max(largestDeviceLocalHeap, memProperties.memoryHeaps[i].size);
+    }
+  }
+
+  const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  // the first matching type is the one findMemoryType picks for these properties
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if ((memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return memProperties.memoryHeaps[memProperties.memoryTypes[i].heapIndex].size >= largestDeviceLocalHeap;
+    }
+  }
+  return false;
+}
+
 void LveDevice::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    LveMemoryAllocation &bufferMemory,
+    LveMemoryCategory category) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -422,16 +536,14 @@ void LveDevice::createBuffer(
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  bufferMemory = memoryAllocator->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      LveMemoryAllocator::ResourceKind::Buffer,
+      category);
+  checkMemoryBudget(bufferMemory.memoryTypeIndex);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
-  }
-
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+  vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
 VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -466,12 +578,12 @@ void LveDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
-void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset) {
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
   VkBufferCopy copyRegion{};
   copyRegion.srcOffset = 0;  // Optional
-  copyRegion.dstOffset = 0;  // Optional
+  copyRegion.dstOffset = dstOffset;
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -509,7 +621,8 @@ void LveDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    LveMemoryAllocation &imageMemory,
+    LveMemoryCategory category) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,18 +630,90 @@ void LveDevice::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  // linear images are laid out like buffers and may share their blocks
+  imageMemory = memoryAllocator->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? LveMemoryAllocator::ResourceKind::Buffer
+                                                 : LveMemoryAllocator::ResourceKind::Image,
+      category);
+  checkMemoryBudget(imageMemory.memoryTypeIndex);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
+  if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
+    throw std::runtime_error("failed to bind image memory!");
   }
+}
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
-    throw std::runtime_error("failed to bind image memory!");
+void LveDevice::freeMemory(LveMemoryAllocation &memory) { memoryAllocator->free(memory); }
+
+std::vector<MemoryHeapBudget> LveDevice::getMemoryBudget() {
+  const VkPhysicalDeviceMemoryProperties &memProperties = memoryAllocator->getMemoryProperties();
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  if (memoryBudgetEnabled) {
+    VkPhysicalDeviceMemoryProperties2KHR memProperties2{};
+    memProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memProperties2.pNext = &budgetProperties;
+    getPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties2);
+  }
+
+  std::vector<MemoryHeapBudget> budgets(memProperties.memoryHeapCount);
+  for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+    budgets[i].size = memProperties.memoryHeaps[i].size;
+    if (memoryBudgetEnabled) {
+      budgets[i].budget = budgetProperties.heapBudget[i];
+      budgets[i].usage = budgetProperties.heapUsage[i];
+    } else {
+      budgets[i].budget = memProperties.memoryHeaps[i].size;
+      budgets[i].usage = memoryAllocator->getHeapAllocatedSize(i);
+    }
+  }
+  return budgets;
+}
+
+void LveDevice::printMemoryReport(std::ostream &out) {
+  const VkPhysicalDeviceMemoryProperties &memProperties = memoryAllocator->getMemoryProperties();
+  auto budgets = getMemoryBudget();
+  auto mib = [](VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+  std::ios_base::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(1);
+  out << "memory report" << (memoryBudgetEnabled ? "" : " (no VK_EXT_memory_budget)") << ":" << std::endl;
+  for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+    bool deviceLocal = memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    out << "\theap " << i << (deviceLocal ? " (device local)" : " (host)") << ": " << mib(budgets[i].usage)
+        << " / " << mib(budgets[i].budget) << " MiB budget, " << mib(budgets[i].size) << " MiB heap, "
+        << mib(memoryAllocator->getHeapAllocatedSize(i)) << " MiB allocated by the engine" << std::endl;
+    for (uint32_t c = 0; c < LVE_MEMORY_CATEGORY_COUNT; c++) {
+      auto category = static_cast<LveMemoryCategory>(c);
+      VkDeviceSize used = memoryAllocator->getHeapUsedSize(i, category);
+      if (used > 0) {
+        out << "\t\t" << memoryCategoryName(category) << ": " << mib(used) << " MiB" << std::endl;
+      }
+    }
+  }
+  out.flags(flags);
+}
+
+void LveDevice::checkMemoryBudget(uint32_t memoryTypeIndex) {
+  uint32_t heapIndex = memoryAllocator->getMemoryProperties().memoryTypes[memoryTypeIndex].heapIndex;
+
+  // usage only moves when the allocator went to the driver, sub-allocations don't need a query
+  VkDeviceSize allocated = memoryAllocator->getHeapAllocatedSize(heapIndex);
+  if (allocated == checkedHeapSizes[heapIndex]) {
+    return;
+  }
+  checkedHeapSizes[heapIndex] = allocated;
+
+  MemoryHeapBudget budget = getMemoryBudget()[heapIndex];
+  bool overBudget = budget.usage > static_cast<VkDeviceSize>(memoryBudgetThreshold * budget.budget);
+  if (overBudget && !heapsOverBudget[heapIndex]) {
+    std::cerr << "memory heap " << heapIndex << " is above " << memoryBudgetThreshold * 100.f
+              << "% of its budget" << std::endl;
+    printMemoryReport(std::cerr);
   }
+  heapsOverBudget[heapIndex] = overBudget;
 }
 
 }  // namespace lve
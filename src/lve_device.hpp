@@ -1,24 +1,38 @@
 #pragma once
 
+#include "lve_memory_allocator.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <cassert>
+#include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+class LveUploadBatch;
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
   std::vector<VkPresentModeKHR> presentModes;
 };
 
+struct MemoryHeapBudget {
+  VkDeviceSize size;
+  VkDeviceSize budget;  // the heap size without VK_EXT_memory_budget
+  VkDeviceSize usage;   // only what LveMemoryAllocator allocated without VK_EXT_memory_budget
+};
+
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  uint32_t transferFamily;  // transfer only (no graphics or compute), usually a DMA engine
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
@@ -44,6 +58,40 @@ class LveDevice {
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // the graphics queue and command pool when there is no dedicated transfer queue family
+  VkQueue transferQueue() { return transferQueue_; }
+  VkCommandPool getTransferCommandPool() { return transferCommandPool; }
+  bool hasDedicatedTransferQueue() const { return transferQueueFamily_ != graphicsQueueFamily_; }
+  uint32_t graphicsQueueFamily() const { return graphicsQueueFamily_; }
+  uint32_t transferQueueFamily() const { return transferQueueFamily_; }
+  // staged uploads to device local buffers, see LveUploadBatch
+  LveUploadBatch &getUploadBatch() { return *uploadBatch; }
+  // device memory for buffers and images, see LveMemoryAllocator
+  LveMemoryAllocator &getMemoryAllocator() { return *memoryAllocator; }
+  bool hasMemoryBudget() const { return memoryBudgetEnabled; }
+  const VkPhysicalDeviceFeatures &getEnabledFeatures() const { return enabledFeatures; }
+  // VK_KHR_draw_indirect_count, the draw count of indirect draws can come from a buffer
+  bool hasDrawIndirectCount() const { return drawIndirectCountEnabled; }
+  void cmdDrawIndexedIndirectCount(
+      VkCommandBuffer commandBuffer,
+      VkBuffer buffer,
+      VkDeviceSize offset,
+      VkBuffer countBuffer,
+      VkDeviceSize countBufferOffset,
+      uint32_t maxDrawCount,
+      uint32_t stride) {
+    assert(drawIndirectCountEnabled && "VK_KHR_draw_indirect_count is not enabled");
+    drawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
+  }
+  // Device local memory the host can write to directly (resizable BAR, integrated GPUs, CPU
+  // implementations), only when it spans the whole of the largest device local heap. A
+  // 256 MiB BAR window is too small to give to static data.
+  bool hasHostVisibleDeviceLocalMemory() const { return hostVisibleDeviceLocalMemory; }
+  std::vector<MemoryHeapBudget> getMemoryBudget();
+  // usage and budget of every heap, with the engine's allocations split by category
+  void printMemoryReport(std::ostream &out);
+  // the report goes to stderr when a heap's usage first goes above this fraction of its budget
+  void setMemoryBudgetThreshold(float fraction) { memoryBudgetThreshold = fraction; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -57,10 +105,11 @@ class LveDevice {
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveMemoryAllocation &bufferMemory,
+      LveMemoryCategory category = LveMemoryCategory::Other);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -68,7 +117,10 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveMemoryAllocation &imageMemory,
+      LveMemoryCategory category = LveMemoryCategory::Other);
+  // returns memory from createBuffer or createImageWithInfo, after the resource is destroyed
+  void freeMemory(LveMemoryAllocation &memory);
 
   VkPhysicalDeviceProperties properties;
 
@@ -89,17 +141,37 @@ class LveDevice {
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+  bool checkDeviceExtensionSupport(VkPhysicalDevice device, const char *extensionName);
+  void checkMemoryBudget(uint32_t memoryTypeIndex);
+  bool findHostVisibleDeviceLocalMemory();
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
   LveWindow &window;
   VkCommandPool commandPool;
+  VkCommandPool transferCommandPool;
 
   VkDevice device_;
+  VkPhysicalDeviceFeatures enabledFeatures{};
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  uint32_t graphicsQueueFamily_;
+  uint32_t transferQueueFamily_;
+
+  std::unique_ptr<LveMemoryAllocator> memoryAllocator;
+  bool physicalDeviceProperties2Enabled = false;
+  bool memoryBudgetEnabled = false;
+  bool hostVisibleDeviceLocalMemory = false;
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR getPhysicalDeviceMemoryProperties2 = nullptr;
+  bool drawIndirectCountEnabled = false;
+  PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+  float memoryBudgetThreshold = 0.9f;
+  VkDeviceSize checkedHeapSizes[VK_MAX_MEMORY_HEAPS] = {};
+  bool heapsOverBudget[VK_MAX_MEMORY_HEAPS] = {};
+  std::unique_ptr<LveUploadBatch> uploadBatch;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
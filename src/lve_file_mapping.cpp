@@ -0,0 +1,78 @@
+#include "lve_file_mapping.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lve {
+
+#ifdef _WIN32
+
+LveFileMapping::LveFileMapping(const std::string &filepath) {
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		return;
+	}
+	fileSize = static_cast<size_t>(size.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		return;
+	}
+	mappingHandle = mapping;
+
+	mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+}
+
+LveFileMapping::~LveFileMapping() {
+	if (mapped) UnmapViewOfFile(mapped);
+	if (mappingHandle) CloseHandle(mappingHandle);
+	if (fileHandle) CloseHandle(fileHandle);
+}
+
+#else
+
+LveFileMapping::LveFileMapping(const std::string &filepath) {
+	int fd = open(filepath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return;
+	}
+	fileSize = static_cast<size_t>(st.st_size);
+
+	void *ptr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping keeps its own reference to the file
+	close(fd);
+	if (ptr == MAP_FAILED) {
+		return;
+	}
+
+	madvise(ptr, fileSize, MADV_SEQUENTIAL);
+	mapped = ptr;
+}
+
+LveFileMapping::~LveFileMapping() {
+	if (mapped) munmap(mapped, fileSize);
+}
+
+#endif
+
+}
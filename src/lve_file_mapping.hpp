@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace lve {
+
+// Read-only memory mapping of a whole file. The mapping stays valid for the lifetime
+// of the object, so pointers handed out by data() must not outlive it.
+class LveFileMapping {
+public:
+	explicit LveFileMapping(const std::string &filepath);
+	~LveFileMapping();
+
+	LveFileMapping(const LveFileMapping &) = delete;
+	LveFileMapping &operator=(const LveFileMapping &) = delete;
+
+	bool isValid() const { return mapped != nullptr; }
+	const char *data() const { return static_cast<const char *>(mapped); }
+	size_t size() const { return fileSize; }
+
+private:
+	void *mapped = nullptr;
+	size_t fileSize = 0;
+
+#ifdef _WIN32
+	void *fileHandle = nullptr;
+	void *mappingHandle = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,79 @@
+#include "lve_frame_allocator.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+LveFrameAllocator::LveFrameAllocator(LveDevice &device, VkDeviceSize frameSize) {
+	const VkPhysicalDeviceLimits &limits = device.properties.limits;
+	minAlignment = std::max<VkDeviceSize>(
+		{limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 1});
+
+	// regions start on whole atoms, flushing one frame's writes never reaches into another
+	// frame's region the device may be reading
+	VkDeviceSize regionAlignment = std::max<VkDeviceSize>({minAlignment, limits.nonCoherentAtomSize, 1});
+	this->frameSize = (frameSize + regionAlignment - 1) / regionAlignment * regionAlignment;
+
+	buffer = std::make_unique<LveBuffer>(
+		device,
+		this->frameSize,
+		LveSwapChain::MAX_FRAMES_IN_FLIGHT,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		1,
+		LveMemoryCategory::Uniforms);
+	buffer->map();
+}
+
+void LveFrameAllocator::beginFrame(int frameIndex) {
+	assert(!frameStarted && "Can't call beginFrame while already in progress");
+	assert(frameIndex >= 0 && frameIndex < LveSwapChain::MAX_FRAMES_IN_FLIGHT && "Frame index out of range");
+	frameStarted = true;
+	frameBegin = frameSize * static_cast<VkDeviceSize>(frameIndex);
+	head = frameBegin;
+}
+
+void LveFrameAllocator::endFrame() {
+	assert(frameStarted && "Can't call endFrame while frame is not in progress");
+	frameStarted = false;
+	if (head > frameBegin) {
+		buffer->flush(head - frameBegin, frameBegin);
+	}
+}
+
+LveFrameAllocator::Allocation LveFrameAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+	assert(frameStarted && "Can't allocate frame memory outside of a frame");
+	assert(size > 0 && "Cannot allocate an empty range");
+	if (alignment == 0) {
+		alignment = minAlignment;
+	}
+
+	// aligned within the whole buffer, so e.g. offset / stride is an element index into it
+	VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+	if (offset + size > frameBegin + frameSize) {
+		throw std::runtime_error("failed to allocate frame memory, frame size exceeded!");
+	}
+	assert(offset % alignment == 0 && offset >= head && "Offset is not aligned within the buffer");
+	head = offset + size;
+	peakUsedSize = std::max(peakUsedSize, head - frameBegin);
+
+	Allocation allocation{};
+	allocation.buffer = buffer->getBuffer();
+	allocation.offset = offset;
+	allocation.size = size;
+	allocation.mapped = static_cast<char *>(buffer->getMappedMemory()) + offset;
+	return allocation;
+}
+
+LveFrameAllocator::Allocation LveFrameAllocator::upload(const void *data, VkDeviceSize size, VkDeviceSize alignment) {
+	Allocation allocation = allocate(size, alignment);
+	std::memcpy(allocation.mapped, data, size);
+	return allocation;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+#include <memory>
+
+namespace lve {
+
+// Linear allocator for data that only lives for one frame (uniforms, storage data, per draw
+// data). One persistently mapped host visible buffer is split into a region per frame in
+// flight; allocations bump a pointer through the current frame's region, and the region is
+// reused once the frame that last used it has finished on the GPU. Allocating never touches
+// Vulkan, endFrame() flushes what was written in one call.
+//
+// Driven by LveRenderer: beginFrame() runs after the swap chain waited for the frame's fence.
+class LveFrameAllocator {
+public:
+	static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 4ull << 20;
+
+	struct Allocation {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void *mapped = nullptr;
+
+		VkDescriptorBufferInfo descriptorInfo() const { return {buffer, offset, size}; }
+	};
+
+	LveFrameAllocator(LveDevice &device, VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+
+	LveFrameAllocator(const LveFrameAllocator &) = delete;
+	LveFrameAllocator &operator=(const LveFrameAllocator &) = delete;
+
+	void beginFrame(int frameIndex);
+	// makes the frame's writes visible to the device, call before submitting it
+	void endFrame();
+
+	// alignment 0 means minUniformBufferOffsetAlignment/minStorageBufferOffsetAlignment, so
+	// the range can be bound as either. Any alignment works, e.g. a vertex stride. Offsets are
+	// aligned within the whole buffer, not the frame's region, so offset / alignment indexes
+	// elements of that size from the start of the buffer (e.g. firstInstance).
+	Allocation allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+	Allocation upload(const void *data, VkDeviceSize size, VkDeviceSize alignment = 0);
+
+	VkBuffer getBuffer() const { return buffer->getBuffer(); }
+	VkDeviceSize getFrameSize() const { return frameSize; }
+	// bytes allocated in the current frame
+	VkDeviceSize getUsedSize() const { return head - frameBegin; }
+	VkDeviceSize getPeakUsedSize() const { return peakUsedSize; }
+
+private:
+	VkDeviceSize frameSize;
+	VkDeviceSize minAlignment;
+	std::unique_ptr<LveBuffer> buffer;
+
+	bool frameStarted = false;
+	VkDeviceSize frameBegin = 0;
+	VkDeviceSize head = 0;
+	VkDeviceSize peakUsedSize = 0;
+};
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "lve_camera.hpp"
+#include "lve_command_recorder.hpp"
+#include "lve_frame_allocator.hpp"
 #include "lve_game_object.hpp"
 #include <vulkan/vulkan.h>
 
@@ -28,6 +30,9 @@ struct FrameInfo {
   VkCommandBuffer commandBuffer;
   LveCamera &camera;
   VkDescriptorSet globalDescriptorSet;
+  uint32_t globalUboOffset;  // dynamic offset of this frame's GlobalUbo in the global set
   LveGameObject::Map &gameObjects;
+  LveFrameAllocator &frameAllocator;
+  LveCommandRecorder &commandRecorder;  // graphics state into commandBuffer
 };
 }
@@ -0,0 +1,70 @@
+#include "lve_free_list_allocator.hpp"
+
+#include <cassert>
+#include <iterator>
+
+namespace lve {
+
+LveFreeListAllocator::LveFreeListAllocator(VkDeviceSize capacity) : capacity{capacity} {
+	if (capacity > 0) {
+		freeBlocks.emplace(0, capacity);
+	}
+}
+
+bool LveFreeListAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+	assert(size > 0 && alignment > 0 && "Cannot allocate an empty block");
+
+	auto best = freeBlocks.end();
+	VkDeviceSize bestAligned = 0;
+	for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+		VkDeviceSize aligned = (it->first + alignment - 1) / alignment * alignment;
+		VkDeviceSize end = it->first + it->second;
+		if (aligned + size > end) continue;
+		if (best == freeBlocks.end() || it->second < best->second) {
+			best = it;
+			bestAligned = aligned;
+			if (it->second == size) break;
+		}
+	}
+	if (best == freeBlocks.end()) {
+		return false;
+	}
+
+	// alignment padding in front stays free, so does whatever is left behind the block
+	VkDeviceSize blockOffset = best->first;
+	VkDeviceSize blockEnd = best->first + best->second;
+	freeBlocks.erase(best);
+	if (bestAligned > blockOffset) {
+		freeBlocks.emplace(blockOffset, bestAligned - blockOffset);
+	}
+	if (bestAligned + size < blockEnd) {
+		freeBlocks.emplace(bestAligned + size, blockEnd - bestAligned - size);
+	}
+
+	usedSize += size;
+	offset = bestAligned;
+	return true;
+}
+
+void LveFreeListAllocator::free(VkDeviceSize offset, VkDeviceSize size) {
+	assert(offset + size <= capacity && size <= usedSize && "Freeing a block that was never allocated");
+	usedSize -= size;
+
+	auto next = freeBlocks.lower_bound(offset);
+	assert((next == freeBlocks.end() || offset + size <= next->first) && "Block overlaps a free block");
+	if (next != freeBlocks.end() && next->first == offset + size) {
+		size += next->second;
+		next = freeBlocks.erase(next);
+	}
+	if (next != freeBlocks.begin()) {
+		auto prev = std::prev(next);
+		assert(prev->first + prev->second <= offset && "Block overlaps a free block");
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
+		}
+	}
+	freeBlocks.emplace_hint(next, offset, size);
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <map>
+
+namespace lve {
+
+// Offset allocator over a fixed range [0, capacity). Free blocks are kept sorted by offset
+// and merged with their neighbours when freed, allocations take the smallest block that fits.
+// Only hands out offsets, the memory itself belongs to the caller.
+class LveFreeListAllocator {
+public:
+	explicit LveFreeListAllocator(VkDeviceSize capacity);
+
+	LveFreeListAllocator(const LveFreeListAllocator &) = delete;
+	LveFreeListAllocator &operator=(const LveFreeListAllocator &) = delete;
+
+	// alignment doesn't need to be a power of two (e.g. a vertex stride). Returns false when
+	// no free block is large enough.
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+	void free(VkDeviceSize offset, VkDeviceSize size);
+
+	VkDeviceSize getCapacity() const { return capacity; }
+	VkDeviceSize getUsedSize() const { return usedSize; }
+	size_t getFreeBlockCount() const { return freeBlocks.size(); }
+
+private:
+	VkDeviceSize capacity;
+	VkDeviceSize usedSize = 0;
+	std::map<VkDeviceSize, VkDeviceSize> freeBlocks;  // offset -> size
+};
+
+}
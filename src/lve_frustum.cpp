@@ -0,0 +1,34 @@
+#include "lve_frustum.hpp"
+
+namespace lve {
+
+LveFrustum LveFrustum::fromMatrix(const glm::mat4 &matrix) {
+	// Gribb & Hartmann with a [0, 1] depth range, glm matrices are column major
+	auto row = [&matrix](int i) { return glm::vec4{matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]}; };
+	const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+	LveFrustum frustum{};
+	frustum.planes[Left] = r3 + r0;
+	frustum.planes[Right] = r3 - r0;
+	frustum.planes[Bottom] = r3 + r1;
+	frustum.planes[Top] = r3 - r1;
+	frustum.planes[Near] = r2;
+	frustum.planes[Far] = r3 - r2;
+
+	for (auto &plane : frustum.planes) {
+		float length = glm::length(glm::vec3(plane));
+		if (length > 0.f) plane = plane / length;
+	}
+	return frustum;
+}
+
+bool LveFrustum::intersectsSphere(const glm::vec3 &center, float radius) const {
+	for (const auto &plane : planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace lve {
+
+// Six clip planes (xyz normal pointing inwards, w distance) extracted from a projection
+// matrix. Extracting from projection * view * model gives the planes in model space.
+struct LveFrustum {
+	enum Plane { Left, Right, Bottom, Top, Near, Far };
+	static constexpr int PLANE_COUNT = 6;
+
+	glm::vec4 planes[PLANE_COUNT];
+
+	static LveFrustum fromMatrix(const glm::mat4 &matrix);
+
+	bool intersectsSphere(const glm::vec3 &center, float radius) const;
+};
+
+}
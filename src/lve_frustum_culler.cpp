@@ -0,0 +1,183 @@
+#include "lve_frustum_culler.hpp"
+
+#include <cassert>
+
+// GCC and Clang build the AVX path into every x86 binary and take it once the CPU reports
+// AVX, other compilers only when the whole build targets AVX
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LVE_FRUSTUM_CULLER_AVX
+#define LVE_FRUSTUM_CULLER_AVX_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LVE_FRUSTUM_CULLER_AVX
+#define LVE_FRUSTUM_CULLER_AVX_DISPATCH
+#define LVE_FRUSTUM_CULLER_AVX_TARGET __attribute__((target("avx")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LVE_FRUSTUM_CULLER_SSE
+#endif
+
+namespace lve {
+
+namespace {
+
+// A sphere is outside once it lies behind any plane. Distances are summed in the order of
+// glm::dot and compared as "distance < -radius" like the scalar test, so every path agrees
+// with LveFrustum::intersectsSphere and NaNs end up visible. Each returns the first sphere
+// it left for the scalar loop.
+#if defined(LVE_FRUSTUM_CULLER_AVX)
+LVE_FRUSTUM_CULLER_AVX_TARGET uint32_t cullAvx(
+	const LveFrustum &frustum,
+	const float *x,
+	const float *y,
+	const float *z,
+	const float *radii,
+	uint32_t count,
+	std::vector<uint32_t> &visible) {
+	uint32_t i = 0;
+	__m256 planeX[LveFrustum::PLANE_COUNT], planeY[LveFrustum::PLANE_COUNT];
+	__m256 planeZ[LveFrustum::PLANE_COUNT], planeW[LveFrustum::PLANE_COUNT];
+	for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+		planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+	}
+	for (; i + 8 <= count; i += 8) {
+		const __m256 sx = _mm256_loadu_ps(x + i);
+		const __m256 sy = _mm256_loadu_ps(y + i);
+		const __m256 sz = _mm256_loadu_ps(z + i);
+		const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radii + i));
+		__m256 outside = _mm256_setzero_ps();
+		for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(sx, planeX[p]), _mm256_mul_ps(sy, planeY[p]));
+			distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(sz, planeZ[p])), planeW[p]);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+		}
+		int inside = ~_mm256_movemask_ps(outside) & 0xff;
+		for (uint32_t lane = 0; inside != 0; lane++, inside >>= 1) {
+			if (inside & 1) visible.push_back(i + lane);
+		}
+	}
+	return i;
+}
+
+bool cpuHasAvx() {
+#if defined(LVE_FRUSTUM_CULLER_AVX_DISPATCH)
+	// also checks that the OS saves the YMM registers
+	static const bool hasAvx = __builtin_cpu_supports("avx");
+	return hasAvx;
+#else
+	return true;
+#endif
+}
+#endif
+
+#if defined(LVE_FRUSTUM_CULLER_SSE)
+uint32_t cullSse(
+	const LveFrustum &frustum,
+	const float *x,
+	const float *y,
+	const float *z,
+	const float *radii,
+	uint32_t count,
+	std::vector<uint32_t> &visible) {
+	uint32_t i = 0;
+	__m128 planeX[LveFrustum::PLANE_COUNT], planeY[LveFrustum::PLANE_COUNT];
+	__m128 planeZ[LveFrustum::PLANE_COUNT], planeW[LveFrustum::PLANE_COUNT];
+	for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+	for (; i + 4 <= count; i += 4) {
+		const __m128 sx = _mm_loadu_ps(x + i);
+		const __m128 sy = _mm_loadu_ps(y + i);
+		const __m128 sz = _mm_loadu_ps(z + i);
+		const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radii + i));
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < LveFrustum::PLANE_COUNT; p++) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(sx, planeX[p]), _mm_mul_ps(sy, planeY[p]));
+			distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(sz, planeZ[p])), planeW[p]);
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+		}
+		int inside = ~_mm_movemask_ps(outside) & 0xf;
+		for (uint32_t lane = 0; inside != 0; lane++, inside >>= 1) {
+			if (inside & 1) visible.push_back(i + lane);
+		}
+	}
+	return i;
+}
+#endif
+
+}  // namespace
+
+void LveFrustumCuller::clear() {
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radii.clear();
+}
+
+void LveFrustumCuller::reserve(size_t count) {
+	centerX.reserve(count);
+	centerY.reserve(count);
+	centerZ.reserve(count);
+	radii.reserve(count);
+}
+
+uint32_t LveFrustumCuller::addSphere(const glm::vec3 &center, float radius) {
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	radii.push_back(radius);
+	return static_cast<uint32_t>(radii.size() - 1);
+}
+
+bool LveFrustumCuller::isAvailable(Path path) {
+	switch (path) {
+		case Path::Scalar: return true;
+#if defined(LVE_FRUSTUM_CULLER_SSE)
+		case Path::Sse: return true;
+#endif
+#if defined(LVE_FRUSTUM_CULLER_AVX)
+		case Path::Avx: return cpuHasAvx();
+#endif
+		default: return false;
+	}
+}
+
+LveFrustumCuller::Path LveFrustumCuller::getBestPath() {
+	return isAvailable(Path::Avx) ? Path::Avx : isAvailable(Path::Sse) ? Path::Sse : Path::Scalar;
+}
+
+void LveFrustumCuller::cull(const LveFrustum &frustum, std::vector<uint32_t> &visible) const {
+	cull(frustum, visible, getBestPath());
+}
+
+void LveFrustumCuller::cull(const LveFrustum &frustum, std::vector<uint32_t> &visible, Path path) const {
+	assert(isAvailable(path) && "Frustum culling path not available");
+	const uint32_t count = static_cast<uint32_t>(radii.size());
+	uint32_t i = 0;
+#if defined(LVE_FRUSTUM_CULLER_AVX)
+	if (path == Path::Avx) {
+		i = cullAvx(frustum, centerX.data(), centerY.data(), centerZ.data(), radii.data(), count, visible);
+	}
+#endif
+#if defined(LVE_FRUSTUM_CULLER_SSE)
+	if (path == Path::Sse) {
+		i = cullSse(frustum, centerX.data(), centerY.data(), centerZ.data(), radii.data(), count, visible);
+	}
+#endif
+
+	for (; i < count; i++) {
+		if (frustum.intersectsSphere({centerX[i], centerY[i], centerZ[i]}, radii[i])) {
+			visible.push_back(i);
+		}
+	}
+}
+
+}
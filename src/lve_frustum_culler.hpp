@@ -0,0 +1,40 @@
+#pragma once
+
+#include "lve_frustum.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Frustum test for many bounding spheres at once. The spheres are stored as separate x, y, z
+// and radius arrays, so each plane is tested against eight (AVX) or four (SSE) spheres per
+// instruction. The remainder, and targets without either, take the scalar loop.
+class LveFrustumCuller {
+public:
+	enum class Path { Scalar, Sse, Avx };
+	// SSE is there when the target has it, AVX when the CPU has it at runtime
+	static bool isAvailable(Path path);
+	static Path getBestPath();
+
+	void clear();
+	void reserve(size_t count);
+	// adds a world space sphere, returns its index
+	uint32_t addSphere(const glm::vec3 &center, float radius);
+	size_t size() const { return centerX.size(); }
+
+	// Appends the indices of the spheres that intersect frustum, in ascending order, with
+	// the test of LveFrustum::intersectsSphere.
+	void cull(const LveFrustum &frustum, std::vector<uint32_t> &visible) const;
+	// the same with a specific path, which has to be available
+	void cull(const LveFrustum &frustum, std::vector<uint32_t> &visible, Path path) const;
+
+private:
+	std::vector<float> centerX{};
+	std::vector<float> centerY{};
+	std::vector<float> centerZ{};
+	std::vector<float> radii{};
+};
+
+}
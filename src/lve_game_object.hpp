@@ -3,6 +3,8 @@
 #include "glm/fwd.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "lve_model.hpp"
+#include "lve_model_handle.hpp"
+#include "lve_occlusion_culler.hpp"
 
 #include <memory>
 #include <unordered_map>
@@ -44,9 +46,12 @@ public:
 
 	static LveGameObject makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
 
-	std::shared_ptr<LveModel> model{};
+	// draws nothing until the model has finished loading
+	LveModelHandle model{};
 	glm::vec3 color{};
 	TransformComponent transform{};
+	// hides the objects behind it when the render system has an LveOcclusionCuller
+	std::shared_ptr<const LveOccluder> occluder{};
 
 	std::unique_ptr<PointLightComponent> pointLight = nullptr;
 
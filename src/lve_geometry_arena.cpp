@@ -0,0 +1,98 @@
+#include "lve_geometry_arena.hpp"
+
+#include <stdexcept>
+
+namespace lve {
+
+LveGeometryArena::LveGeometryArena(LveDevice &device, VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity)
+	: lveDevice{device},
+	  hostVisible{device.hasHostVisibleDeviceLocalMemory()},
+	  vertexAllocator{vertexCapacity},
+	  indexAllocator{indexCapacity} {
+	VkMemoryPropertyFlags memoryProperties = hostVisible
+		? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		: VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	vertexBuffer = std::make_unique<LveBuffer>(
+		lveDevice,
+		1,
+		static_cast<uint32_t>(vertexCapacity),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		memoryProperties,
+		1,
+		LveMemoryCategory::Geometry);
+	indexBuffer = std::make_unique<LveBuffer>(
+		lveDevice,
+		1,
+		static_cast<uint32_t>(indexCapacity),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		memoryProperties,
+		1,
+		LveMemoryCategory::Geometry);
+
+	if (hostVisible) {
+		vertexBuffer->map();
+		indexBuffer->map();
+	}
+}
+
+LveGeometryArena::~LveGeometryArena() {}
+
+LveGeometryArena::Allocation LveGeometryArena::allocateVertices(uint32_t count, uint32_t stride) {
+	Allocation allocation{0, VkDeviceSize{count} * stride};
+	if (!vertexAllocator.allocate(allocation.size, stride, allocation.offset)) {
+		throw std::runtime_error("geometry arena is out of vertex memory!");
+	}
+	return allocation;
+}
+
+LveGeometryArena::Allocation LveGeometryArena::allocateIndices(uint32_t count, uint32_t indexSize) {
+	Allocation allocation{0, VkDeviceSize{count} * indexSize};
+	if (!indexAllocator.allocate(allocation.size, indexSize, allocation.offset)) {
+		throw std::runtime_error("geometry arena is out of index memory!");
+	}
+	return allocation;
+}
+
+void LveGeometryArena::freeVertices(const Allocation &allocation) {
+	if (allocation.size > 0) {
+		vertexAllocator.free(allocation.offset, allocation.size);
+	}
+}
+
+void LveGeometryArena::freeIndices(const Allocation &allocation) {
+	if (allocation.size > 0) {
+		indexAllocator.free(allocation.offset, allocation.size);
+	}
+}
+
+void *LveGeometryArena::writeVertices(const Allocation &allocation) {
+	if (hostVisible) {
+		// coherent, the next queue submit makes the writes visible to the device
+		return static_cast<char *>(vertexBuffer->getMappedMemory()) + allocation.offset;
+	}
+	return lveDevice.getUploadBatch().stage(vertexBuffer->getBuffer(), allocation.offset, allocation.size);
+}
+
+void *LveGeometryArena::writeIndices(const Allocation &allocation) {
+	if (hostVisible) {
+		return static_cast<char *>(indexBuffer->getMappedMemory()) + allocation.offset;
+	}
+	return lveDevice.getUploadBatch().stage(indexBuffer->getBuffer(), allocation.offset, allocation.size);
+}
+
+LveUploadBatch::Token LveGeometryArena::getPendingToken() const {
+	// direct writes never wait for a copy, token 0 is always complete
+	return hostVisible ? 0 : lveDevice.getUploadBatch().getPendingToken();
+}
+
+void LveGeometryArena::bindVertexBuffer(LveCommandRecorder &recorder) const {
+	VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+	VkDeviceSize offsets[] = {0};
+	recorder.bindVertexBuffers(0, 1, buffers, offsets);
+}
+
+void LveGeometryArena::bindIndexBuffer(LveCommandRecorder &recorder, VkIndexType indexType) const {
+	recorder.bindIndexBuffer(indexBuffer->getBuffer(), 0, indexType);
+}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_command_recorder.hpp"
+#include "lve_device.hpp"
+#include "lve_free_list_allocator.hpp"
+#include "lve_upload_batch.hpp"
+
+#include <memory>
+
+namespace lve {
+
+// One device local vertex buffer and one index buffer shared by every model created from it.
+// Models get ranges of them and draw with firstIndex / vertexOffset, so renderers only
+// rebind when the index type changes.
+//
+// Vertex ranges are aligned to their stride and index ranges to their index size, which
+// lets both vertex formats and both index types live in the same buffers.
+//
+// When the device has host visible device local memory the buffers live there and stay
+// mapped, data is written straight into its range. Otherwise writes go through the device's
+// upload batch.
+class LveGeometryArena {
+public:
+	static constexpr VkDeviceSize DEFAULT_VERTEX_CAPACITY = 64ull << 20;
+	static constexpr VkDeviceSize DEFAULT_INDEX_CAPACITY = 32ull << 20;
+
+	struct Allocation {
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+	};
+
+	LveGeometryArena(
+		LveDevice &device,
+		VkDeviceSize vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+		VkDeviceSize indexCapacity = DEFAULT_INDEX_CAPACITY);
+	~LveGeometryArena();
+
+	LveGeometryArena(const LveGeometryArena &) = delete;
+	LveGeometryArena &operator=(const LveGeometryArena &) = delete;
+
+	// throw when the arena is full
+	Allocation allocateVertices(uint32_t count, uint32_t stride);
+	Allocation allocateIndices(uint32_t count, uint32_t indexSize);
+	// the range must no longer be in use by the GPU
+	void freeVertices(const Allocation &allocation);
+	void freeIndices(const Allocation &allocation);
+
+	// Memory to fill a range with: the range itself when the arena is host visible, otherwise
+	// staging memory copied over with the next upload batch submit.
+	void *writeVertices(const Allocation &allocation);
+	void *writeIndices(const Allocation &allocation);
+	// completes once everything written so far can be drawn
+	LveUploadBatch::Token getPendingToken() const;
+	bool isHostVisible() const { return hostVisible; }
+
+	void bindVertexBuffer(LveCommandRecorder &recorder) const;
+	void bindIndexBuffer(LveCommandRecorder &recorder, VkIndexType indexType) const;
+
+	VkBuffer getVertexBuffer() const { return vertexBuffer->getBuffer(); }
+	VkBuffer getIndexBuffer() const { return indexBuffer->getBuffer(); }
+	const LveFreeListAllocator &getVertexAllocator() const { return vertexAllocator; }
+	const LveFreeListAllocator &getIndexAllocator() const { return indexAllocator; }
+
+private:
+	LveDevice &lveDevice;
+	bool hostVisible;
+
+	std::unique_ptr<LveBuffer> vertexBuffer;
+	std::unique_ptr<LveBuffer> indexBuffer;
+	LveFreeListAllocator vertexAllocator;
+	LveFreeListAllocator indexAllocator;
+};
+
+}
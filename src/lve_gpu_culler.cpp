@@ -0,0 +1,200 @@
+#include "lve_gpu_culler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+constexpr uint32_t WORKGROUP_SIZE = 64;
+// Instance of simple.vert
+constexpr VkDeviceSize INSTANCE_SIZE = 2 * sizeof(glm::mat4);
+
+struct CullPushConstants {
+	glm::mat4 pyramidViewProjection;
+	glm::vec2 pyramidSize;
+	uint32_t objectCount;
+	uint32_t firstInstance;
+	uint32_t occlusionCulling;
+};
+
+}  // namespace
+
+LveGpuCuller::LveGpuCuller(LveDevice& device, VkDescriptorSetLayout globalSetLayout, VkExtent2D depthExtent)
+	: lveDevice{device}, depthPyramid{device, depthExtent} {
+	assert(isSupported(device) && "GPU culling needs drawIndirectFirstInstance");
+	createPipeline(globalSetLayout);
+
+	// frames never share an atom, flushing one frame's counters can't touch another's
+	const VkPhysicalDeviceLimits& limits = device.properties.limits;
+	statsBuffer = std::make_unique<LveBuffer>(
+		device,
+		sizeof(Stats),
+		LveSwapChain::MAX_FRAMES_IN_FLIGHT,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		std::max(limits.minStorageBufferOffsetAlignment, limits.nonCoherentAtomSize));
+	statsBuffer->map();
+}
+
+LveGpuCuller::~LveGpuCuller() { vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr); }
+
+void LveGpuCuller::createPipeline(VkDescriptorSetLayout globalSetLayout) {
+	setLayout = LveDescriptorSetLayout::Builder(lveDevice)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.build();
+	descriptorPool = LveDescriptorPool::Builder(lveDevice)
+		.setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6 * LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
+		.build();
+	// written by every cull(), the buffer ranges move around the frame allocator
+	for (auto& set : descriptorSets) {
+		if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), set)) {
+			throw std::runtime_error("failed to allocate culling descriptor set!");
+		}
+	}
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullPushConstants);
+
+	std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, setLayout->getDescriptorSetLayout()};
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create pipeline layout!");
+	}
+
+	// without draw counts culled objects keep their draw with no instances
+	VkBool32 compactDraws = compactsDraws() ? VK_TRUE : VK_FALSE;
+	VkSpecializationMapEntry specializationEntry{0, 0, sizeof(VkBool32)};
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = 1;
+	specializationInfo.pMapEntries = &specializationEntry;
+	specializationInfo.dataSize = sizeof(VkBool32);
+	specializationInfo.pData = &compactDraws;
+	pipeline = std::make_unique<LveComputePipeline>(lveDevice, "shaders/cull.comp.spv", pipelineLayout, &specializationInfo);
+}
+
+LveGpuCuller::Output LveGpuCuller::cull(FrameInfo& frameInfo, const std::vector<Object>& objects, const std::vector<Batch>& batches) {
+	readStats(frameInfo.frameIndex);
+	visibilityCounts[frameInfo.frameIndex] = 0;
+	if (objects.empty()) return {};
+
+	const uint32_t objectCount = static_cast<uint32_t>(objects.size());
+	LveFrameAllocator& frameAllocator = frameInfo.frameAllocator;
+	auto objectAllocation = frameAllocator.upload(objects.data(), objectCount * sizeof(Object));
+	auto batchAllocation = frameAllocator.upload(batches.data(), batches.size() * sizeof(Batch));
+	auto drawAllocation = frameAllocator.allocate(objectCount * sizeof(VkDrawIndexedIndirectCommand));
+	// instances are indexed from the start of the buffer, the range has to start on a whole one
+	VkDeviceSize instanceAlignment = std::max(INSTANCE_SIZE, lveDevice.properties.limits.minStorageBufferOffsetAlignment);
+	auto instanceAllocation = frameAllocator.allocate(objectCount * INSTANCE_SIZE, instanceAlignment);
+
+	Stats counters{};
+	counters.objects = objectCount;
+	statsBuffer->writeToIndex(&counters, frameInfo.frameIndex);
+	statsBuffer->flushIndex(frameInfo.frameIndex);
+	statsPending[frameInfo.frameIndex] = true;
+
+	VkDescriptorBufferInfo objectInfo = objectAllocation.descriptorInfo();
+	VkDescriptorBufferInfo batchInfo = batchAllocation.descriptorInfo();
+	VkDescriptorBufferInfo drawInfo = drawAllocation.descriptorInfo();
+	VkDescriptorBufferInfo instanceInfo = instanceAllocation.descriptorInfo();
+	VkDescriptorBufferInfo statsInfo = statsBuffer->descriptorInfoForIndex(frameInfo.frameIndex);
+	VkDescriptorBufferInfo visibilityInfo = reserveVisibility(frameInfo.frameIndex, objectCount);
+	VkDescriptorImageInfo pyramidInfo{depthPyramid.getSampler(), depthPyramid.getImageView(), VK_IMAGE_LAYOUT_GENERAL};
+	LveDescriptorWriter(*setLayout, *descriptorPool)
+		.writeBuffer(0, &objectInfo)
+		.writeBuffer(1, &batchInfo)
+		.writeBuffer(2, &drawInfo)
+		.writeBuffer(3, &instanceInfo)
+		.writeBuffer(4, &statsInfo)
+		.writeImage(5, &pyramidInfo)
+		.writeBuffer(6, &visibilityInfo)
+		.overwrite(descriptorSets[frameInfo.frameIndex]);
+
+	CullPushConstants push{};
+	push.pyramidViewProjection = pyramidViewProjection;
+	push.pyramidSize = glm::vec2(depthPyramid.getExtent().width, depthPyramid.getExtent().height);
+	push.objectCount = objectCount;
+	push.firstInstance = static_cast<uint32_t>(instanceAllocation.offset / INSTANCE_SIZE);
+	push.occlusionCulling = occlusionCulling && pyramidBuilt ? 1 : 0;
+
+	pipeline->bind(frameInfo.commandBuffer);
+	VkDescriptorSet sets[] = {frameInfo.globalDescriptorSet, descriptorSets[frameInfo.frameIndex]};
+	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 2, sets, 1, &frameInfo.globalUboOffset);
+	vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push);
+	vkCmdDispatch(frameInfo.commandBuffer, (objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+	// push constants are shared with the graphics bind point
+	frameInfo.commandRecorder.invalidate();
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(
+		frameInfo.commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	return {drawAllocation.buffer, drawAllocation.offset, batchAllocation.offset};
+}
+
+void LveGpuCuller::buildDepthPyramid(FrameInfo& frameInfo, const LveDepthAttachment& depth) {
+	depthPyramid.build(frameInfo.commandBuffer, frameInfo.frameIndex, depth);
+	frameInfo.commandRecorder.invalidate();
+	pyramidViewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+	pyramidBuilt = true;
+}
+
+void LveGpuCuller::readStats(int frameIndex) {
+	if (!statsPending[frameIndex]) return;
+	// the swap chain waited for the last frame with this index, its counters are final
+	statsBuffer->invalidateIndex(frameIndex);
+	std::memcpy(
+		&stats,
+		static_cast<const char*>(statsBuffer->getMappedMemory()) + frameIndex * statsBuffer->getAlignmentSize(),
+		sizeof(Stats));
+	statsPending[frameIndex] = false;
+}
+
+VkDescriptorBufferInfo LveGpuCuller::reserveVisibility(int frameIndex, uint32_t objectCount) {
+	std::unique_ptr<LveBuffer>& buffer = visibilityBuffers[frameIndex];
+	if (!buffer || buffer->getInstanceCount() < objectCount) {
+		// the last frame with this index has finished, its buffer can go
+		uint32_t capacity = std::max(objectCount + objectCount / 2, 1024u);
+		buffer = std::make_unique<LveBuffer>(
+			lveDevice,
+			sizeof(uint32_t),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+		buffer->map();
+	}
+	visibilityCounts[frameIndex] = objectCount;
+	return buffer->descriptorInfo(objectCount * sizeof(uint32_t), 0);
+}
+
+const uint32_t* LveGpuCuller::getVisibility(int frameIndex, uint32_t& objectCount) {
+	objectCount = visibilityCounts[frameIndex];
+	if (objectCount == 0) return nullptr;
+	visibilityBuffers[frameIndex]->invalidate();
+	return static_cast<const uint32_t*>(visibilityBuffers[frameIndex]->getMappedMemory());
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_compute_pipeline.hpp"
+#include "lve_depth_pyramid.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_device.hpp"
+#include "lve_frame_info.hpp"
+#include "lve_swap_chain.hpp"
+#include "vulkan/vulkan_core.h"
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+// Visibility on the GPU. cull() records a compute pass, before the render pass, that tests
+// every object against the frustum of the frame's GlobalUbo and against a depth pyramid of
+// the previous frame's depth attachment, and compacts the draws of the survivors into an
+// indirect buffer with a draw count per batch. The CPU only writes the object table, and
+// reads back which objects survived once the frame has finished (getVisibility()).
+//
+// Objects the previous frame didn't see behind something that has since moved show up one
+// frame late, the occlusion test uses the camera the pyramid was rendered with.
+class LveGpuCuller {
+public:
+	// std430 Object of cull.comp
+	struct Object {
+		glm::mat4 modelMatrix;
+		glm::mat4 normalMatrix;
+		glm::vec4 boundingSphere;  // world space center and radius
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+		uint32_t batch;
+	};
+
+	// Draws sharing a pipeline and bound buffers, one indirect draw. The objects of a batch are
+	// contiguous, firstDraw is the index of the first one and drawCount starts at 0.
+	struct Batch {
+		uint32_t drawCount;
+		uint32_t firstDraw;
+	};
+
+	struct Stats {
+		uint32_t objects = 0;
+		uint32_t frustumCulled = 0;
+		uint32_t occlusionCulled = 0;
+		uint32_t visible = 0;
+	};
+
+	// Where cull() put the draws, all in one buffer. Draw i is VkDrawIndexedIndirectCommand i
+	// at drawCommandOffset, the Batch array at batchOffset holds the draw counts.
+	struct Output {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize drawCommandOffset = 0;
+		VkDeviceSize batchOffset = 0;
+	};
+
+	LveGpuCuller(LveDevice& device, VkDescriptorSetLayout globalSetLayout, VkExtent2D depthExtent);
+	~LveGpuCuller();
+
+	LveGpuCuller(const LveGpuCuller&) = delete;
+	LveGpuCuller& operator=(const LveGpuCuller&) = delete;
+
+	// draws carry their instance in firstInstance
+	static bool isSupported(LveDevice& device) { return device.getEnabledFeatures().drawIndirectFirstInstance; }
+
+	// Records the culling pass, outside of a render pass. The instances of the draws are
+	// written to the frame allocator, where simple.vert reads them.
+	Output cull(FrameInfo& frameInfo, const std::vector<Object>& objects, const std::vector<Batch>& batches);
+	// Records the depth pyramid build from the frame's depth attachment after its render pass,
+	// the next frame's cull() tests against it.
+	void buildDepthPyramid(FrameInfo& frameInfo, const LveDepthAttachment& depth);
+
+	// true when the batches' draw counts are valid, otherwise every object keeps a draw and the
+	// culled ones draw no instances
+	bool compactsDraws() const {
+		return lveDevice.hasDrawIndirectCount() && lveDevice.getEnabledFeatures().multiDrawIndirect;
+	}
+	void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+	bool isOcclusionCulling() const { return occlusionCulling; }
+	// Counts of the most recent frame whose results have arrived, read back without waiting
+	// so they lag MAX_FRAMES_IN_FLIGHT frames behind.
+	const Stats& getStats() const { return stats; }
+	// Per object of the last cull() with frameIndex, nonzero where it survived, or nullptr
+	// with objectCount 0. Valid once the swap chain waited for that frame and until the next
+	// cull() with the same index.
+	const uint32_t* getVisibility(int frameIndex, uint32_t& objectCount);
+
+private:
+	void createPipeline(VkDescriptorSetLayout globalSetLayout);
+	void readStats(int frameIndex);
+	// grows the frame's visibility buffer to objectCount entries
+	VkDescriptorBufferInfo reserveVisibility(int frameIndex, uint32_t objectCount);
+
+	LveDevice& lveDevice;
+
+	std::unique_ptr<LveDescriptorSetLayout> setLayout;
+	std::unique_ptr<LveDescriptorPool> descriptorPool;
+	VkDescriptorSet descriptorSets[LveSwapChain::MAX_FRAMES_IN_FLIGHT];
+	VkPipelineLayout pipelineLayout;
+	std::unique_ptr<LveComputePipeline> pipeline;
+
+	LveDepthPyramid depthPyramid;
+	glm::mat4 pyramidViewProjection{1.f};
+	bool pyramidBuilt = false;
+	bool occlusionCulling = true;
+
+	// one Stats per frame in flight, host visible
+	std::unique_ptr<LveBuffer> statsBuffer;
+	bool statsPending[LveSwapChain::MAX_FRAMES_IN_FLIGHT] = {};
+	Stats stats{};
+
+	// one per frame in flight, host visible, written by cull.comp
+	std::unique_ptr<LveBuffer> visibilityBuffers[LveSwapChain::MAX_FRAMES_IN_FLIGHT];
+	uint32_t visibilityCounts[LveSwapChain::MAX_FRAMES_IN_FLIGHT] = {};
+};
+
+}
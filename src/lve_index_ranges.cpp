@@ -0,0 +1,68 @@
+#include "lve_index_ranges.hpp"
+
+#include <algorithm>
+
+namespace lve {
+
+std::vector<LveModel::IndexRange> split16BitIndexRanges(
+	const uint32_t *indices,
+	uint32_t count,
+	uint32_t vertexCount,
+	const LveModel::Lod *lods,
+	uint32_t lodCount) {
+	if (vertexCount <= 65536) {
+		return {{0, count, 0}};
+	}
+
+	std::vector<uint32_t> lodStarts(lodCount);
+	for (uint32_t i = 0; i < lodCount; i++) {
+		lodStarts[i] = lods[i].firstIndex;
+	}
+	std::sort(lodStarts.begin(), lodStarts.end());
+	size_t nextLod = 0;
+
+	std::vector<LveModel::IndexRange> ranges;
+	size_t lodRanges = 0;
+	uint32_t first = 0;
+	uint32_t rangeMin = UINT32_MAX;
+	uint32_t rangeMax = 0;
+	auto closeRange = [&](uint32_t end) {
+		if (end > first) {
+			ranges.push_back({first, end - first, static_cast<int32_t>(rangeMin)});
+			lodRanges++;
+		}
+		first = end;
+		rangeMin = UINT32_MAX;
+		rangeMax = 0;
+	};
+
+	// greedily cut the triangle list wherever the indices seen so far would span more than 16 bits
+	for (uint32_t i = 0; i < count; i += 3) {
+		if (nextLod < lodStarts.size() && lodStarts[nextLod] <= i) {
+			while (nextLod < lodStarts.size() && lodStarts[nextLod] <= i) nextLod++;
+			closeRange(i);
+			lodRanges = 0;
+		}
+
+		uint32_t end = std::min(i + 3, count);
+		uint32_t triangleMin = *std::min_element(indices + i, indices + end);
+		uint32_t triangleMax = *std::max_element(indices + i, indices + end);
+		if (triangleMax - triangleMin > 65535) {
+			// no vertexOffset makes this triangle fit
+			return {};
+		}
+
+		if (std::max(rangeMax, triangleMax) - std::min(rangeMin, triangleMin) > 65535) {
+			closeRange(i);
+			if (lodRanges >= MAX_16BIT_INDEX_RANGES) {
+				return {};
+			}
+		}
+		rangeMin = std::min(rangeMin, triangleMin);
+		rangeMax = std::max(rangeMax, triangleMax);
+	}
+	closeRange(count);
+	return ranges;
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// every extra range is an extra draw call, past this 32 bit indices are the better deal
+constexpr size_t MAX_16BIT_INDEX_RANGES = 8;
+
+// Splits an index buffer into ranges whose indices fit 16 bits relative to their
+// vertexOffset. Ranges never straddle the start of a LOD, so drawing any one LOD costs at
+// most MAX_16BIT_INDEX_RANGES draw calls. Returns an empty vector, meaning the buffer stays
+// 32 bit, when a single triangle spans more than 65535 vertices or a LOD needs more ranges.
+std::vector<LveModel::IndexRange> split16BitIndexRanges(
+	const uint32_t *indices,
+	uint32_t count,
+	uint32_t vertexCount,
+	const LveModel::Lod *lods,
+	uint32_t lodCount);
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lve {
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Every slot carries a sequence
+// number telling producers and consumers whose turn it is, so push and pop are one CAS on
+// the shared position plus a store on the slot, with no locks.
+template <typename T>
+class LveLockFreeQueue {
+public:
+	explicit LveLockFreeQueue(size_t capacity) : mask{capacity - 1}, cells{new Cell[capacity]} {
+		assert(capacity >= 2 && (capacity & (capacity - 1)) == 0 && "Capacity must be a power of two");
+		for (size_t i = 0; i < capacity; i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~LveLockFreeQueue() {
+		T value;
+		while (tryPop(value)) {
+		}
+	}
+
+	LveLockFreeQueue(const LveLockFreeQueue &) = delete;
+	LveLockFreeQueue &operator=(const LveLockFreeQueue &) = delete;
+
+	// false when the queue is full, value is left untouched then
+	bool tryPush(T &value) {
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Cell *cell;
+		for (;;) {
+			cell = &cells[position & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (difference == 0) {
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+		new (&cell->storage) T(std::move(value));
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T &value) {
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		Cell *cell;
+		for (;;) {
+			cell = &cells[position & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+			if (difference == 0) {
+				if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = dequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+		T *stored = std::launder(reinterpret_cast<T *>(&cell->storage));
+		value = std::move(*stored);
+		stored->~T();
+		cell->sequence.store(position + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+	};
+
+	// producers and consumers hammer different positions, keep them on separate cache lines
+	static constexpr size_t CACHE_LINE = 64;
+
+	const size_t mask;
+	std::unique_ptr<Cell[]> cells;
+	alignas(CACHE_LINE) std::atomic<size_t> enqueuePosition{0};
+	alignas(CACHE_LINE) std::atomic<size_t> dequeuePosition{0};
+};
+
+}
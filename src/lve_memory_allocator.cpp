@@ -0,0 +1,239 @@
+#include "lve_memory_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+const char *memoryCategoryName(LveMemoryCategory category) {
+	switch (category) {
+		case LveMemoryCategory::Geometry: return "geometry";
+		case LveMemoryCategory::Uniforms: return "uniforms";
+		case LveMemoryCategory::Depth: return "depth";
+		case LveMemoryCategory::Staging: return "staging";
+		case LveMemoryCategory::Other: return "other";
+	}
+	return "unknown";
+}
+
+LveMemoryAllocator::LveMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize)
+	: device{device}, blockSize{blockSize} {
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+}
+
+LveMemoryAllocator::~LveMemoryAllocator() {
+	for (auto &block : blocks) {
+		if (block.memory == VK_NULL_HANDLE) continue;
+		assert(block.allocator->isEmpty() && "Memory is still in use");
+		freeMemory(block.memory, block.mapped);
+	}
+	assert(dedicatedAllocationCount == 0 && "Memory is still in use");
+}
+
+VkDeviceSize LveMemoryAllocator::heapBlockSize(VkDeviceSize blockSize, VkDeviceSize heapSize, VkDeviceSize nonCoherentAtomSize) {
+	// small heaps (e.g. the 256 MiB of device local memory the host can see) get smaller blocks
+	VkDeviceSize size = std::min(blockSize, heapSize / 8);
+	return size / nonCoherentAtomSize * nonCoherentAtomSize;
+}
+
+LveMemoryAllocation LveMemoryAllocator::allocate(
+	const VkMemoryRequirements &requirements,
+	uint32_t memoryTypeIndex,
+	ResourceKind kind,
+	LveMemoryCategory category) {
+	LveMemoryAllocation allocation{};
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	allocation.category = category;
+	allocation.size = requirements.size;
+	VkDeviceSize alignment = requirements.alignment;
+	// flushed ranges are widened to whole atoms, they must not reach into a neighbour
+	if (!isCoherent(memoryTypeIndex)) {
+		alignment = std::max(alignment, nonCoherentAtomSize);
+		allocation.size = (allocation.size + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+	}
+
+	const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	VkDeviceSize typeBlockSize = heapBlockSize(blockSize, memoryProperties.memoryHeaps[heapIndex].size, nonCoherentAtomSize);
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (isDedicated(allocation.size, typeBlockSize)) {
+		allocation.memory = allocateMemory(allocation.size, memoryTypeIndex, allocation.mapped);
+		heapAllocatedBytes[heapIndex] += allocation.size;
+		dedicatedAllocationCount++;
+		dedicatedBytes += allocation.size;
+		heapUsedBytes[heapIndex][static_cast<uint32_t>(category)] += allocation.size;
+		return allocation;
+	}
+
+	for (uint32_t i = 0; i < blocks.size(); i++) {
+		Block &block = blocks[i];
+		if (block.memory == VK_NULL_HANDLE || block.memoryTypeIndex != memoryTypeIndex || block.kind != kind) continue;
+		allocation.handle = block.allocator->allocate(allocation.size, alignment, allocation.offset);
+		if (allocation.handle != LveTlsfAllocator::INVALID_HANDLE) {
+			allocation.block = i;
+			allocation.memory = block.memory;
+			allocation.mapped = block.mapped ? static_cast<char *>(block.mapped) + allocation.offset : nullptr;
+			heapUsedBytes[heapIndex][static_cast<uint32_t>(category)] += allocation.size;
+			return allocation;
+		}
+	}
+
+	Block block{};
+	block.memory = allocateMemory(typeBlockSize, memoryTypeIndex, block.mapped);
+	heapAllocatedBytes[heapIndex] += typeBlockSize;
+	block.memoryTypeIndex = memoryTypeIndex;
+	block.kind = kind;
+	block.allocator = std::make_unique<LveTlsfAllocator>(typeBlockSize);
+	allocation.handle = block.allocator->allocate(allocation.size, alignment, allocation.offset);
+	assert(allocation.handle != LveTlsfAllocator::INVALID_HANDLE && "Allocation doesn't fit an empty block");
+
+	auto unused = std::find_if(blocks.begin(), blocks.end(), [](const Block &b) { return b.memory == VK_NULL_HANDLE; });
+	if (unused == blocks.end()) {
+		unused = blocks.insert(blocks.end(), std::move(block));
+	} else {
+		*unused = std::move(block);
+	}
+	allocation.block = static_cast<uint32_t>(unused - blocks.begin());
+	allocation.memory = unused->memory;
+	allocation.mapped = unused->mapped ? static_cast<char *>(unused->mapped) + allocation.offset : nullptr;
+	heapUsedBytes[heapIndex][static_cast<uint32_t>(category)] += allocation.size;
+	return allocation;
+}
+
+void LveMemoryAllocator::free(LveMemoryAllocation &allocation) {
+	if (allocation.memory == VK_NULL_HANDLE) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock{mutex};
+	const uint32_t heapIndex = memoryProperties.memoryTypes[allocation.memoryTypeIndex].heapIndex;
+	heapUsedBytes[heapIndex][static_cast<uint32_t>(allocation.category)] -= allocation.size;
+
+	if (allocation.block == ~0u) {
+		freeMemory(allocation.memory, allocation.mapped);
+		heapAllocatedBytes[heapIndex] -= allocation.size;
+		dedicatedAllocationCount--;
+		dedicatedBytes -= allocation.size;
+		allocation = LveMemoryAllocation{};
+		return;
+	}
+
+	Block &block = blocks[allocation.block];
+	assert(block.memory == allocation.memory && "Allocation doesn't belong to this allocator");
+	block.allocator->free(allocation.handle);
+
+	// keep one empty block per memory type and kind around, so a resource that is created and
+	// destroyed every frame doesn't allocate a block every frame
+	if (block.allocator->isEmpty()) {
+		bool hasOther = std::any_of(blocks.begin(), blocks.end(), [&](const Block &other) {
+			return &other != &block && other.memory != VK_NULL_HANDLE &&
+				other.memoryTypeIndex == block.memoryTypeIndex && other.kind == block.kind;
+		});
+		if (hasOther) {
+			heapAllocatedBytes[heapIndex] -= block.allocator->getCapacity();
+			freeMemory(block.memory, block.mapped);
+			block.memory = VK_NULL_HANDLE;
+			block.mapped = nullptr;
+			block.allocator.reset();
+		}
+	}
+	allocation = LveMemoryAllocation{};
+}
+
+VkMappedMemoryRange LveMemoryAllocator::mappedRange(
+	const LveMemoryAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const {
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation.memory;
+	if (size == VK_WHOLE_SIZE) {
+		range.offset = allocation.offset;
+		range.size = allocation.size;
+		return range;
+	}
+
+	assert(offset + size <= allocation.size && "Range is outside of the allocation");
+	VkDeviceSize begin = (allocation.offset + offset) / nonCoherentAtomSize * nonCoherentAtomSize;
+	VkDeviceSize end = (allocation.offset + offset + size + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+	range.offset = begin;
+	range.size = std::min(end, allocation.offset + allocation.size) - begin;
+	return range;
+}
+
+LveMemoryAllocator::Stats LveMemoryAllocator::getStats() const {
+	std::lock_guard<std::mutex> lock{mutex};
+
+	Stats stats{};
+	stats.dedicatedAllocationCount = dedicatedAllocationCount;
+	stats.allocationCount = dedicatedAllocationCount;
+	stats.bytesAllocated = dedicatedBytes;
+	stats.bytesUsed = dedicatedBytes;
+
+	VkDeviceSize freeBytes = 0;
+	double fragmentedBytes = 0.0;
+	for (const auto &block : blocks) {
+		if (block.memory == VK_NULL_HANDLE) continue;
+		const LveTlsfAllocator &allocator = *block.allocator;
+		stats.blockCount++;
+		stats.allocationCount += allocator.getAllocationCount();
+		stats.bytesAllocated += allocator.getCapacity();
+		stats.bytesUsed += allocator.getUsedSize();
+
+		VkDeviceSize blockFree = allocator.getCapacity() - allocator.getUsedSize();
+		if (blockFree > 0) {
+			freeBytes += blockFree;
+			fragmentedBytes += static_cast<double>(blockFree - allocator.getLargestFreeBlock());
+		}
+	}
+	if (freeBytes > 0) {
+		stats.fragmentation = static_cast<float>(fragmentedBytes / static_cast<double>(freeBytes));
+	}
+	return stats;
+}
+
+VkDeviceSize LveMemoryAllocator::getHeapAllocatedSize(uint32_t heapIndex) const {
+	std::lock_guard<std::mutex> lock{mutex};
+	return heapAllocatedBytes[heapIndex];
+}
+
+VkDeviceSize LveMemoryAllocator::getHeapUsedSize(uint32_t heapIndex, LveMemoryCategory category) const {
+	std::lock_guard<std::mutex> lock{mutex};
+	return heapUsedBytes[heapIndex][static_cast<uint32_t>(category)];
+}
+
+VkDeviceMemory LveMemoryAllocator::allocateMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void *&mapped) {
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate device memory!");
+	}
+
+	mapped = nullptr;
+	if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+			vkFreeMemory(device, memory, nullptr);
+			throw std::runtime_error("failed to map device memory!");
+		}
+	}
+	return memory;
+}
+
+void LveMemoryAllocator::freeMemory(VkDeviceMemory memory, void *mapped) {
+	if (mapped) {
+		vkUnmapMemory(device, memory);
+	}
+	vkFreeMemory(device, memory, nullptr);
+}
+
+bool LveMemoryAllocator::isCoherent(uint32_t memoryTypeIndex) const {
+	return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "lve_tlsf_allocator.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+// what memory is used for, for accounting only
+enum class LveMemoryCategory { Geometry, Uniforms, Depth, Staging, Other };
+constexpr uint32_t LVE_MEMORY_CATEGORY_COUNT = 5;
+const char *memoryCategoryName(LveMemoryCategory category);
+
+// A piece of device memory handed out by LveMemoryAllocator. Resources bind to memory at
+// offset, mapped points at offset too when the memory type is host visible.
+struct LveMemoryAllocation {
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	void *mapped = nullptr;
+	uint32_t memoryTypeIndex = 0;
+	LveMemoryCategory category = LveMemoryCategory::Other;
+	uint32_t block = ~0u;  // ~0u for dedicated allocations
+	LveTlsfAllocator::Handle handle = LveTlsfAllocator::INVALID_HANDLE;
+};
+
+// Sub-allocates buffers and images from large vkAllocateMemory blocks instead of giving each
+// one its own allocation, drivers cap the number of allocations (maxMemoryAllocationCount)
+// and every one of them is slow. Blocks are per memory type and per resource kind, buffers
+// and optimally tiled images never share a block so bufferImageGranularity can't be
+// violated. Host visible blocks stay mapped for their whole life, Vulkan doesn't allow
+// mapping a memory object twice. Requests larger than half a block get their own allocation.
+class LveMemoryAllocator {
+public:
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull << 20;
+
+	enum class ResourceKind { Buffer, Image };
+
+	struct Stats {
+		uint32_t blockCount = 0;
+		uint32_t dedicatedAllocationCount = 0;
+		uint32_t allocationCount = 0;
+		VkDeviceSize bytesAllocated = 0;  // device memory allocated from the driver
+		VkDeviceSize bytesUsed = 0;       // handed out to resources
+		// 0 when all free space in a block is one contiguous range, close to 1 when it's split
+		// into many small ones. Averaged over the blocks weighted by their free space.
+		float fragmentation = 0.f;
+	};
+
+	LveMemoryAllocator(
+		VkDevice device,
+		VkPhysicalDevice physicalDevice,
+		VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+	~LveMemoryAllocator();
+
+	LveMemoryAllocator(const LveMemoryAllocator &) = delete;
+	LveMemoryAllocator &operator=(const LveMemoryAllocator &) = delete;
+
+	LveMemoryAllocation allocate(
+		const VkMemoryRequirements &requirements,
+		uint32_t memoryTypeIndex,
+		ResourceKind kind,
+		LveMemoryCategory category = LveMemoryCategory::Other);
+	void free(LveMemoryAllocation &allocation);
+
+	// range of the allocation to flush or invalidate, widened to nonCoherentAtomSize
+	VkMappedMemoryRange mappedRange(
+		const LveMemoryAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+
+	// Size of the blocks carved out of a heap, at most 1/8th of it and a multiple of the atom
+	// size. Requests larger than half of that get a dedicated allocation.
+	static VkDeviceSize heapBlockSize(VkDeviceSize blockSize, VkDeviceSize heapSize, VkDeviceSize nonCoherentAtomSize);
+	static bool isDedicated(VkDeviceSize size, VkDeviceSize heapBlockSize) { return size > heapBlockSize / 2; }
+
+	Stats getStats() const;
+	const VkPhysicalDeviceMemoryProperties &getMemoryProperties() const { return memoryProperties; }
+	// device memory this allocator got from the heap, including unused parts of blocks
+	VkDeviceSize getHeapAllocatedSize(uint32_t heapIndex) const;
+	// bytes handed out to resources of a category
+	VkDeviceSize getHeapUsedSize(uint32_t heapIndex, LveMemoryCategory category) const;
+
+private:
+	struct Block {
+		VkDeviceMemory memory;
+		void *mapped;
+		uint32_t memoryTypeIndex;
+		ResourceKind kind;
+		std::unique_ptr<LveTlsfAllocator> allocator;
+	};
+
+	VkDeviceMemory allocateMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void *&mapped);
+	void freeMemory(VkDeviceMemory memory, void *mapped);
+	bool isCoherent(uint32_t memoryTypeIndex) const;
+
+	VkDevice device;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	VkDeviceSize blockSize;
+	VkDeviceSize nonCoherentAtomSize;
+
+	mutable std::mutex mutex;
+	std::vector<Block> blocks;  // freed blocks keep their slot with memory VK_NULL_HANDLE
+	uint32_t dedicatedAllocationCount = 0;
+	VkDeviceSize dedicatedBytes = 0;
+	VkDeviceSize heapAllocatedBytes[VK_MAX_MEMORY_HEAPS] = {};
+	VkDeviceSize heapUsedBytes[VK_MAX_MEMORY_HEAPS][LVE_MEMORY_CATEGORY_COUNT] = {};
+};
+
+}
@@ -0,0 +1,151 @@
+#include "lve_mesh_cache.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <system_error>
+#include <type_traits>
+
+namespace lve {
+
+static_assert(std::is_trivially_copyable<LveModel::Vertex>::value, "Vertex must be trivially copyable to be cached");
+static_assert(sizeof(LveMeshCache::Header) % alignof(LveModel::Vertex) == 0, "Vertex data after the header must stay aligned");
+static_assert(std::is_trivially_copyable<LveModel::Lod>::value, "Lod must be trivially copyable to be cached");
+static_assert(alignof(LveModel::Lod) <= alignof(uint32_t), "Lod data after the indices must stay aligned");
+static_assert(std::is_trivially_copyable<LveModel::Meshlet>::value, "Meshlet must be trivially copyable to be cached");
+static_assert(alignof(LveModel::Meshlet) <= alignof(LveModel::Lod), "Meshlet data after the LODs must stay aligned");
+
+// FNV-1a, only used to detect a cache file that was produced for another source path
+static uint64_t hashPath(const std::string &path) {
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : path) {
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// Unique per write, so two threads or processes caching the same source never share a
+// temporary file. The token tells processes apart, the counter writes within one.
+static std::string temporaryPath(const std::string &path) {
+	static const uint64_t processToken = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+	static std::atomic<uint64_t> counter{0};
+	return path + "." + std::to_string(processToken) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+}
+
+std::string LveMeshCache::cachePath(const std::string &filepath) { return filepath + ".lvemesh"; }
+
+bool LveMeshCache::sourceKey(const std::string &filepath, Header &header) {
+	namespace fs = std::filesystem;
+	std::error_code ec;
+
+	fs::path absolute = fs::absolute(filepath, ec);
+	if (ec) return false;
+	auto size = fs::file_size(absolute, ec);
+	if (ec) return false;
+	auto mtime = fs::last_write_time(absolute, ec);
+	if (ec) return false;
+
+	header.sourcePathHash = hashPath(absolute.lexically_normal().string());
+	header.sourceSize = static_cast<uint64_t>(size);
+	header.sourceMtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+	return true;
+}
+
+LveMeshCache::LveMeshCache(std::unique_ptr<LveFileMapping> fileMapping) : mapping{std::move(fileMapping)} {
+	header = reinterpret_cast<const Header *>(mapping->data());
+	vertexData = reinterpret_cast<const LveModel::Vertex *>(mapping->data() + sizeof(Header));
+	indexData = reinterpret_cast<const uint32_t *>(
+		mapping->data() + sizeof(Header) + sizeof(LveModel::Vertex) * header->vertexCount);
+	lodData = reinterpret_cast<const LveModel::Lod *>(indexData + header->indexCount);
+	meshletData = reinterpret_cast<const LveModel::Meshlet *>(lodData + header->lodCount);
+}
+
+std::unique_ptr<LveMeshCache> LveMeshCache::open(const std::string &filepath) {
+	Header expected{};
+	if (!sourceKey(filepath, expected)) {
+		return nullptr;
+	}
+
+	auto mapping = std::make_unique<LveFileMapping>(cachePath(filepath));
+	if (!mapping->isValid() || mapping->size() < sizeof(Header)) {
+		return nullptr;
+	}
+
+	const Header &header = *reinterpret_cast<const Header *>(mapping->data());
+	if (header.magic != MAGIC || header.version != VERSION || header.vertexSize != sizeof(LveModel::Vertex)) {
+		return nullptr;
+	}
+	if (header.sourcePathHash != expected.sourcePathHash || header.sourceSize != expected.sourceSize ||
+		header.sourceMtime != expected.sourceMtime) {
+		return nullptr;
+	}
+
+	uint64_t expectedSize = sizeof(Header) + uint64_t{sizeof(LveModel::Vertex)} * header.vertexCount +
+		uint64_t{sizeof(uint32_t)} * header.indexCount + uint64_t{sizeof(LveModel::Lod)} * header.lodCount +
+		uint64_t{sizeof(LveModel::Meshlet)} * header.meshletCount;
+	if (mapping->size() != expectedSize || header.vertexCount < 3) {
+		return nullptr;
+	}
+
+	return std::unique_ptr<LveMeshCache>(new LveMeshCache(std::move(mapping)));
+}
+
+bool LveMeshCache::write(const std::string &filepath, const LveModel::Builder &builder) {
+	Header header{};
+	if (!sourceKey(filepath, header)) {
+		return false;
+	}
+
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.vertexSize = sizeof(LveModel::Vertex);
+	header.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+	header.indexCount = static_cast<uint32_t>(builder.indices.size());
+	header.lodCount = static_cast<uint32_t>(builder.lods.size());
+	header.meshletCount = static_cast<uint32_t>(builder.meshlets.size());
+
+	glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+	glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+	for (const auto &vertex : builder.vertices) {
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	for (int i = 0; i < 3; i++) {
+		header.boundsMin[i] = boundsMin[i];
+		header.boundsMax[i] = boundsMax[i];
+	}
+
+	// write to a temporary file first so a concurrent reader never maps a partial cache
+	std::string path = cachePath(filepath);
+	std::string tmpPath = temporaryPath(path);
+	{
+		std::ofstream file{tmpPath, std::ios::binary | std::ios::trunc};
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char *>(builder.vertices.data()), sizeof(LveModel::Vertex) * builder.vertices.size());
+		file.write(reinterpret_cast<const char *>(builder.indices.data()), sizeof(uint32_t) * builder.indices.size());
+		file.write(reinterpret_cast<const char *>(builder.lods.data()), sizeof(LveModel::Lod) * builder.lods.size());
+		file.write(reinterpret_cast<const char *>(builder.meshlets.data()), sizeof(LveModel::Meshlet) * builder.meshlets.size());
+		if (!file.good()) {
+			file.close();
+			std::error_code ec;
+			std::filesystem::remove(tmpPath, ec);
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tmpPath, path, ec);
+	if (ec) {
+		std::filesystem::remove(tmpPath, ec);
+		return false;
+	}
+	return true;
+}
+
+}
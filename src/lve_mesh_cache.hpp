@@ -0,0 +1,70 @@
+#pragma once
+
+#include "lve_file_mapping.hpp"
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace lve {
+
+// Binary mesh cache stored next to the source OBJ (<source>.lvemesh).
+// Layout: Header | Vertex[vertexCount] | uint32_t[indexCount] | Lod[lodCount] |
+//         Meshlet[meshletCount]
+// The cache is only used when the source path, size and mtime recorded in the
+// header still match the OBJ on disk, otherwise it is regenerated.
+class LveMeshCache {
+public:
+	static constexpr uint32_t MAGIC = 0x4d45564c;  // "LVEM"
+	static constexpr uint32_t VERSION = 4;
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexSize;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		uint32_t meshletCount;
+		uint32_t reserved;
+		uint64_t sourcePathHash;
+		uint64_t sourceSize;
+		int64_t sourceMtime;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	// Returns nullptr when there is no cache for filepath or it is stale.
+	static std::unique_ptr<LveMeshCache> open(const std::string &filepath);
+	static bool write(const std::string &filepath, const LveModel::Builder &builder);
+	static std::string cachePath(const std::string &filepath);
+
+	LveMeshCache(const LveMeshCache &) = delete;
+	LveMeshCache &operator=(const LveMeshCache &) = delete;
+
+	const LveModel::Vertex *vertices() const { return vertexData; }
+	const uint32_t *indices() const { return indexData; }
+	uint32_t vertexCount() const { return header->vertexCount; }
+	uint32_t indexCount() const { return header->indexCount; }
+	const LveModel::Lod *lods() const { return lodData; }
+	uint32_t lodCount() const { return header->lodCount; }
+	const LveModel::Meshlet *meshlets() const { return meshletData; }
+	uint32_t meshletCount() const { return header->meshletCount; }
+	glm::vec3 boundsMin() const { return {header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]}; }
+	glm::vec3 boundsMax() const { return {header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]}; }
+
+private:
+	explicit LveMeshCache(std::unique_ptr<LveFileMapping> mapping);
+
+	static bool sourceKey(const std::string &filepath, Header &header);
+
+	std::unique_ptr<LveFileMapping> mapping;
+	const Header *header = nullptr;
+	const LveModel::Vertex *vertexData = nullptr;
+	const uint32_t *indexData = nullptr;
+	const LveModel::Lod *lodData = nullptr;
+	const LveModel::Meshlet *meshletData = nullptr;
+};
+
+}
@@ -0,0 +1,225 @@
+#include "lve_mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace lve {
+
+LveModel::VertexCacheStats LveMeshOptimizer::analyzeVertexCache(
+	const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize) {
+	LveModel::VertexCacheStats stats{};
+	if (indices.empty()) {
+		return stats;
+	}
+
+	// a vertex is in the FIFO while fewer than cacheSize misses happened since it was loaded
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	uint32_t misses = 0;
+	uint32_t uniqueVertices = 0;
+
+	for (uint32_t index : indices) {
+		assert(index < vertexCount && "Index out of range");
+		if (!used[index]) {
+			used[index] = true;
+			uniqueVertices++;
+		}
+		if (loadedAt[index] == 0 || misses - loadedAt[index] >= cacheSize) {
+			misses++;
+			loadedAt[index] = misses;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+	return stats;
+}
+
+void LveMeshOptimizer::optimizeVertexCache(
+	std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t> *clusters) {
+	const size_t triangleCount = indices.size() / 3;
+	if (clusters) clusters->clear();
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// vertex -> triangle adjacency
+	std::vector<uint32_t> liveTriangles(vertexCount, 0);
+	for (uint32_t index : indices) {
+		liveTriangles[index]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++) {
+			for (int k = 0; k < 3; k++) {
+				adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+			}
+		}
+	}
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t timestamp = cacheSize + 1;
+	size_t cursor = 0;
+	bool newCluster = true;
+
+	auto skipDeadEnd = [&]() -> int64_t {
+		while (!deadEnd.empty()) {
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[v] > 0) return v;
+		}
+		while (cursor < vertexCount) {
+			if (liveTriangles[cursor] > 0) return static_cast<int64_t>(cursor);
+			cursor++;
+		}
+		return -1;
+	};
+
+	int64_t fanning = skipDeadEnd();
+	while (fanning >= 0) {
+		if (newCluster && clusters) {
+			clusters->push_back(static_cast<uint32_t>(result.size()));
+		}
+		newCluster = false;
+
+		candidates.clear();
+		for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+			uint32_t t = adjacency[a];
+			if (emitted[t]) continue;
+			emitted[t] = true;
+
+			for (int k = 0; k < 3; k++) {
+				uint32_t v = indices[t * 3 + k];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (timestamp - cacheTime[v] > cacheSize) {
+					cacheTime[v] = timestamp++;
+				}
+			}
+		}
+
+		// prefer the oldest vertex that is still in the cache after emitting its fan
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t v : candidates) {
+			if (liveTriangles[v] == 0) continue;
+			int64_t priority = 0;
+			if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+				priority = timestamp - cacheTime[v];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next < 0) {
+			next = skipDeadEnd();
+			newCluster = true;
+		}
+		fanning = next;
+	}
+
+	assert(result.size() == indices.size() && "Tipsify dropped triangles");
+	indices.swap(result);
+}
+
+void LveMeshOptimizer::optimizeOverdraw(
+	std::vector<uint32_t> &indices, const std::vector<LveModel::Vertex> &vertices, const std::vector<uint32_t> &clusters) {
+	if (clusters.size() < 2) {
+		return;
+	}
+
+	struct Cluster {
+		uint32_t begin;
+		uint32_t end;
+		float sortKey;
+	};
+
+	// mesh centroid weighted by triangle area
+	glm::vec3 meshCentroid{0.f};
+	float meshArea = 0.f;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const glm::vec3 &a = vertices[indices[i]].position;
+		const glm::vec3 &b = vertices[indices[i + 1]].position;
+		const glm::vec3 &c = vertices[indices[i + 2]].position;
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCentroid += (a + b + c) * (area / 3.f);
+		meshArea += area;
+	}
+	if (meshArea > 0.f) {
+		meshCentroid = meshCentroid / meshArea;
+	}
+
+	std::vector<Cluster> sorted(clusters.size());
+	for (size_t i = 0; i < clusters.size(); i++) {
+		Cluster &cluster = sorted[i];
+		cluster.begin = clusters[i];
+		cluster.end = i + 1 < clusters.size() ? clusters[i + 1] : static_cast<uint32_t>(indices.size());
+
+		glm::vec3 centroid{0.f};
+		glm::vec3 normal{0.f};
+		float area = 0.f;
+		for (uint32_t j = cluster.begin; j < cluster.end; j += 3) {
+			const glm::vec3 &a = vertices[indices[j]].position;
+			const glm::vec3 &b = vertices[indices[j + 1]].position;
+			const glm::vec3 &c = vertices[indices[j + 2]].position;
+			glm::vec3 n = glm::cross(b - a, c - a);
+			float triangleArea = glm::length(n);
+			centroid += (a + b + c) * (triangleArea / 3.f);
+			normal += n;
+			area += triangleArea;
+		}
+
+		float normalLength = glm::length(normal);
+		if (area > 0.f && normalLength > 0.f) {
+			// how far the cluster sticks out of the mesh along its own facing direction
+			cluster.sortKey = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+		} else {
+			cluster.sortKey = 0.f;
+		}
+	}
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) {
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const Cluster &cluster : sorted) {
+		result.insert(result.end(), indices.begin() + cluster.begin, indices.begin() + cluster.end);
+	}
+	indices.swap(result);
+}
+
+void LveMeshOptimizer::optimizeVertexFetch(std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices) {
+	constexpr uint32_t UNUSED = ~0u;
+	std::vector<uint32_t> remap(vertices.size(), UNUSED);
+	std::vector<LveModel::Vertex> result;
+	result.reserve(vertices.size());
+
+	for (uint32_t &index : indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = static_cast<uint32_t>(result.size());
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(result);
+}
+
+}
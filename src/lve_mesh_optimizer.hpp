@@ -0,0 +1,36 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Index/vertex reordering passes run on Builder data before upload.
+class LveMeshOptimizer {
+public:
+	// Post-transform cache simulation with a FIFO of cacheSize entries.
+	static LveModel::VertexCacheStats analyzeVertexCache(
+		const std::vector<uint32_t> &indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+	// Tipsify (Sander et al. 2007) triangle reordering. When clusters is set it receives the
+	// first index of every cluster, i.e. every point where the walk had to restart.
+	static void optimizeVertexCache(
+		std::vector<uint32_t> &indices,
+		size_t vertexCount,
+		uint32_t cacheSize = 16,
+		std::vector<uint32_t> *clusters = nullptr);
+
+	// Sorts the clusters produced by optimizeVertexCache so that outward facing parts of the
+	// mesh are drawn first, which lets early-z reject more of what follows.
+	static void optimizeOverdraw(
+		std::vector<uint32_t> &indices,
+		const std::vector<LveModel::Vertex> &vertices,
+		const std::vector<uint32_t> &clusters);
+
+	// Renumbers vertices in order of first use and drops unreferenced ones.
+	static void optimizeVertexFetch(std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices);
+};
+
+}
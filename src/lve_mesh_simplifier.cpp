@@ -0,0 +1,347 @@
+#include "lve_mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace lve {
+
+namespace {
+
+// how much a unit change of normal/uv/color costs compared to a unit of squared distance
+constexpr double ATTRIBUTE_WEIGHT = 0.01;
+
+constexpr uint32_t NONE = ~0u;
+
+// symmetric 4x4 matrix of the summed squared plane distances, weighted by triangle area
+struct Quadric {
+	double xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+	double x = 0, y = 0, z = 0, c = 0;
+	double weight = 0;
+
+	void addPlane(const glm::vec3 &n, float d, double w) {
+		xx += w * n.x * n.x;
+		xy += w * n.x * n.y;
+		xz += w * n.x * n.z;
+		yy += w * n.y * n.y;
+		yz += w * n.y * n.z;
+		zz += w * n.z * n.z;
+		x += w * n.x * d;
+		y += w * n.y * d;
+		z += w * n.z * d;
+		c += w * d * d;
+		weight += w;
+	}
+
+	Quadric &operator+=(const Quadric &other) {
+		xx += other.xx;
+		xy += other.xy;
+		xz += other.xz;
+		yy += other.yy;
+		yz += other.yz;
+		zz += other.zz;
+		x += other.x;
+		y += other.y;
+		z += other.z;
+		c += other.c;
+		weight += other.weight;
+		return *this;
+	}
+
+	double evaluate(const glm::vec3 &p) const {
+		double px = p.x, py = p.y, pz = p.z;
+		double result = xx * px * px + yy * py * py + zz * pz * pz +
+			2 * (xy * px * py + xz * px * pz + yz * py * pz) +
+			2 * (x * px + y * py + z * pz) + c;
+		return std::max(result, 0.0);
+	}
+};
+
+struct Collapse {
+	uint32_t from;
+	uint32_t to;
+	double cost;   // geometric error plus the attribute penalty, decides the order
+	double error;  // geometric error only, checked against the limit and reported
+};
+
+inline double attributeDistance(const LveModel::Vertex &a, const LveModel::Vertex &b) {
+	glm::vec3 normal = a.normal - b.normal;
+	glm::vec3 color = a.color - b.color;
+	glm::vec2 uv = a.uv - b.uv;
+	return glm::dot(normal, normal) + glm::dot(color, color) + glm::dot(uv, uv);
+}
+
+}  // namespace
+
+LveMeshSimplifier::LveMeshSimplifier(const std::vector<LveModel::Vertex> &vertices) : vertices{vertices} {
+	positionIds.resize(vertices.size());
+	if (vertices.empty()) {
+		return;
+	}
+
+	// vertices with bitwise different attributes but the same position share one id
+	std::vector<uint32_t> order(vertices.size());
+	std::iota(order.begin(), order.end(), 0u);
+	auto less = [&](uint32_t a, uint32_t b) {
+		const glm::vec3 &pa = vertices[a].position;
+		const glm::vec3 &pb = vertices[b].position;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		return pa.z < pb.z;
+	};
+	std::sort(order.begin(), order.end(), less);
+
+	glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+	glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+	for (size_t i = 0; i < order.size(); i++) {
+		if (i == 0 || less(order[i - 1], order[i])) {
+			positions.push_back(vertices[order[i]].position);
+			boundsMin = glm::min(boundsMin, positions.back());
+			boundsMax = glm::max(boundsMax, positions.back());
+		}
+		positionIds[order[i]] = static_cast<uint32_t>(positions.size() - 1);
+	}
+
+	float diagonal = glm::length(boundsMax - boundsMin);
+	float scale = diagonal > 0.f ? 1.f / diagonal : 1.f;
+	for (auto &position : positions) {
+		position = (position - boundsMin) * scale;
+	}
+}
+
+float LveMeshSimplifier::simplify(std::vector<uint32_t> &indices, size_t targetIndexCount, float targetError) {
+	const size_t positionCount = positions.size();
+	auto pid = [this](uint32_t vertex) { return positionIds[vertex]; };
+
+	// triangles that are already degenerate only get in the way of the topology checks
+	{
+		size_t out = 0;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (pid(a) != pid(b) && pid(b) != pid(c) && pid(a) != pid(c)) {
+				indices[out++] = a;
+				indices[out++] = b;
+				indices[out++] = c;
+			}
+		}
+		indices.resize(out);
+	}
+
+	std::vector<Quadric> quadrics(positionCount);
+	std::vector<double> wedgeArea(vertices.size(), 0.0);
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		const glm::vec3 &p0 = positions[pid(indices[i])];
+		const glm::vec3 &p1 = positions[pid(indices[i + 1])];
+		const glm::vec3 &p2 = positions[pid(indices[i + 2])];
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(normal);
+		if (area == 0.f) continue;
+		normal = normal / area;
+		float d = -glm::dot(normal, p0);
+		for (int k = 0; k < 3; k++) {
+			quadrics[pid(indices[i + k])].addPlane(normal, d, area);
+			wedgeArea[indices[i + k]] += area;
+		}
+	}
+
+	std::vector<uint32_t> remap(vertices.size());
+	std::iota(remap.begin(), remap.end(), 0u);
+
+	std::vector<uint32_t> triangleOffsets(positionCount + 1);
+	std::vector<uint32_t> triangles;
+	std::vector<uint8_t> locked(positionCount);
+	std::vector<uint8_t> touched(positionCount);
+	std::vector<uint32_t> marks(positionCount, 0);
+	uint32_t mark = 0;
+
+	std::vector<Collapse> collapses;
+	std::vector<std::pair<uint32_t, uint32_t>> neighbours;       // position, triangle count
+	std::vector<std::pair<uint32_t, uint32_t>> otherNeighbours;
+	std::vector<std::pair<uint32_t, uint32_t>> wedges;           // vertex at from, vertex at to
+
+	auto gatherNeighbours = [&](uint32_t position, std::vector<std::pair<uint32_t, uint32_t>> &out) {
+		out.clear();
+		for (uint32_t t = triangleOffsets[position]; t < triangleOffsets[position + 1]; t++) {
+			const uint32_t *corners = &indices[triangles[t] * 3];
+			for (int k = 0; k < 3; k++) {
+				uint32_t other = pid(corners[k]);
+				if (other == position) continue;
+				auto it = std::find_if(out.begin(), out.end(), [other](const auto &n) { return n.first == other; });
+				if (it == out.end()) {
+					out.push_back({other, 1});
+				} else {
+					it->second++;
+				}
+			}
+		}
+	};
+
+	// every vertex at `from` needs exactly one vertex at `to` to become, taken from the
+	// triangles that are removed by the collapse. Fails for seam vertices collapsing across
+	// the seam since one side has no such triangle.
+	auto mapWedges = [&](uint32_t from, uint32_t to) {
+		wedges.clear();
+		for (uint32_t t = triangleOffsets[from]; t < triangleOffsets[from + 1]; t++) {
+			const uint32_t *corners = &indices[triangles[t] * 3];
+			uint32_t wedge = NONE;
+			uint32_t target = NONE;
+			for (int k = 0; k < 3; k++) {
+				if (pid(corners[k]) == from) wedge = corners[k];
+				if (pid(corners[k]) == to) target = corners[k];
+			}
+
+			auto it = std::find_if(wedges.begin(), wedges.end(), [wedge](const auto &w) { return w.first == wedge; });
+			if (it == wedges.end()) {
+				wedges.push_back({wedge, target});
+			} else if (target != NONE) {
+				if (it->second == NONE) {
+					it->second = target;
+				} else if (it->second != target) {
+					return false;
+				}
+			}
+		}
+		return std::all_of(wedges.begin(), wedges.end(), [](const auto &w) { return w.second != NONE; });
+	};
+
+	// an interior edge must have exactly two common neighbours or the result is non-manifold
+	auto linkCondition = [&](uint32_t from, uint32_t to) {
+		gatherNeighbours(from, neighbours);
+		gatherNeighbours(to, otherNeighbours);
+		mark++;
+		for (const auto &n : neighbours) marks[n.first] = mark;
+		int common = 0;
+		for (const auto &n : otherNeighbours) {
+			if (marks[n.first] == mark) common++;
+		}
+		return common == 2;
+	};
+
+	auto flipsTriangle = [&](uint32_t from, uint32_t to) {
+		const glm::vec3 &target = positions[to];
+		for (uint32_t t = triangleOffsets[from]; t < triangleOffsets[from + 1]; t++) {
+			const uint32_t *corners = &indices[triangles[t] * 3];
+			glm::vec3 before[3], after[3];
+			bool removed = false;
+			for (int k = 0; k < 3; k++) {
+				uint32_t p = pid(corners[k]);
+				removed = removed || p == to;
+				before[k] = positions[p];
+				after[k] = p == from ? target : before[k];
+			}
+			if (removed) continue;
+
+			glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+			if (glm::dot(n0, n1) <= 0.f) return true;
+		}
+		return false;
+	};
+
+	const double errorLimit = static_cast<double>(targetError) * targetError;
+	double maxError = 0.0;
+
+	while (indices.size() > targetIndexCount) {
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+		// position -> triangle adjacency
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+		for (uint32_t index : indices) triangleOffsets[pid(index) + 1]++;
+		for (size_t p = 0; p < positionCount; p++) triangleOffsets[p + 1] += triangleOffsets[p];
+		triangles.resize(indices.size());
+		{
+			std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for (uint32_t t = 0; t < triangleCount; t++) {
+				for (int k = 0; k < 3; k++) triangles[fill[pid(indices[t * 3 + k])]++] = t;
+			}
+		}
+
+		// an edge used by anything but two triangles is a border or non-manifold
+		for (uint32_t p = 0; p < positionCount; p++) {
+			gatherNeighbours(p, neighbours);
+			locked[p] = std::any_of(neighbours.begin(), neighbours.end(), [](const auto &n) { return n.second != 2; });
+		}
+
+		collapses.clear();
+		for (uint32_t p = 0; p < positionCount; p++) {
+			if (locked[p] || triangleOffsets[p] == triangleOffsets[p + 1]) continue;
+
+			gatherNeighbours(p, otherNeighbours);
+			Collapse best{p, NONE, std::numeric_limits<double>::max(), 0.0};
+			for (const auto &n : otherNeighbours) {
+				uint32_t q = n.first;
+				if (!mapWedges(p, q)) continue;
+
+				Quadric combined = quadrics[p];
+				combined += quadrics[q];
+				double error = combined.evaluate(positions[q]);
+				double attributeError = 0.0;
+				for (const auto &w : wedges) {
+					attributeError += wedgeArea[w.first] * attributeDistance(vertices[w.first], vertices[w.second]);
+				}
+				if (combined.weight > 0.0) {
+					error /= combined.weight;
+					attributeError /= combined.weight;
+				}
+
+				double cost = error + ATTRIBUTE_WEIGHT * attributeError;
+				if (cost < best.cost) {
+					best.to = q;
+					best.cost = cost;
+					best.error = error;
+				}
+			}
+			if (best.to != NONE) {
+				collapses.push_back(best);
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+		// collapses whose neighbourhoods don't overlap can all run in one pass
+		std::fill(touched.begin(), touched.end(), uint8_t{0});
+		size_t remaining = triangleCount;
+		size_t collapsed = 0;
+		for (const Collapse &collapse : collapses) {
+			if (remaining * 3 <= targetIndexCount) break;
+			if (collapse.error > errorLimit) continue;
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+			if (!linkCondition(collapse.from, collapse.to) || flipsTriangle(collapse.from, collapse.to)) continue;
+
+			mapWedges(collapse.from, collapse.to);
+			for (const auto &w : wedges) {
+				remap[w.first] = w.second;
+				wedgeArea[w.second] += wedgeArea[w.first];
+			}
+			quadrics[collapse.to] += quadrics[collapse.from];
+
+			touched[collapse.from] = 1;
+			touched[collapse.to] = 1;
+			for (const auto &n : neighbours) touched[n.first] = 1;
+
+			maxError = std::max(maxError, collapse.error);
+			remaining -= 2;
+			collapsed++;
+		}
+		if (collapsed == 0) {
+			break;
+		}
+
+		size_t out = 0;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+			if (pid(a) != pid(b) && pid(b) != pid(c) && pid(a) != pid(c)) {
+				indices[out++] = a;
+				indices[out++] = b;
+				indices[out++] = c;
+			}
+		}
+		indices.resize(out);
+	}
+
+	return static_cast<float>(std::sqrt(maxError));
+}
+
+}
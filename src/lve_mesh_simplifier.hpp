@@ -0,0 +1,37 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Quadric error metric edge collapse (Garland & Heckbert 1997) over Builder data.
+//
+// Collapses move a vertex onto one of its neighbours, so simplified index lists keep
+// referencing the original vertex array and every LOD can share one vertex buffer.
+// Vertices that share a position but differ in color/normal/uv (attribute seams) only
+// collapse along the seam, and the attribute change is added to the collapse cost.
+// Open borders and non-manifold vertices never move.
+//
+// Errors are relative to the diagonal of the mesh bounds.
+class LveMeshSimplifier {
+public:
+	explicit LveMeshSimplifier(const std::vector<LveModel::Vertex> &vertices);
+
+	LveMeshSimplifier(const LveMeshSimplifier &) = delete;
+	LveMeshSimplifier &operator=(const LveMeshSimplifier &) = delete;
+
+	// Collapses edges of the triangle list in place until it has at most targetIndexCount
+	// indices or the next collapse would cost more than targetError. Returns the largest
+	// error of any collapse that was made.
+	float simplify(std::vector<uint32_t> &indices, size_t targetIndexCount, float targetError);
+
+private:
+	const std::vector<LveModel::Vertex> &vertices;
+	std::vector<uint32_t> positionIds;  // vertex -> unique position
+	std::vector<glm::vec3> positions;   // unique positions scaled to a unit diagonal
+};
+
+}
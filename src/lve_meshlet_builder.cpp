@@ -0,0 +1,259 @@
+#include "lve_meshlet_builder.hpp"
+#include "lve_mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace lve {
+
+namespace {
+
+// normal cones are only worth having when they are narrower than this (cos of the half angle)
+constexpr float MIN_CONE_DOT = 0.f;
+
+inline glm::vec3 triangleNormal(const std::vector<LveModel::Vertex> &vertices, const uint32_t *corners) {
+	const glm::vec3 &a = vertices[corners[0]].position;
+	const glm::vec3 &b = vertices[corners[1]].position;
+	const glm::vec3 &c = vertices[corners[2]].position;
+	glm::vec3 normal = glm::cross(b - a, c - a);
+	float length = glm::length(normal);
+	return length > 0.f ? normal / length : glm::vec3{0.f};
+}
+
+// vertex -> unique position, flat shaded meshes share no vertices but still have neighbours
+uint32_t weldPositions(const std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &positionIds) {
+	std::vector<uint32_t> order(vertices.size());
+	for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+	auto less = [&](uint32_t a, uint32_t b) {
+		const glm::vec3 &pa = vertices[a].position;
+		const glm::vec3 &pb = vertices[b].position;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		return pa.z < pb.z;
+	};
+	std::sort(order.begin(), order.end(), less);
+
+	positionIds.resize(vertices.size());
+	uint32_t positionCount = 0;
+	for (size_t i = 0; i < order.size(); i++) {
+		if (i > 0 && less(order[i - 1], order[i])) positionCount++;
+		positionIds[order[i]] = positionCount;
+	}
+	return order.empty() ? 0 : positionCount + 1;
+}
+
+// Tipsify inside the meshlet, on indices local to it so the 64 vertex meshlet doesn't pay
+// for the whole vertex buffer
+void optimizeMeshlet(uint32_t *indices, uint32_t indexCount, std::vector<uint32_t> &localIndices, std::vector<uint32_t> &globalIndices) {
+	localIndices.resize(indexCount);
+	globalIndices.clear();
+	for (uint32_t i = 0; i < indexCount; i++) {
+		auto it = std::find(globalIndices.begin(), globalIndices.end(), indices[i]);
+		localIndices[i] = static_cast<uint32_t>(it - globalIndices.begin());
+		if (it == globalIndices.end()) globalIndices.push_back(indices[i]);
+	}
+	LveMeshOptimizer::optimizeVertexCache(localIndices, globalIndices.size());
+	for (uint32_t i = 0; i < indexCount; i++) {
+		indices[i] = globalIndices[localIndices[i]];
+	}
+}
+
+LveModel::Meshlet computeBounds(
+	const std::vector<LveModel::Vertex> &vertices,
+	const uint32_t *indices,
+	uint32_t firstIndex,
+	uint32_t indexCount,
+	bool cone) {
+	LveModel::Meshlet meshlet{};
+	meshlet.firstIndex = firstIndex;
+	meshlet.indexCount = indexCount;
+
+	glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+	glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+		boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+	}
+	meshlet.center = (boundsMin + boundsMax) * 0.5f;
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+		meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].position - meshlet.center));
+	}
+
+	// cutoff 1 never passes the backface test
+	meshlet.coneAxis = glm::vec3{0.f, 0.f, 1.f};
+	meshlet.coneCutoff = 1.f;
+	if (!cone) {
+		return meshlet;
+	}
+
+	glm::vec3 normalSum{0.f};
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i += 3) {
+		normalSum += triangleNormal(vertices, indices + i);
+	}
+	float length = glm::length(normalSum);
+	if (length == 0.f) {
+		return meshlet;
+	}
+
+	glm::vec3 axis = normalSum / length;
+	float minDot = 1.f;
+	for (uint32_t i = firstIndex; i < firstIndex + indexCount; i += 3) {
+		glm::vec3 normal = triangleNormal(vertices, indices + i);
+		if (normal != glm::vec3{0.f}) {
+			minDot = std::min(minDot, glm::dot(axis, normal));
+		}
+	}
+	if (minDot > MIN_CONE_DOT) {
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+	}
+	return meshlet;
+}
+
+}  // namespace
+
+std::vector<LveModel::Meshlet> LveMeshletBuilder::build(
+	const std::vector<LveModel::Vertex> &vertices,
+	uint32_t *indices,
+	uint32_t indexCount,
+	uint32_t maxVertices,
+	uint32_t maxTriangles) {
+	assert(maxVertices >= 3 && maxTriangles >= 1 && "Meshlets must hold at least one triangle");
+
+	std::vector<LveModel::Meshlet> meshlets;
+	const uint32_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return meshlets;
+	}
+
+	std::vector<uint32_t> positionIds;
+	const uint32_t positionCount = weldPositions(vertices, positionIds);
+
+	// back faces are drawn (cull mode none), so the inside of an open mesh can be visible
+	// through its opening and only closed meshes get backface cones
+	const bool cones = isClosed(positionIds, indices, indexCount);
+
+	// position -> triangle adjacency
+	std::vector<uint32_t> adjacencyOffsets(positionCount + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) adjacencyOffsets[positionIds[indices[i]] + 1]++;
+	for (uint32_t p = 0; p < positionCount; p++) adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < triangleCount * 3; i++) adjacency[fill[positionIds[indices[i]]]++] = i / 3;
+	}
+
+	std::vector<glm::vec3> normals(triangleCount);
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		normals[t] = triangleNormal(vertices, indices + t * 3);
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> vertexMeshlet(vertices.size(), ~0u);
+	std::vector<uint32_t> positionMeshlet(positionCount, ~0u);
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> localIndices;
+	std::vector<uint32_t> globalIndices;
+	uint32_t seed = 0;
+
+	while (result.size() < triangleCount * 3) {
+		while (emitted[seed]) seed++;
+
+		const uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+		const uint32_t firstIndex = static_cast<uint32_t>(result.size());
+		uint32_t meshletVertices = 0;
+		uint32_t meshletTriangles = 0;
+		glm::vec3 normalSum{0.f};
+		candidates.clear();
+
+		auto newVertices = [&](uint32_t t) {
+			uint32_t count = 0;
+			for (int k = 0; k < 3; k++) count += vertexMeshlet[indices[t * 3 + k]] != meshletId;
+			return count;
+		};
+
+		auto add = [&](uint32_t t) {
+			emitted[t] = 1;
+			meshletTriangles++;
+			normalSum += normals[t];
+			for (int k = 0; k < 3; k++) {
+				uint32_t v = indices[t * 3 + k];
+				result.push_back(v);
+				if (vertexMeshlet[v] != meshletId) {
+					vertexMeshlet[v] = meshletId;
+					meshletVertices++;
+				}
+
+				uint32_t p = positionIds[v];
+				if (positionMeshlet[p] == meshletId) continue;
+				positionMeshlet[p] = meshletId;
+				for (uint32_t a = adjacencyOffsets[p]; a < adjacencyOffsets[p + 1]; a++) {
+					if (!emitted[adjacency[a]]) candidates.push_back(adjacency[a]);
+				}
+			}
+		};
+
+		add(seed);
+		while (meshletTriangles < maxTriangles) {
+			uint32_t best = ~0u;
+			uint32_t bestNew = 4;
+			float bestDot = -2.f;
+			size_t live = 0;
+			for (uint32_t t : candidates) {
+				if (emitted[t]) continue;
+				candidates[live++] = t;
+
+				uint32_t extra = newVertices(t);
+				if (meshletVertices + extra > maxVertices) continue;
+				float dot = glm::dot(normals[t], normalSum);
+				if (extra < bestNew || (extra == bestNew && dot > bestDot)) {
+					best = t;
+					bestNew = extra;
+					bestDot = dot;
+				}
+			}
+			candidates.resize(live);
+
+			if (best == ~0u) break;
+			add(best);
+		}
+
+		const uint32_t meshletIndexCount = static_cast<uint32_t>(result.size()) - firstIndex;
+		optimizeMeshlet(result.data() + firstIndex, meshletIndexCount, localIndices, globalIndices);
+		meshlets.push_back(computeBounds(vertices, result.data(), firstIndex, meshletIndexCount, cones));
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+	return meshlets;
+}
+
+bool LveMeshletBuilder::isClosed(const std::vector<uint32_t> &positionIds, const uint32_t *indices, uint32_t indexCount) {
+	std::vector<std::pair<uint32_t, uint32_t>> edges;
+	edges.reserve(indexCount);
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+		uint32_t corners[3] = {positionIds[indices[i]], positionIds[indices[i + 1]], positionIds[indices[i + 2]]};
+		// degenerate triangles (e.g. at the poles of a UV sphere) don't border anything
+		if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0]) continue;
+		for (int k = 0; k < 3; k++) {
+			uint32_t a = corners[k];
+			uint32_t b = corners[(k + 1) % 3];
+			edges.push_back({std::min(a, b), std::max(a, b)});
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+
+	for (size_t i = 0; i < edges.size();) {
+		size_t j = i;
+		while (j < edges.size() && edges[j] == edges[i]) j++;
+		if (j - i != 2) return false;
+		i = j;
+	}
+	return true;
+}
+
+}
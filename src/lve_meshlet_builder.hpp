@@ -0,0 +1,30 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Splits a triangle list into meshlets of at most maxVertices unique vertices and
+// maxTriangles triangles, reordering the indices so every meshlet is a contiguous range.
+//
+// Meshlets grow from a seed triangle by repeatedly adding the neighbouring triangle that
+// brings in the fewest new vertices, ties going to the one facing most like the meshlet,
+// which keeps them compact and their normal cones narrow.
+class LveMeshletBuilder {
+public:
+	static std::vector<LveModel::Meshlet> build(
+		const std::vector<LveModel::Vertex> &vertices,
+		uint32_t *indices,
+		uint32_t indexCount,
+		uint32_t maxVertices,
+		uint32_t maxTriangles);
+
+private:
+	// true when every edge between distinct positions is shared by exactly two triangles
+	static bool isClosed(const std::vector<uint32_t> &positionIds, const uint32_t *indices, uint32_t indexCount);
+};
+
+}
@@ -0,0 +1,47 @@
+#include "lve_meshlet_culler.hpp"
+
+#include <cassert>
+
+namespace lve {
+
+void LveMeshletCuller::markVisible(
+	const std::vector<LveModel::Meshlet> &meshlets,
+	const LveFrustum &frustum,
+	const glm::vec3 &cameraPosition,
+	std::vector<uint8_t> &visible) {
+	assert(visible.size() == meshlets.size() && "One visibility flag per meshlet");
+	for (size_t i = 0; i < meshlets.size(); i++) {
+		const auto &meshlet = meshlets[i];
+		if (visible[i] || !frustum.intersectsSphere(meshlet.center, meshlet.radius) || isBackfacing(meshlet, cameraPosition)) {
+			continue;
+		}
+		visible[i] = 1;
+	}
+}
+
+uint32_t LveMeshletCuller::collectRanges(
+	const std::vector<LveModel::Meshlet> &meshlets,
+	const std::vector<uint8_t> &visible,
+	std::vector<Range> &ranges) {
+	uint32_t triangles = 0;
+	for (size_t i = 0; i < meshlets.size(); i++) {
+		if (!visible[i]) continue;
+
+		const auto &meshlet = meshlets[i];
+		triangles += meshlet.indexCount / 3;
+		if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex) {
+			ranges.back().indexCount += meshlet.indexCount;
+		} else {
+			ranges.push_back({meshlet.firstIndex, meshlet.indexCount});
+		}
+	}
+	return triangles;
+}
+
+bool LveMeshletCuller::isBackfacing(const LveModel::Meshlet &meshlet, const glm::vec3 &cameraPosition) {
+	// every triangle faces away from every point of the bounding sphere (Wihlidal 2016)
+	glm::vec3 toCenter = meshlet.center - cameraPosition;
+	return glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
+
+}
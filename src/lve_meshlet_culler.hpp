@@ -0,0 +1,38 @@
+#pragma once
+
+#include "lve_frustum.hpp"
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// CPU side meshlet culling, everything is in the model space of the meshlets.
+class LveMeshletCuller {
+public:
+	struct Range {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	// Marks the meshlets that pass the frustum and backface cone tests as seen from one
+	// instance, visible holds a flag per meshlet. Instances drawn together mark the same
+	// flags, so the draw covers what any of them can see.
+	static void markVisible(
+		const std::vector<LveModel::Meshlet> &meshlets,
+		const LveFrustum &frustum,
+		const glm::vec3 &cameraPosition,
+		std::vector<uint8_t> &visible);
+
+	// Appends the marked meshlets to ranges, merging neighbours in the index buffer into one
+	// range. Returns the number of visible triangles.
+	static uint32_t collectRanges(
+		const std::vector<LveModel::Meshlet> &meshlets,
+		const std::vector<uint8_t> &visible,
+		std::vector<Range> &ranges);
+
+	static bool isBackfacing(const LveModel::Meshlet &meshlet, const glm::vec3 &cameraPosition);
+};
+
+}
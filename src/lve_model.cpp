@@ -1,120 +1,263 @@
 #include "lve_model.hpp"
 #include "lve_buffer.hpp"
-#include "lve_utils.hpp"
+#include "lve_index_ranges.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_simplifier.hpp"
+#include "lve_meshlet_builder.hpp"
+#include "lve_obj_parser.hpp"
+#include "lve_upload_batch.hpp"
+#include "lve_vertex_quantizer.hpp"
+#include "lve_vertex_welder.hpp"
 #include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
-#include <unordered_map>
+#include <limits>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+namespace lve {
 
+namespace {
 
-namespace std {
-template <>
-struct hash<lve::LveModel::Vertex> {
-  size_t operator()(lve::LveModel::Vertex const &vertex) const {
-    size_t seed = 0;
-    lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-    return seed;
-  }
-};
+// a LOD that doesn't remove at least 15% of the previous one's triangles is not worth keeping
+constexpr float MIN_LOD_REDUCTION = 0.85f;
+
+}  // namespace
+
+LveModel::LveModel(LveDevice &device, LveGeometryArena &arena, const LveModel::Builder &builder)
+	: lveDevice{device}, geometryArena{arena}, vertexFormat{builder.vertexFormat} {
+	createVertexBuffers(builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()));
+	createIndexBuffers(
+		builder.indices.data(),
+		static_cast<uint32_t>(builder.indices.size()),
+		builder.lods.data(),
+		static_cast<uint32_t>(builder.lods.size()));
+	createLods(builder.lods.data(), static_cast<uint32_t>(builder.lods.size()));
+	createMeshlets(builder.meshlets.data(), static_cast<uint32_t>(builder.meshlets.size()));
+	uploadToken = arena.getPendingToken();
 }
 
-namespace lve {
-LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder) : lveDevice{device} {
-	createVertexBuffers(builder.vertices);
-	createIndexBuffers(builder.indices);
+LveModel::LveModel(LveDevice &device, LveGeometryArena &arena, const LveMeshCache &cache, VertexFormat format)
+	: lveDevice{device}, geometryArena{arena}, vertexFormat{format} {
+	// geometry is written straight from the mapped cache file
+	createVertexBuffers(cache.vertices(), cache.vertexCount());
+	createIndexBuffers(cache.indices(), cache.indexCount(), cache.lods(), cache.lodCount());
+	createLods(cache.lods(), cache.lodCount());
+	createMeshlets(cache.meshlets(), cache.meshletCount());
+	uploadToken = arena.getPendingToken();
 }
 
-LveModel::~LveModel() {}
+LveModel::~LveModel() {
+	geometryArena.freeVertices(vertexAllocation);
+	geometryArena.freeIndices(indexAllocation);
+}
 
-std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath) {
+std::unique_ptr<LveModel> LveModel::createModelFromFile(
+	LveDevice &device, LveGeometryArena &arena, const std::string &filepath, VertexFormat format) {
 	Builder builder{};
+	builder.vertexFormat = format;
+	// the cache always holds full vertices, quantizing them again on load is cheap
+	if (auto cache = prepareModelData(filepath, builder)) {
+		return std::make_unique<LveModel>(device, arena, *cache, format);
+	}
+	return std::make_unique<LveModel>(device, arena, builder);
+}
+
+std::unique_ptr<LveMeshCache> LveModel::prepareModelData(const std::string &filepath, Builder &builder) {
+	if (auto cache = LveMeshCache::open(filepath)) {
+		return cache;
+	}
+
 	builder.loadModel(filepath);
-	return std::make_unique<LveModel>(device, builder);
+	builder.optimize();
+	builder.buildMeshlets();
+	builder.generateLods();
+	// a read-only asset directory just means we parse again next time
+	LveMeshCache::write(filepath, builder);
+	return nullptr;
 }
 
-void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
-	vertexCount = static_cast<uint32_t>(vertices.size());
+void LveModel::createVertexBuffers(const Vertex *vertices, uint32_t count) {
+	vertexCount = count;
 
 	assert(vertexCount >= 3 && "Vertex count must be at least 3");
 
-	VkDeviceSize buffersize = sizeof(vertices[0]) * vertexCount;
+	uint32_t vertexSize = vertexFormat == VertexFormat::Quantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+	VkDeviceSize buffersize = vertexSize * vertexCount;
 
-	uint32_t vertexSize = sizeof(vertices[0]);
+	boundsMin = glm::vec3{std::numeric_limits<float>::max()};
+	boundsMax = glm::vec3{std::numeric_limits<float>::lowest()};
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		boundsMin = glm::min(boundsMin, vertices[i].position);
+		boundsMax = glm::max(boundsMax, vertices[i].position);
+	}
+	boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+	vertexAllocation = geometryArena.allocateVertices(vertexCount, vertexSize);
+	baseVertex = static_cast<int32_t>(vertexAllocation.offset / vertexSize);
+
+	// either the final buffer or staging memory for the device's next upload batch submit
+	void *destination = geometryArena.writeVertices(vertexAllocation);
+	if (vertexFormat == VertexFormat::Quantized) {
+		// encode straight into the destination memory
+		LveVertexQuantizer quantizer = LveVertexQuantizer::fromVertices(vertices, vertexCount);
+		positionTransform = quantizer.positionTransform();
+		auto *quantized = static_cast<QuantizedVertex *>(destination);
+		for (uint32_t i = 0; i < vertexCount; i++) {
+			quantized[i] = quantizer.encode(vertices[i]);
+		}
+	} else {
+		positionTransform = glm::mat4{1.f};
+		std::memcpy(destination, vertices, buffersize);
+	}
+}
 
-	LveBuffer stagingBuffer{
-		lveDevice,
-		vertexSize,
-		vertexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
+void LveModel::createIndexBuffers(const uint32_t *indices, uint32_t count, const Lod *lodData, uint32_t lodCount) {
+	indexCount = count;
+	hasIndexBuffer = indexCount > 0;
+	indexRanges.clear();
 
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer((void *)vertices.data());
+	if (!hasIndexBuffer) {
+		return;
+	}
 
-	vertexBuffer = std::make_unique<LveBuffer>(
-		lveDevice,
-		vertexSize,
-		vertexCount,
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	indexRanges = split16BitIndexRanges(indices, indexCount, vertexCount, lodData, lodCount);
+	indexType = indexRanges.empty() ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+	if (indexRanges.empty()) {
+		indexRanges.push_back({0, indexCount, 0});
+	}
 
-	lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), buffersize);
+	uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	VkDeviceSize buffersize = indexSize * indexCount;
+
+	indexAllocation = geometryArena.allocateIndices(indexCount, indexSize);
+	baseIndex = static_cast<uint32_t>(indexAllocation.offset / indexSize);
+
+	void *destination = geometryArena.writeIndices(indexAllocation);
+	if (indexType == VK_INDEX_TYPE_UINT16) {
+		// narrow straight into the destination memory, relative to each range's base vertex
+		auto *narrow = static_cast<uint16_t *>(destination);
+		for (const IndexRange &range : indexRanges) {
+			for (uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i++) {
+				narrow[i] = static_cast<uint16_t>(indices[i] - static_cast<uint32_t>(range.vertexOffset));
+			}
+		}
+	} else {
+		std::memcpy(destination, indices, buffersize);
+	}
 }
 
-void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
-	indexCount = static_cast<uint32_t>(indices.size());
-	hasIndexBuffer = indices.size() > 0;
-
+void LveModel::createLods(const Lod *lodData, uint32_t count) {
+	lods.clear();
 	if (!hasIndexBuffer) {
+		lodThresholds.clear();
 		return;
 	}
 
-	VkDeviceSize buffersize = sizeof(indices[0]) * indexCount;
-	uint32_t indexSize = sizeof(indices[0]);
+	if (count == 0) {
+		lods.push_back({0, indexCount, 0.f});
+	} else {
+		lods.assign(lodData, lodData + count);
+	}
+
+	// an error of e relative to the bounds is e * screenSize on screen
+	std::vector<float> thresholds(lods.size());
+	for (size_t i = 0; i < lods.size(); i++) {
+		thresholds[i] = lods[i].error > 0.f ? DEFAULT_LOD_SCREEN_ERROR / lods[i].error : std::numeric_limits<float>::infinity();
+	}
+	thresholds[0] = std::numeric_limits<float>::infinity();
+	setLodThresholds(std::move(thresholds));
+}
 
-	LveBuffer stagingBuffer{
-		lveDevice,
-		indexSize,
-		indexCount,
-		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-	};
+bool LveModel::isResident() const {
+	return lveDevice.getUploadBatch().isComplete(uploadToken);
+}
+
+uint32_t LveModel::nextId() {
+	// models are built on the streaming threads too
+	static std::atomic<uint32_t> counter{0};
+	return counter.fetch_add(1, std::memory_order_relaxed);
+}
 
-	stagingBuffer.map();
-	stagingBuffer.writeToBuffer((void *)indices.data());
+void LveModel::createMeshlets(const Meshlet *meshletData, uint32_t count) {
+	meshlets.clear();
+	if (hasIndexBuffer) {
+		meshlets.assign(meshletData, meshletData + count);
+	}
+}
 
-	indexBuffer = std::make_unique<LveBuffer>(
-		lveDevice,
-		indexSize,
-		indexCount,
-		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+void LveModel::setLodThresholds(std::vector<float> thresholds) {
+	assert(thresholds.size() == lods.size() && "Need one LOD threshold per LOD");
+	lodThresholds = std::move(thresholds);
+}
 
-	lveDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), buffersize);	
+uint32_t LveModel::selectLod(float screenSize) const {
+	uint32_t lod = 0;
+	for (uint32_t i = 1; i < lodThresholds.size(); i++) {
+		if (screenSize <= lodThresholds[i]) lod = i;
+	}
+	return lod;
 }
 
-void LveModel::draw(VkCommandBuffer commandBuffer) {
+void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance) {
 	if (hasIndexBuffer) {
-		vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+		assert(lod < lods.size() && "LOD out of range");
+		drawIndexed(commandBuffer, lods[lod].firstIndex, lods[lod].indexCount, instanceCount, firstInstance);
 	} else {
-		vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+		vkCmdDraw(commandBuffer, vertexCount, instanceCount, static_cast<uint32_t>(baseVertex), firstInstance);
 	}
 }
 
-void LveModel::bind(VkCommandBuffer commandBuffer) {
-	VkBuffer buffers[] = {vertexBuffer->getBuffer()};
-	VkDeviceSize offsets[] = {0};
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+void LveModel::drawIndexed(
+	VkCommandBuffer commandBuffer,
+	uint32_t firstIndex,
+	uint32_t count,
+	uint32_t instanceCount,
+	uint32_t firstInstance) {
+	forEachDrawCommand(firstIndex, count, instanceCount, firstInstance, [commandBuffer](const VkDrawIndexedIndirectCommand &command) {
+		vkCmdDrawIndexed(
+			commandBuffer,
+			command.indexCount,
+			command.instanceCount,
+			command.firstIndex,
+			command.vertexOffset,
+			command.firstInstance);
+	});
+}
+
+void LveModel::appendDrawCommands(
+	uint32_t firstIndex,
+	uint32_t count,
+	uint32_t instanceCount,
+	uint32_t firstInstance,
+	std::vector<VkDrawIndexedIndirectCommand> &commands) const {
+	forEachDrawCommand(firstIndex, count, instanceCount, firstInstance, [&commands](const VkDrawIndexedIndirectCommand &command) {
+		commands.push_back(command);
+	});
+}
 
+template <typename F>
+void LveModel::forEachDrawCommand(uint32_t firstIndex, uint32_t count, uint32_t instanceCount, uint32_t firstInstance, F &&f) const {
+	assert(hasIndexBuffer && firstIndex + count <= indexCount && "Index range out of bounds");
+
+	// The range can straddle the 16 bit ranges of a split mesh. Indices are relative to the
+	// model, its ranges start at baseIndex and baseVertex in the arena's shared buffers.
+	for (const IndexRange &range : indexRanges) {
+		uint32_t begin = std::max(firstIndex, range.firstIndex);
+		uint32_t end = std::min(firstIndex + count, range.firstIndex + range.indexCount);
+		if (begin < end) {
+			f(VkDrawIndexedIndirectCommand{end - begin, instanceCount, baseIndex + begin, baseVertex + range.vertexOffset, firstInstance});
+		}
+	}
+}
+
+void LveModel::bind(LveCommandRecorder &recorder) const {
+	geometryArena.bindVertexBuffer(recorder);
 	if (hasIndexBuffer) {
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		geometryArena.bindIndexBuffer(recorder, indexType);
 	}
 }
 
@@ -139,59 +282,123 @@ std::vector<VkVertexInputAttributeDescription> LveModel::Vertex::getAttributeDes
 	return attributeDescriptions;
 }
 
-void LveModel::Builder::loadModel(const std::string &filepath) {
-  tinyobj::attrib_t attrib;
-  std::vector<tinyobj::shape_t> shapes;
-  std::vector<tinyobj::material_t> materials;
-  std::string warn, err;
+std::vector<VkVertexInputBindingDescription> LveModel::QuantizedVertex::getBindingDescriptions() {
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = sizeof(QuantizedVertex);
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-  if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
-    throw std::runtime_error(warn + err);
-  }
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> LveModel::QuantizedVertex::getAttributeDescriptions() {
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+	// same locations as Vertex, simple.vert decodes the normal when QUANTIZED_VERTICES is set
+	attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(QuantizedVertex, position)});
+	attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(QuantizedVertex, color)});
+	attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(QuantizedVertex, normal)});
+	attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(QuantizedVertex, uv)});
+
+	return attributeDescriptions;
+}
+
+void LveModel::Builder::loadModel(const std::string &filepath) {
+  LveObjParser::Result obj = LveObjParser::parse(filepath, parseThreads);
 
   vertices.clear();
   indices.clear();
+  indices.reserve(obj.indices.size());
 
-  std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-  for (const auto &shape : shapes) {
-    for (const auto &index : shape.mesh.indices) {
-      Vertex vertex{};
+  LveVertexWelder welder{vertices, obj.indices.size(), weldEpsilon};
+  for (const auto &index : obj.indices) {
+    Vertex vertex{};
+    vertex.color = {1.f, 1.f, 1.f};
 
-      if (index.vertex_index >= 0) {
-        vertex.position = {
-            attrib.vertices[3 * index.vertex_index + 0],
-            attrib.vertices[3 * index.vertex_index + 1],
-            attrib.vertices[3 * index.vertex_index + 2],
-        };
+    if (index.vertex >= 0) {
+      vertex.position = {
+          obj.positions[3 * index.vertex + 0],
+          obj.positions[3 * index.vertex + 1],
+          obj.positions[3 * index.vertex + 2],
+      };
 
+      if (!obj.colors.empty()) {
         vertex.color = {
-            attrib.colors[3 * index.vertex_index + 0],
-            attrib.colors[3 * index.vertex_index + 1],
-            attrib.colors[3 * index.vertex_index + 2],
-        };
-      }
-
-      if (index.normal_index >= 0) {
-        vertex.normal = {
-            attrib.normals[3 * index.normal_index + 0],
-            attrib.normals[3 * index.normal_index + 1],
-            attrib.normals[3 * index.normal_index + 2],
+            obj.colors[3 * index.vertex + 0],
+            obj.colors[3 * index.vertex + 1],
+            obj.colors[3 * index.vertex + 2],
         };
       }
+    }
 
-      if (index.texcoord_index >= 0) {
-        vertex.uv = {
-            attrib.texcoords[2 * index.texcoord_index + 0],
-            attrib.texcoords[2 * index.texcoord_index + 1],
-        };
-      }
+    if (index.normal >= 0) {
+      vertex.normal = {
+          obj.normals[3 * index.normal + 0],
+          obj.normals[3 * index.normal + 1],
+          obj.normals[3 * index.normal + 2],
+      };
+    }
 
-      if (uniqueVertices.count(vertex) == 0) {
-        uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-        vertices.push_back(vertex);
-      }
-      indices.push_back(uniqueVertices[vertex]);
+    if (index.texcoord >= 0) {
+      vertex.uv = {
+          obj.texcoords[2 * index.texcoord + 0],
+          obj.texcoords[2 * index.texcoord + 1],
+      };
     }
+
+    indices.push_back(welder.weld(vertex));
   }
 }
+
+std::pair<LveModel::VertexCacheStats, LveModel::VertexCacheStats> LveModel::Builder::optimize(bool reduceOverdraw) {
+	assert(lods.empty() && meshlets.empty() && "optimize() must run before generateLods() and buildMeshlets()");
+	VertexCacheStats before = analyzeVertexCache();
+
+	std::vector<uint32_t> clusters;
+	LveMeshOptimizer::optimizeVertexCache(indices, vertices.size(), 16, reduceOverdraw ? &clusters : nullptr);
+	if (reduceOverdraw) {
+		LveMeshOptimizer::optimizeOverdraw(indices, vertices, clusters);
+	}
+	LveMeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+	return {before, analyzeVertexCache()};
+}
+
+LveModel::VertexCacheStats LveModel::Builder::analyzeVertexCache(uint32_t cacheSize) const {
+	return LveMeshOptimizer::analyzeVertexCache(indices, vertices.size(), cacheSize);
+}
+
+void LveModel::Builder::generateLods(uint32_t maxLods, float reduction, float maxError) {
+	// calling this again regenerates the chain from the full mesh
+	if (!lods.empty()) {
+		indices.resize(lods[0].indexCount);
+		lods.clear();
+	}
+	lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.f});
+
+	LveMeshSimplifier simplifier{vertices};
+	std::vector<uint32_t> lodIndices;
+	const size_t baseCount = indices.size();
+	float targetTriangles = static_cast<float>(baseCount / 3);
+
+	for (uint32_t i = 1; i < maxLods; i++) {
+		targetTriangles *= reduction;
+
+		// every LOD starts from the full mesh so its error is measured against it
+		lodIndices.assign(indices.begin(), indices.begin() + baseCount);
+		float error = simplifier.simplify(lodIndices, static_cast<size_t>(targetTriangles) * 3, maxError);
+		if (lodIndices.empty() || lodIndices.size() > lods.back().indexCount * MIN_LOD_REDUCTION) {
+			break;
+		}
+
+		LveMeshOptimizer::optimizeVertexCache(lodIndices, vertices.size());
+		lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), error});
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+}
+
+void LveModel::Builder::buildMeshlets(uint32_t maxVertices, uint32_t maxTriangles) {
+	uint32_t lod0Count = lods.empty() ? static_cast<uint32_t>(indices.size()) : lods[0].indexCount;
+	meshlets = LveMeshletBuilder::build(vertices, indices.data(), lod0Count, maxVertices, maxTriangles);
+}
 }
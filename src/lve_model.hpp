@@ -3,10 +3,12 @@
 #include "glm/fwd.hpp"
 #include "lve_buffer.hpp"
 #include "lve_device.hpp"
+#include "lve_geometry_arena.hpp"
 #include "vulkan/vulkan_core.h"
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <utility>
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_FORCE_RADIANS
@@ -14,6 +16,8 @@
 
 namespace lve {
 
+class LveMeshCache;
+
 	class LveModel {
 public:
 	struct Vertex {
@@ -30,39 +34,195 @@ public:
 		}
 	};
 
+	enum class VertexFormat {
+		Full,       // Vertex, 44 bytes
+		Quantized,  // QuantizedVertex, 20 bytes, see LveVertexQuantizer
+	};
+
+	struct QuantizedVertex {
+		uint16_t position[4];  // unorm relative to the mesh bounds, w is padding
+		int16_t normal[2];     // octahedral, snorm
+		uint8_t color[4];      // unorm
+		uint16_t uv[2];        // half float
+
+		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+	};
+
+	// Part of the index buffer drawn with its own base vertex. Meshes with more than 65536
+	// vertices are split into ranges whose indices fit 16 bits relative to vertexOffset.
+	struct IndexRange {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		int32_t vertexOffset;
+	};
+
+	// Index range of one level of detail, LOD 0 is the full mesh. error is the geometric
+	// simplification error relative to the diagonal of the mesh bounds.
+	struct Lod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;
+	};
+
+	// Cluster of LOD 0 triangles, contiguous in the index buffer, with model space bounds for
+	// culling. Every triangle faces away from a camera outside the cone around coneAxis whose
+	// half angle has sine coneCutoff; a cutoff of 1 disables the backface test.
+	struct Meshlet {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		glm::vec3 center;
+		float radius;
+		glm::vec3 coneAxis;
+		float coneCutoff;
+	};
+
+	// screen space error (fraction of the viewport height) the default LOD thresholds allow,
+	// about one pixel at 1080p
+	static constexpr float DEFAULT_LOD_SCREEN_ERROR = 1.f / 1080.f;
+
+	struct VertexCacheStats {
+		float acmr = 0.f;  // transformed vertices per triangle, 0.5 at best
+		float atvr = 0.f;  // transformed vertices per unique vertex, 1.0 at best
+	};
+
 	struct Builder {
 		std::vector<Vertex> vertices{};
 		std::vector<uint32_t> indices{};
+		// set by generateLods(), empty means a single LOD covering all indices
+		std::vector<Lod> lods{};
+		// set by buildMeshlets(), cover LOD 0
+		std::vector<Meshlet> meshlets{};
+
+		// > 0 welds vertices whose positions are this close and whose other attributes match
+		float weldEpsilon = 0.f;
+		VertexFormat vertexFormat = VertexFormat::Full;
+		// threads loadModel() parses with, 0 is one per core; 1 on threads that are already
+		// one of many workers
+		unsigned parseThreads = 0;
 
 		void loadModel(const std::string &filepath);
+
+		// Reorders triangles for the post-transform cache (and optionally to draw outward facing
+		// clusters first), then vertices by first use. Returns the stats before and after.
+		std::pair<VertexCacheStats, VertexCacheStats> optimize(bool reduceOverdraw = false);
+		VertexCacheStats analyzeVertexCache(uint32_t cacheSize = 16) const;
+
+		// Appends up to maxLods - 1 simplified copies of the mesh to indices, each with about
+		// `reduction` times the triangles of the previous one, and stops early once the error
+		// would exceed maxError or the mesh does not simplify any further.
+		void generateLods(uint32_t maxLods = 4, float reduction = 0.5f, float maxError = 0.05f);
+
+		// Partitions LOD 0 into meshlets, see LveMeshletBuilder. Reorders its triangles, so it
+		// has to run after optimize().
+		void buildMeshlets(uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
 	};
 
-	LveModel(LveDevice &device, const Builder& builder);
+	// vertices and indices live in arena, which has to outlive the model. Unless the arena is
+	// host visible their uploads are staged on the device's LveUploadBatch and go out with its
+	// next submit, the model must not be drawn before isResident().
+	LveModel(LveDevice &device, LveGeometryArena &arena, const Builder& builder);
+	LveModel(LveDevice &device, LveGeometryArena &arena, const LveMeshCache& cache, VertexFormat format = VertexFormat::Full);
 	~LveModel();
 
 	LveModel(const LveModel &) = delete;
 	LveModel &operator=(const LveModel &) = delete;
 
-	void bind(VkCommandBuffer commandBuffer);
-	void draw(VkCommandBuffer commandBuffer);
-
-	static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath);
+	// binds the arena buffers, the recorder drops the binds models sharing the arena and index
+	// type repeat
+	void bind(LveCommandRecorder &recorder) const;
+	void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+	// draws part of the index buffer, e.g. the meshlets that survived culling
+	void drawIndexed(
+		VkCommandBuffer commandBuffer,
+		uint32_t firstIndex,
+		uint32_t count,
+		uint32_t instanceCount = 1,
+		uint32_t firstInstance = 0);
+	// Appends the commands drawIndexed() would record, for vkCmdDrawIndexedIndirect with the
+	// arena buffers bound. Split meshes need one command per 16 bit range.
+	void appendDrawCommands(
+		uint32_t firstIndex,
+		uint32_t count,
+		uint32_t instanceCount,
+		uint32_t firstInstance,
+		std::vector<VkDrawIndexedIndirectCommand> &commands) const;
+
+	// Coarsest LOD allowed at screenSize, the projected diameter of the bounding sphere as a
+	// fraction of the viewport height.
+	uint32_t selectLod(float screenSize) const;
+	const std::vector<Lod> &getLods() const { return lods; }
+	// lodThresholds[i] is the largest screen size LOD i is used at
+	const std::vector<float> &getLodThresholds() const { return lodThresholds; }
+	void setLodThresholds(std::vector<float> thresholds);
+	const std::vector<Meshlet> &getMeshlets() const { return meshlets; }
+
+	// Everything createModelFromFile does short of creating the model, safe to run on any
+	// thread. Returns the mesh cache when it is up to date, otherwise fills builder and
+	// writes the cache for next time.
+	static std::unique_ptr<LveMeshCache> prepareModelData(const std::string &filepath, Builder &builder);
+	static std::unique_ptr<LveModel> createModelFromFile(
+		LveDevice &device, LveGeometryArena &arena, const std::string &filepath, VertexFormat format = VertexFormat::Full);
+
+	// true once the uploads of the model's vertices and indices have completed
+	bool isResident() const;
+	uint64_t getUploadToken() const { return uploadToken; }
+
+	// unique among the models of the process, e.g. for sort keys
+	uint32_t getId() const { return id; }
+	VertexFormat getVertexFormat() const { return vertexFormat; }
+	LveGeometryArena &getGeometryArena() const { return geometryArena; }
+	// bytes the model takes up in its arena
+	VkDeviceSize getGpuMemorySize() const { return vertexAllocation.size + indexAllocation.size; }
+	bool hasIndices() const { return hasIndexBuffer; }
+	VkIndexType getIndexType() const { return indexType; }
+	const std::vector<IndexRange> &getIndexRanges() const { return indexRanges; }
+	// Maps vertex positions to model space, fold it into the model matrix before drawing.
+	const glm::mat4 &getPositionTransform() const { return positionTransform; }
+	// bounding box and the sphere around it in model space
+	const glm::vec3 &getBoundsMin() const { return boundsMin; }
+	const glm::vec3 &getBoundsMax() const { return boundsMax; }
+	const glm::vec3 &getBoundsCenter() const { return boundsCenter; }
+	float getBoundsRadius() const { return boundsRadius; }
 
 private:
 
-	void createVertexBuffers(const std::vector<Vertex> &vertices);
-	void createIndexBuffers(const std::vector<uint32_t> &indices);
+	void createVertexBuffers(const Vertex *vertices, uint32_t count);
+	void createIndexBuffers(const uint32_t *indices, uint32_t count, const Lod *lodData, uint32_t lodCount);
+	void createLods(const Lod *lodData, uint32_t count);
+	void createMeshlets(const Meshlet *meshletData, uint32_t count);
+	static uint32_t nextId();
+	// calls f with every command drawing the range, the one place the arena bases are added
+	template <typename F>
+	void forEachDrawCommand(uint32_t firstIndex, uint32_t count, uint32_t instanceCount, uint32_t firstInstance, F &&f) const;
 
 	LveDevice& lveDevice;
+	LveGeometryArena& geometryArena;
+	uint32_t id = nextId();
 
-	std::unique_ptr<LveBuffer> vertexBuffer;
+	LveGeometryArena::Allocation vertexAllocation{};
+	int32_t baseVertex = 0;  // of the model's first vertex in the arena
 	uint32_t vertexCount;
+	VertexFormat vertexFormat = VertexFormat::Full;
+	glm::mat4 positionTransform{1.f};
+	glm::vec3 boundsMin{0.f};
+	glm::vec3 boundsMax{0.f};
+	glm::vec3 boundsCenter{0.f};
+	float boundsRadius = 0.f;
 
 
 	bool hasIndexBuffer = false;
-	std::unique_ptr<LveBuffer> indexBuffer;
+	LveGeometryArena::Allocation indexAllocation{};
+	uint32_t baseIndex = 0;
 	uint32_t indexCount;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	std::vector<IndexRange> indexRanges{};
+
+	std::vector<Lod> lods{};
+	std::vector<float> lodThresholds{};
+	std::vector<Meshlet> meshlets{};
 
+	uint64_t uploadToken = 0;
 };
 
 }
@@ -0,0 +1,50 @@
+#include "lve_model_handle.hpp"
+#include "lve_model_registry.hpp"
+
+namespace lve {
+
+LveModelHandle::LveModelHandle(std::shared_ptr<LveModel> model) {
+	if (model) {
+		slot = std::make_shared<Slot>();
+		slot->setModel(std::move(model));
+		slot->state.store(State::Ready, std::memory_order_release);
+	}
+}
+
+void LveModelHandle::Slot::setModel(std::shared_ptr<LveModel> newModel) {
+	model = std::move(newModel);
+	if (model) {
+		hasBounds = true;
+		boundsMin = model->getBoundsMin();
+		boundsMax = model->getBoundsMax();
+	}
+}
+
+LveModel *LveModelHandle::get() const {
+	touch();
+	return peek();
+}
+
+LveModel *LveModelHandle::peek() const {
+	if (!slot || getState() != State::Ready || !slot->model->isResident()) {
+		return nullptr;
+	}
+	return slot->model.get();
+}
+
+void LveModelHandle::touch() const {
+	if (slot && slot->registry != nullptr) {
+		slot->registry->touch(slot);
+	}
+}
+
+bool LveModelHandle::getBounds(glm::vec3 &boundsMin, glm::vec3 &boundsMax) const {
+	if (!slot || !slot->hasBounds) {
+		return false;
+	}
+	boundsMin = slot->boundsMin;
+	boundsMax = slot->boundsMax;
+	return true;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace lve {
+
+class LveModelRegistry;
+
+// Reference to a model that may still be loading or may have been evicted, see
+// LveModelRegistry. Copies share the model; get() stays nullptr until it has been built and
+// its GPU upload has completed.
+class LveModelHandle {
+public:
+	enum class State {
+		Loading,  // parsing on a worker or waiting to be uploaded
+		Ready,    // model created, resident once its upload token completes
+		Evicted,  // dropped to stay in the memory budget, reloads on the next get()
+		Failed,
+	};
+
+	struct Slot {
+		std::string filepath;
+		LveModel::VertexFormat format = LveModel::VertexFormat::Full;
+		std::atomic<State> state{State::Loading};
+
+		// only touched by the render thread
+		std::shared_ptr<LveModel> model{};
+		LveModelRegistry *registry = nullptr;
+		uint64_t lastUsedFrame = 0;
+		// of the model once built, kept across eviction so culling can tell when to reload it
+		bool hasBounds = false;
+		glm::vec3 boundsMin{0.f};
+		glm::vec3 boundsMax{0.f};
+
+		void setModel(std::shared_ptr<LveModel> newModel);
+	};
+
+	LveModelHandle() = default;
+	// already loaded model, never evicted
+	LveModelHandle(std::shared_ptr<LveModel> model);
+	explicit LveModelHandle(std::shared_ptr<Slot> slot) : slot{std::move(slot)} {}
+
+	// Render thread. Counts as a use of the model for eviction and brings an evicted model
+	// back, so call it for models about to be drawn.
+	LveModel *get() const;
+	// Render thread. The model if it is ready, without counting as a use, for culling. Touch
+	// what survives culling so models nobody sees stay eviction candidates.
+	LveModel *peek() const;
+	void touch() const;
+	// model space bounds, known once the model has been built even while it is evicted
+	bool getBounds(glm::vec3 &boundsMin, glm::vec3 &boundsMax) const;
+	State getState() const { return slot ? slot->state.load(std::memory_order_acquire) : State::Failed; }
+	bool isEmpty() const { return slot == nullptr; }
+
+private:
+	std::shared_ptr<Slot> slot;
+};
+
+}
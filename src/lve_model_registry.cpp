@@ -0,0 +1,74 @@
+#include "lve_model_registry.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace lve {
+
+LveModelRegistry::LveModelRegistry(LveDevice &device, LveGeometryArena &arena, VkDeviceSize memoryBudget, unsigned threadCount)
+	: streamer{device, arena, threadCount}, memoryBudget{memoryBudget} {}
+
+LveModelRegistry::~LveModelRegistry() {
+	// handles can outlive the registry, they just stop reloading
+	for (auto &kv : slots) {
+		kv.second->registry = nullptr;
+	}
+}
+
+LveModelHandle LveModelRegistry::load(const std::string &filepath, LveModel::VertexFormat format) {
+	auto &slot = slots[{filepath, format}];
+	if (!slot) {
+		slot = std::make_shared<LveModelHandle::Slot>();
+		slot->filepath = filepath;
+		slot->format = format;
+		slot->registry = this;
+		slot->lastUsedFrame = frame;
+		streamer.load(slot);
+	}
+	return LveModelHandle{slot};
+}
+
+void LveModelRegistry::touch(const std::shared_ptr<LveModelHandle::Slot> &slot) {
+	slot->lastUsedFrame = frame;
+	if (slot->state.load(std::memory_order_acquire) == LveModelHandle::State::Evicted) {
+		streamer.load(slot);
+	}
+}
+
+void LveModelRegistry::update() {
+	frame++;
+	streamer.update();
+	evictOverBudget();
+}
+
+void LveModelRegistry::evictOverBudget() {
+	residentBytes = 0;
+	std::vector<LveModelHandle::Slot *> candidates;
+	for (auto &kv : slots) {
+		LveModelHandle::Slot &slot = *kv.second;
+		if (!slot.model) continue;
+		residentBytes += slot.model->getGpuMemorySize();
+		// an upload still in flight would land in ranges that may be handed out again
+		if (slot.lastUsedFrame + MIN_FRAMES_BEFORE_EVICTION <= frame && slot.model->isResident()) {
+			candidates.push_back(&slot);
+		}
+	}
+	if (residentBytes <= memoryBudget) {
+		return;
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const LveModelHandle::Slot *a, const LveModelHandle::Slot *b) {
+		return a->lastUsedFrame < b->lastUsedFrame;
+	});
+	for (LveModelHandle::Slot *slot : candidates) {
+		if (residentBytes <= memoryBudget) break;
+
+		// not drawn in the last frames in flight, so the GPU is done with its arena ranges
+		residentBytes -= slot->model->getGpuMemorySize();
+		slot->model.reset();
+		slot->state.store(LveModelHandle::State::Evicted, std::memory_order_release);
+		evictionCount++;
+	}
+}
+
+}
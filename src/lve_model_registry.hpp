@@ -0,0 +1,64 @@
+#pragma once
+
+#include "lve_asset_streamer.hpp"
+#include "lve_device.hpp"
+#include "lve_geometry_arena.hpp"
+#include "lve_model_handle.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace lve {
+
+// Every model loaded from a file, keyed by path and vertex format, so loading a file twice
+// returns the same model. Models that haven't been drawn for a while are evicted, least
+// recently drawn first, whenever their total GPU size is over the memory budget; their
+// handles stay valid and reload them (from the mesh cache, written on the first load) as
+// soon as they are used again.
+class LveModelRegistry {
+public:
+	static constexpr VkDeviceSize DEFAULT_MEMORY_BUDGET = 64ull << 20;
+	// a model drawn within this many frames may still be read by the GPU
+	static constexpr uint64_t MIN_FRAMES_BEFORE_EVICTION = LveSwapChain::MAX_FRAMES_IN_FLIGHT + 1;
+
+	LveModelRegistry(
+		LveDevice &device,
+		LveGeometryArena &arena,
+		VkDeviceSize memoryBudget = DEFAULT_MEMORY_BUDGET,
+		unsigned threadCount = 0);
+	~LveModelRegistry();
+
+	LveModelRegistry(const LveModelRegistry &) = delete;
+	LveModelRegistry &operator=(const LveModelRegistry &) = delete;
+
+	LveModelHandle load(const std::string &filepath, LveModel::VertexFormat format = LveModel::VertexFormat::Full);
+
+	// render thread, once per frame before drawing: finishes loads and evicts over budget
+	void update();
+
+	void setMemoryBudget(VkDeviceSize budget) { memoryBudget = budget; }
+	VkDeviceSize getMemoryBudget() const { return memoryBudget; }
+	// GPU bytes of the models currently loaded
+	VkDeviceSize getResidentBytes() const { return residentBytes; }
+	uint32_t getEvictionCount() const { return evictionCount; }
+
+private:
+	friend class LveModelHandle;
+
+	// a handle is about to draw the slot's model
+	void touch(const std::shared_ptr<LveModelHandle::Slot> &slot);
+	void evictOverBudget();
+
+	LveAssetStreamer streamer;
+	std::map<std::pair<std::string, LveModel::VertexFormat>, std::shared_ptr<LveModelHandle::Slot>> slots;
+
+	VkDeviceSize memoryBudget;
+	VkDeviceSize residentBytes = 0;
+	uint64_t frame = 0;
+	uint32_t evictionCount = 0;
+};
+
+}
@@ -0,0 +1,303 @@
+#include "lve_obj_parser.hpp"
+#include "lve_file_mapping.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+namespace lve {
+
+namespace {
+
+// chunks smaller than this are not worth a thread
+constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+// Face corner as seen by a single chunk. Negative (relative) OBJ indices can point into
+// earlier chunks, so they are stored relative to the chunk start and fixed up on merge.
+struct ChunkIndex {
+	int32_t vertex;
+	int32_t normal;
+	int32_t texcoord;
+	uint8_t relative;  // bit 0 vertex, bit 1 normal, bit 2 texcoord
+};
+
+struct Chunk {
+	const char *begin;
+	const char *end;
+
+	std::vector<float> positions;
+	std::vector<float> colors;
+	std::vector<float> normals;
+	std::vector<float> texcoords;
+	std::vector<ChunkIndex> indices;
+
+	std::exception_ptr error;
+};
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char *skipSpace(const char *p, const char *end) {
+	while (p < end && isSpace(*p)) ++p;
+	return p;
+}
+
+inline bool parseFloat(const char *&p, const char *end, float &value) {
+	p = skipSpace(p, end);
+	if (p < end && *p == '+') ++p;
+	auto result = std::from_chars(p, end, value);
+	if (result.ec != std::errc{}) return false;
+	p = result.ptr;
+	return true;
+}
+
+inline bool parseInt(const char *&p, const char *end, int32_t &value) {
+	if (p < end && *p == '+') ++p;
+	auto result = std::from_chars(p, end, value);
+	if (result.ec != std::errc{}) return false;
+	p = result.ptr;
+	return true;
+}
+
+// Converts a 1-based or negative OBJ index into a chunk local 0-based one.
+inline int32_t fixIndex(int32_t index, size_t localCount, uint8_t bit, uint8_t &relative) {
+	if (index > 0) return index - 1;
+	if (index == 0) throw std::runtime_error("invalid OBJ index 0");
+	relative |= bit;
+	return static_cast<int32_t>(localCount) + index;
+}
+
+void parseFace(const char *p, const char *end, Chunk &chunk, std::vector<ChunkIndex> &face) {
+	face.clear();
+	const size_t vertexCount = chunk.positions.size() / 3;
+	const size_t normalCount = chunk.normals.size() / 3;
+	const size_t texcoordCount = chunk.texcoords.size() / 2;
+
+	while (true) {
+		p = skipSpace(p, end);
+		if (p >= end || *p == '#') break;
+
+		ChunkIndex corner{-1, -1, -1, 0};
+		int32_t value;
+		if (!parseInt(p, end, value)) throw std::runtime_error("malformed OBJ face");
+		corner.vertex = fixIndex(value, vertexCount, 1, corner.relative);
+
+		if (p < end && *p == '/') {
+			++p;
+			if (p < end && *p != '/') {
+				if (!parseInt(p, end, value)) throw std::runtime_error("malformed OBJ face");
+				corner.texcoord = fixIndex(value, texcoordCount, 4, corner.relative);
+			}
+			if (p < end && *p == '/') {
+				++p;
+				if (!parseInt(p, end, value)) throw std::runtime_error("malformed OBJ face");
+				corner.normal = fixIndex(value, normalCount, 2, corner.relative);
+			}
+		}
+		face.push_back(corner);
+
+		// skip anything we don't understand up to the next separator
+		while (p < end && !isSpace(*p)) ++p;
+	}
+
+	// triangle fan, same as tinyobj for convex polygons
+	for (size_t k = 2; k < face.size(); k++) {
+		chunk.indices.push_back(face[0]);
+		chunk.indices.push_back(face[k - 1]);
+		chunk.indices.push_back(face[k]);
+	}
+}
+
+void parseChunk(Chunk &chunk) {
+	std::vector<ChunkIndex> face;
+	const char *p = chunk.begin;
+
+	while (p < chunk.end) {
+		const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', chunk.end - p));
+		if (lineEnd == nullptr) lineEnd = chunk.end;
+
+		const char *q = skipSpace(p, lineEnd);
+		if (q + 1 < lineEnd && q[0] == 'v' && isSpace(q[1])) {
+			float x = 0.f, y = 0.f, z = 0.f;
+			q += 1;
+			parseFloat(q, lineEnd, x);
+			parseFloat(q, lineEnd, y);
+			parseFloat(q, lineEnd, z);
+			chunk.positions.insert(chunk.positions.end(), {x, y, z});
+
+			float r, g, b;
+			if (parseFloat(q, lineEnd, r) && parseFloat(q, lineEnd, g) && parseFloat(q, lineEnd, b)) {
+				if (chunk.colors.size() + 3 < chunk.positions.size()) {
+					// first colored vertex in this chunk, earlier ones default to white
+					chunk.colors.resize(chunk.positions.size() - 3, 1.f);
+				}
+				chunk.colors.insert(chunk.colors.end(), {r, g, b});
+			} else if (!chunk.colors.empty()) {
+				chunk.colors.insert(chunk.colors.end(), {1.f, 1.f, 1.f});
+			}
+		} else if (q + 2 < lineEnd && q[0] == 'v' && q[1] == 'n' && isSpace(q[2])) {
+			float x = 0.f, y = 0.f, z = 0.f;
+			q += 2;
+			parseFloat(q, lineEnd, x);
+			parseFloat(q, lineEnd, y);
+			parseFloat(q, lineEnd, z);
+			chunk.normals.insert(chunk.normals.end(), {x, y, z});
+		} else if (q + 2 < lineEnd && q[0] == 'v' && q[1] == 't' && isSpace(q[2])) {
+			float u = 0.f, v = 0.f;
+			q += 2;
+			parseFloat(q, lineEnd, u);
+			parseFloat(q, lineEnd, v);
+			chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+		} else if (q + 1 < lineEnd && q[0] == 'f' && isSpace(q[1])) {
+			parseFace(q + 1, lineEnd, chunk, face);
+		}
+		// everything else (o, g, s, usemtl, mtllib, comments) is irrelevant to the builder
+
+		p = lineEnd + 1;
+	}
+}
+
+// Resolves the chunk local indices against the global attribute offsets and copies the
+// chunk into its slot of the result. Chunks write disjoint ranges so this runs in parallel.
+void mergeChunk(
+	const Chunk &chunk,
+	LveObjParser::Result &result,
+	size_t vertexBase,
+	size_t normalBase,
+	size_t texcoordBase,
+	size_t indexBase) {
+	std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + vertexBase * 3);
+	std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + normalBase * 3);
+	std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), result.texcoords.begin() + texcoordBase * 2);
+	if (!chunk.colors.empty()) {
+		std::copy(chunk.colors.begin(), chunk.colors.end(), result.colors.begin() + vertexBase * 3);
+	}
+
+	const int32_t vertexCount = static_cast<int32_t>(result.positions.size() / 3);
+	const int32_t normalCount = static_cast<int32_t>(result.normals.size() / 3);
+	const int32_t texcoordCount = static_cast<int32_t>(result.texcoords.size() / 2);
+
+	// -1 without the relative bit means the attribute is absent
+	auto resolve = [](int32_t index, bool relative, size_t base, int32_t count, bool required) {
+		if (relative) index += static_cast<int32_t>(base);
+		if ((index == -1 && !relative && !required) || (index >= 0 && index < count)) {
+			return index;
+		}
+		throw std::runtime_error("OBJ face index out of range");
+	};
+
+	auto out = result.indices.begin() + indexBase;
+	for (const auto &corner : chunk.indices) {
+		LveObjParser::Index index{};
+		index.vertex = resolve(corner.vertex, corner.relative & 1, vertexBase, vertexCount, true);
+		index.normal = resolve(corner.normal, corner.relative & 2, normalBase, normalCount, false);
+		index.texcoord = resolve(corner.texcoord, corner.relative & 4, texcoordBase, texcoordCount, false);
+		*out++ = index;
+	}
+}
+
+template <typename Fn>
+void runParallel(std::vector<Chunk> &chunks, Fn fn) {
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunks.size(); i++) {
+		workers.emplace_back([&chunks, &fn, i]() {
+			try {
+				fn(i);
+			} catch (...) {
+				chunks[i].error = std::current_exception();
+			}
+		});
+	}
+
+	try {
+		fn(0);
+	} catch (...) {
+		chunks[0].error = std::current_exception();
+	}
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	for (auto &chunk : chunks) {
+		if (chunk.error) std::rethrow_exception(chunk.error);
+	}
+}
+
+}  // namespace
+
+LveObjParser::Result LveObjParser::parse(const std::string &filepath, unsigned maxThreads) {
+	LveFileMapping file{filepath};
+	if (!file.isValid()) {
+		throw std::runtime_error("failed to open the file " + filepath);
+	}
+
+	if (maxThreads == 0) {
+		maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	size_t chunkCount = std::min<size_t>(maxThreads, std::max<size_t>(1, file.size() / MIN_CHUNK_SIZE));
+
+	// split on line boundaries
+	std::vector<Chunk> chunks(chunkCount);
+	const char *begin = file.data();
+	const char *end = file.data() + file.size();
+	const char *chunkBegin = begin;
+	for (size_t i = 0; i < chunkCount; i++) {
+		const char *chunkEnd = end;
+		if (i + 1 < chunkCount) {
+			chunkEnd = begin + file.size() * (i + 1) / chunkCount;
+			chunkEnd = std::max(chunkEnd, chunkBegin);
+			const char *newline = static_cast<const char *>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+			chunkEnd = newline ? newline + 1 : end;
+		}
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	try {
+		runParallel(chunks, [&chunks](size_t i) { parseChunk(chunks[i]); });
+	} catch (const std::exception &e) {
+		throw std::runtime_error(filepath + ": " + e.what());
+	}
+
+	// prefix sums give every chunk its place in the merged arrays
+	std::vector<size_t> vertexBase(chunkCount), normalBase(chunkCount), texcoordBase(chunkCount), indexBase(chunkCount);
+	size_t vertexCount = 0, normalCount = 0, texcoordCount = 0, indexCount = 0;
+	bool hasColors = false;
+	for (size_t i = 0; i < chunkCount; i++) {
+		vertexBase[i] = vertexCount;
+		normalBase[i] = normalCount;
+		texcoordBase[i] = texcoordCount;
+		indexBase[i] = indexCount;
+		vertexCount += chunks[i].positions.size() / 3;
+		normalCount += chunks[i].normals.size() / 3;
+		texcoordCount += chunks[i].texcoords.size() / 2;
+		indexCount += chunks[i].indices.size();
+		hasColors = hasColors || !chunks[i].colors.empty();
+	}
+
+	Result result{};
+	result.positions.resize(vertexCount * 3);
+	result.normals.resize(normalCount * 3);
+	result.texcoords.resize(texcoordCount * 2);
+	result.indices.resize(indexCount);
+	if (hasColors) {
+		result.colors.resize(vertexCount * 3, 1.f);
+	}
+
+	try {
+		runParallel(chunks, [&](size_t i) {
+			mergeChunk(chunks[i], result, vertexBase[i], normalBase[i], texcoordBase[i], indexBase[i]);
+			// release the chunk as soon as it has been copied to keep the peak down
+			chunks[i] = Chunk{};
+		});
+	} catch (const std::exception &e) {
+		throw std::runtime_error(filepath + ": " + e.what());
+	}
+
+	return result;
+}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// Wavefront OBJ reader for the subset the engine uses (v/vt/vn/f). The file is memory
+// mapped and split into line aligned chunks that are parsed on separate threads, the
+// per chunk results are then stitched together in file order.
+class LveObjParser {
+public:
+	struct Index {
+		int32_t vertex = -1;
+		int32_t normal = -1;
+		int32_t texcoord = -1;
+	};
+
+	struct Result {
+		std::vector<float> positions;  // xyz per vertex
+		std::vector<float> colors;     // rgb per vertex, empty when the file has no vertex colors
+		std::vector<float> normals;    // xyz per normal
+		std::vector<float> texcoords;  // uv per texcoord
+		std::vector<Index> indices;    // triangulated face corners in file order, 0-based
+	};
+
+	// maxThreads == 0 uses std::thread::hardware_concurrency()
+	static Result parse(const std::string &filepath, unsigned maxThreads = 0);
+};
+
+}
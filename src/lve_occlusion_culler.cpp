@@ -0,0 +1,339 @@
+#include "lve_occlusion_culler.hpp"
+#include "lve_mesh_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LVE_OCCLUSION_CULLER_SSE
+#endif
+
+namespace lve {
+
+namespace {
+
+std::shared_ptr<const LveOccluder> makeOccluder(
+	const LveModel::Vertex *vertices,
+	uint32_t vertexCount,
+	const uint32_t *indices,
+	uint32_t indexCount,
+	const LveModel::Lod *lods,
+	uint32_t lodCount,
+	uint32_t lod) {
+	auto occluder = std::make_shared<LveOccluder>();
+	occluder->positions.reserve(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		occluder->positions.push_back(vertices[i].position);
+	}
+
+	if (indexCount == 0) {
+		occluder->indices.resize(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++) occluder->indices[i] = i;
+	} else if (lodCount == 0) {
+		occluder->indices.assign(indices, indices + indexCount);
+	} else {
+		assert(lod < lodCount && "LOD out of range");
+		const LveModel::Lod &range = lods[lod];
+		occluder->indices.assign(indices + range.firstIndex, indices + range.firstIndex + range.indexCount);
+	}
+	return occluder;
+}
+
+}  // namespace
+
+std::shared_ptr<const LveOccluder> LveOccluder::fromBuilder(const LveModel::Builder &builder, uint32_t lod) {
+	return makeOccluder(
+		builder.vertices.data(),
+		static_cast<uint32_t>(builder.vertices.size()),
+		builder.indices.data(),
+		static_cast<uint32_t>(builder.indices.size()),
+		builder.lods.data(),
+		static_cast<uint32_t>(builder.lods.size()),
+		lod);
+}
+
+std::shared_ptr<const LveOccluder> LveOccluder::fromCache(const LveMeshCache &cache, uint32_t lod) {
+	return makeOccluder(
+		cache.vertices(), cache.vertexCount(), cache.indices(), cache.indexCount(), cache.lods(), cache.lodCount(), lod);
+}
+
+std::shared_ptr<const LveOccluder> LveOccluder::fromFile(const std::string &filepath, uint32_t lod) {
+	LveModel::Builder builder{};
+	if (auto cache = LveModel::prepareModelData(filepath, builder)) {
+		return fromCache(*cache, lod);
+	}
+	return fromBuilder(builder, lod);
+}
+
+LveOcclusionCuller::LveOcclusionCuller(uint32_t width, uint32_t height, unsigned threadCount)
+	: width{width}, height{height}, tilesX{width / TILE_WIDTH}, tilesY{height / TILE_HEIGHT}, threadPool{threadCount} {
+	assert(width > 0 && width % TILE_WIDTH == 0 && "Width must be a multiple of the tile width");
+	assert(height > 0 && height % TILE_HEIGHT == 0 && "Height must be a multiple of the tile height");
+	depth.assign(width * height, 1.f);
+	blockDepth.assign((width / BLOCK_SIZE) * (height / BLOCK_SIZE), 1.f);
+	tileBins.resize(tilesX * tilesY);
+}
+
+void LveOcclusionCuller::beginFrame(const glm::mat4 &viewProjection) {
+	this->viewProjection = viewProjection;
+	std::fill(depth.begin(), depth.end(), 1.f);
+	std::fill(blockDepth.begin(), blockDepth.end(), 1.f);
+	triangles.clear();
+	for (auto &bin : tileBins) bin.clear();
+	stats = Stats{};
+}
+
+void LveOcclusionCuller::addOccluder(const LveOccluder &occluder, const glm::mat4 &modelMatrix) {
+	stats.occluders++;
+	const glm::mat4 transform = viewProjection * modelMatrix;
+	clipPositions.resize(occluder.positions.size());
+	for (size_t i = 0; i < occluder.positions.size(); i++) {
+		clipPositions[i] = transform * glm::vec4(occluder.positions[i], 1.f);
+	}
+
+	for (size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+		const glm::vec4 corners[3] = {
+			clipPositions[occluder.indices[i]],
+			clipPositions[occluder.indices[i + 1]],
+			clipPositions[occluder.indices[i + 2]]};
+
+		// clip against the near plane z = 0, leaves a triangle or a quad
+		glm::vec4 polygon[4];
+		int polygonSize = 0;
+		for (int v = 0; v < 3; v++) {
+			const glm::vec4 &current = corners[v];
+			const glm::vec4 &next = corners[(v + 1) % 3];
+			if (current.z >= 0.f) polygon[polygonSize++] = current;
+			if ((current.z >= 0.f) != (next.z >= 0.f)) {
+				float t = current.z / (current.z - next.z);
+				polygon[polygonSize++] = current + (next - current) * t;
+			}
+		}
+		for (int v = 1; v + 1 < polygonSize; v++) {
+			binTriangle(polygon[0], polygon[v], polygon[v + 1]);
+		}
+	}
+}
+
+void LveOcclusionCuller::binTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c) {
+	if (a.w <= 0.f || b.w <= 0.f || c.w <= 0.f) return;
+
+	auto toScreen = [this](const glm::vec4 &clip) {
+		return glm::vec3{
+			(clip.x / clip.w * .5f + .5f) * static_cast<float>(width),
+			(clip.y / clip.w * .5f + .5f) * static_cast<float>(height),
+			clip.z / clip.w};
+	};
+	glm::vec3 v0 = toScreen(a), v1 = toScreen(b), v2 = toScreen(c);
+
+	// both windings occlude, make it counter clockwise so the inside is positive
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (!(std::fabs(area) > 0.f)) return;
+	if (area < 0.f) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	// pixels whose centers lie within the triangle's bounds
+	Triangle triangle{};
+	triangle.minX = std::max(0, static_cast<int32_t>(std::ceil(std::min({v0.x, v1.x, v2.x}) - .5f)));
+	triangle.minY = std::max(0, static_cast<int32_t>(std::ceil(std::min({v0.y, v1.y, v2.y}) - .5f)));
+	triangle.maxX = std::min(
+		static_cast<int32_t>(width) - 1, static_cast<int32_t>(std::floor(std::max({v0.x, v1.x, v2.x}) - .5f)));
+	triangle.maxY = std::min(
+		static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::floor(std::max({v0.y, v1.y, v2.y}) - .5f)));
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+	const glm::vec3 *vertices[3] = {&v0, &v1, &v2};
+	for (int e = 0; e < 3; e++) {
+		const glm::vec3 &from = *vertices[e];
+		const glm::vec3 &to = *vertices[(e + 1) % 3];
+		triangle.edgeA[e] = from.y - to.y;
+		triangle.edgeB[e] = to.x - from.x;
+		triangle.edgeC[e] = from.x * to.y - from.y * to.x;
+	}
+
+	const float depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	const float depthB = ((v1.x - v0.x) * (v2.z - v0.z) - (v2.x - v0.x) * (v1.z - v0.z)) / area;
+	triangle.depthA = depthA;
+	triangle.depthB = depthB;
+	// evaluated at pixel centers, offset to the farthest depth within the pixel
+	triangle.depthC = v0.z - depthA * v0.x - depthB * v0.y + .5f * (std::fabs(depthA) + std::fabs(depthB));
+
+	const uint32_t index = static_cast<uint32_t>(triangles.size());
+	triangles.push_back(triangle);
+	stats.occluderTriangles++;
+	for (int32_t ty = triangle.minY / static_cast<int32_t>(TILE_HEIGHT); ty <= triangle.maxY / static_cast<int32_t>(TILE_HEIGHT); ty++) {
+		for (int32_t tx = triangle.minX / static_cast<int32_t>(TILE_WIDTH); tx <= triangle.maxX / static_cast<int32_t>(TILE_WIDTH); tx++) {
+			tileBins[ty * tilesX + tx].push_back(index);
+		}
+	}
+}
+
+void LveOcclusionCuller::rasterize() {
+	parallelFor(tilesX * tilesY, [this](uint32_t tile) { rasterizeTile(tile); });
+}
+
+void LveOcclusionCuller::rasterizeTile(uint32_t tile) {
+	const int32_t tileMinX = static_cast<int32_t>((tile % tilesX) * TILE_WIDTH);
+	const int32_t tileMinY = static_cast<int32_t>((tile / tilesX) * TILE_HEIGHT);
+	const int32_t tileMaxX = tileMinX + static_cast<int32_t>(TILE_WIDTH) - 1;
+	const int32_t tileMaxY = tileMinY + static_cast<int32_t>(TILE_HEIGHT) - 1;
+
+	for (uint32_t index : tileBins[tile]) {
+		const Triangle &triangle = triangles[index];
+		// four pixels at a time, the tile width is a multiple of four
+		const int32_t minX = std::max(tileMinX, triangle.minX) & ~3;
+		const int32_t maxX = std::min(tileMaxX, triangle.maxX);
+		const int32_t minY = std::max(tileMinY, triangle.minY);
+		const int32_t maxY = std::min(tileMaxY, triangle.maxY);
+
+		for (int32_t y = minY; y <= maxY; y++) {
+			const float centerY = static_cast<float>(y) + .5f;
+			float row[3];
+			for (int e = 0; e < 3; e++) row[e] = triangle.edgeB[e] * centerY + triangle.edgeC[e];
+			const float depthRow = triangle.depthB * centerY + triangle.depthC;
+			float *depthLine = &depth[y * width];
+
+#if defined(LVE_OCCLUSION_CULLER_SSE)
+			const __m128 laneCenters = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			for (int32_t x = minX; x <= maxX; x += 4) {
+				const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneCenters);
+				__m128 inside = _mm_cmpge_ps(
+					_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(triangle.edgeA[0])), _mm_set1_ps(row[0])), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(
+					_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(triangle.edgeA[1])), _mm_set1_ps(row[1])), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(
+					_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(triangle.edgeA[2])), _mm_set1_ps(row[2])), zero));
+				if (_mm_movemask_ps(inside) == 0) continue;
+
+				const __m128 triangleDepth =
+					_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(triangle.depthA)), _mm_set1_ps(depthRow));
+				const __m128 current = _mm_loadu_ps(depthLine + x);
+				const __m128 nearest = _mm_min_ps(current, triangleDepth);
+				_mm_storeu_ps(depthLine + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+			}
+#else
+			for (int32_t x = minX; x <= maxX; x++) {
+				const float centerX = static_cast<float>(x) + .5f;
+				if (triangle.edgeA[0] * centerX + row[0] >= 0.f &&
+						triangle.edgeA[1] * centerX + row[1] >= 0.f &&
+						triangle.edgeA[2] * centerX + row[2] >= 0.f) {
+					depthLine[x] = std::min(depthLine[x], triangle.depthA * centerX + depthRow);
+				}
+			}
+#endif
+		}
+	}
+
+	// the tile covers whole blocks
+	const uint32_t blocksX = width / BLOCK_SIZE;
+	for (int32_t by = tileMinY; by <= tileMaxY; by += BLOCK_SIZE) {
+		for (int32_t bx = tileMinX; bx <= tileMaxX; bx += BLOCK_SIZE) {
+			float farthest = 0.f;
+			for (int32_t y = by; y < by + static_cast<int32_t>(BLOCK_SIZE); y++) {
+				for (int32_t x = bx; x < bx + static_cast<int32_t>(BLOCK_SIZE); x++) {
+					farthest = std::max(farthest, depth[y * width + x]);
+				}
+			}
+			blockDepth[(by / BLOCK_SIZE) * blocksX + bx / BLOCK_SIZE] = farthest;
+		}
+	}
+}
+
+bool LveOcclusionCuller::isVisible(const Box &box) const {
+	const glm::mat4 transform = viewProjection * box.modelMatrix;
+	glm::vec2 screenMin{std::numeric_limits<float>::max()};
+	glm::vec2 screenMax{std::numeric_limits<float>::lowest()};
+	float nearestDepth = 1.f;
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 position{
+			(corner & 1) ? box.max.x : box.min.x,
+			(corner & 2) ? box.max.y : box.min.y,
+			(corner & 4) ? box.max.z : box.min.z};
+		glm::vec4 clip = transform * glm::vec4(position, 1.f);
+		if (clip.z < 0.f || clip.w <= 0.f) return true;
+
+		glm::vec2 screen{
+			(clip.x / clip.w * .5f + .5f) * static_cast<float>(width),
+			(clip.y / clip.w * .5f + .5f) * static_cast<float>(height)};
+		screenMin = glm::min(screenMin, screen);
+		screenMax = glm::max(screenMax, screen);
+		nearestDepth = std::min(nearestDepth, clip.z / clip.w);
+	}
+
+	// every pixel the box touches and one more around them, coverage is sampled at pixel centers
+	const int32_t minX = std::max(0, static_cast<int32_t>(std::floor(screenMin.x)) - 1);
+	const int32_t minY = std::max(0, static_cast<int32_t>(std::floor(screenMin.y)) - 1);
+	const int32_t maxX = std::min(static_cast<int32_t>(width) - 1, static_cast<int32_t>(std::ceil(screenMax.x)));
+	const int32_t maxY = std::min(static_cast<int32_t>(height) - 1, static_cast<int32_t>(std::ceil(screenMax.y)));
+	if (minX > maxX || minY > maxY) return true;
+
+	const uint32_t blocksX = width / BLOCK_SIZE;
+	for (int32_t by = minY / static_cast<int32_t>(BLOCK_SIZE); by <= maxY / static_cast<int32_t>(BLOCK_SIZE); by++) {
+		for (int32_t bx = minX / static_cast<int32_t>(BLOCK_SIZE); bx <= maxX / static_cast<int32_t>(BLOCK_SIZE); bx++) {
+			if (blockDepth[by * blocksX + bx] < nearestDepth) continue;
+
+			// somewhere in the block the box may be in front, look at the pixels it covers
+			const int32_t x0 = std::max(minX, bx * static_cast<int32_t>(BLOCK_SIZE));
+			const int32_t y0 = std::max(minY, by * static_cast<int32_t>(BLOCK_SIZE));
+			const int32_t x1 = std::min(maxX, (bx + 1) * static_cast<int32_t>(BLOCK_SIZE) - 1);
+			const int32_t y1 = std::min(maxY, (by + 1) * static_cast<int32_t>(BLOCK_SIZE) - 1);
+			for (int32_t y = y0; y <= y1; y++) {
+				for (int32_t x = x0; x <= x1; x++) {
+					if (depth[y * width + x] >= nearestDepth) return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void LveOcclusionCuller::testVisibility(const std::vector<Box> &boxes, std::vector<uint8_t> &visible) {
+	constexpr uint32_t BATCH_SIZE = 64;
+	visible.resize(boxes.size());
+	const uint32_t count = static_cast<uint32_t>(boxes.size());
+	parallelFor((count + BATCH_SIZE - 1) / BATCH_SIZE, [&](uint32_t batch) {
+		const uint32_t end = std::min(count, (batch + 1) * BATCH_SIZE);
+		for (uint32_t i = batch * BATCH_SIZE; i < end; i++) {
+			visible[i] = isVisible(boxes[i]) ? 1 : 0;
+		}
+	});
+
+	stats.testedBoxes += count;
+	stats.occludedBoxes += static_cast<uint32_t>(std::count(visible.begin(), visible.end(), uint8_t{0}));
+}
+
+void LveOcclusionCuller::parallelFor(uint32_t count, const std::function<void(uint32_t)> &job) {
+	std::atomic<uint32_t> next{0};
+	auto run = [&] {
+		for (uint32_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) job(i);
+	};
+
+	const uint32_t helpers = std::min<uint32_t>(static_cast<uint32_t>(threadPool.getThreadCount()), count > 0 ? count - 1 : 0);
+	std::mutex mutex;
+	std::condition_variable finished;
+	uint32_t finishedHelpers = 0;
+	for (uint32_t i = 0; i < helpers; i++) {
+		threadPool.submit([&] {
+			run();
+			// notified under the lock, the waiting thread may return and destroy it right after
+			std::lock_guard<std::mutex> lock{mutex};
+			finishedHelpers++;
+			finished.notify_one();
+		});
+	}
+	run();
+
+	std::unique_lock<std::mutex> lock{mutex};
+	finished.wait(lock, [&] { return finishedHelpers == helpers; });
+}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_thread_pool.hpp"
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// Triangles an object hides others with, in model space. Should not reach past the object's
+// surface, e.g. its walls without their trim, or a coarse LOD that stays inside the mesh.
+struct LveOccluder {
+	std::vector<glm::vec3> positions{};
+	std::vector<uint32_t> indices{};
+
+	// copies the positions and the indices of one LOD of builder
+	static std::shared_ptr<const LveOccluder> fromBuilder(const LveModel::Builder &builder, uint32_t lod = 0);
+	static std::shared_ptr<const LveOccluder> fromCache(const LveMeshCache &cache, uint32_t lod = 0);
+	// Goes through the model's mesh cache like the streamer does, the OBJ is only parsed (and
+	// the cache written) when there is no valid cache yet.
+	static std::shared_ptr<const LveOccluder> fromFile(const std::string &filepath, uint32_t lod = 0);
+};
+
+// Occlusion culling on the CPU, no device involved. The occluders of a frame are rasterized
+// into a small depth buffer, split into tiles that the worker threads fill in parallel, and
+// boxes are tested against it before any draw is recorded.
+//
+// Rasterization errs towards visibility: a pixel whose center a triangle covers takes the
+// farthest depth the triangle has within the pixel, and boxes are tested with a pixel of
+// margin, so one peeking past an occluder's silhouette still reaches an uncovered pixel.
+// Every 8x8 block of pixels also keeps its farthest depth, most boxes are decided from those.
+class LveOcclusionCuller {
+public:
+	static constexpr uint32_t TILE_WIDTH = 32;
+	static constexpr uint32_t TILE_HEIGHT = 16;
+	static constexpr uint32_t BLOCK_SIZE = 8;
+	// Workers beside the calling thread. Kept small: the frame's depth buffer is tiny and the
+	// asset streamer already runs a worker per spare core.
+	static constexpr unsigned DEFAULT_THREAD_COUNT = 2;
+
+	// model space bounding box placed by modelMatrix
+	struct Box {
+		glm::mat4 modelMatrix;
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	struct Stats {
+		uint32_t occluders = 0;
+		uint32_t occluderTriangles = 0;  // binned after clipping, too small ones are dropped
+		uint32_t testedBoxes = 0;
+		uint32_t occludedBoxes = 0;
+	};
+
+	// width and height are multiples of the tile size. 0 threads picks as many as
+	// LveThreadPool does.
+	LveOcclusionCuller(uint32_t width = 256, uint32_t height = 128, unsigned threadCount = DEFAULT_THREAD_COUNT);
+
+	LveOcclusionCuller(const LveOcclusionCuller &) = delete;
+	LveOcclusionCuller &operator=(const LveOcclusionCuller &) = delete;
+
+	// Clears the depth buffer for a frame seen through viewProjection (e.g. the camera's
+	// projection * view), which maps depth to [0, 1].
+	void beginFrame(const glm::mat4 &viewProjection);
+	// Bins the occluder's triangles, clipped against the near plane, into the tiles.
+	void addOccluder(const LveOccluder &occluder, const glm::mat4 &modelMatrix);
+	// Rasterizes the binned triangles and builds the block depths, across the worker threads.
+	void rasterize();
+
+	// false when the box lies behind the occluders everywhere it covers on screen. Boxes
+	// crossing the near plane or outside the view count as visible, that's the frustum's job.
+	bool isVisible(const Box &box) const;
+	// tests boxes across the worker threads, visible[i] is isVisible(boxes[i])
+	void testVisibility(const std::vector<Box> &boxes, std::vector<uint8_t> &visible);
+
+	uint32_t getWidth() const { return width; }
+	uint32_t getHeight() const { return height; }
+	// row major, 1 is the far plane
+	const std::vector<float> &getDepth() const { return depth; }
+	const Stats &getStats() const { return stats; }
+
+private:
+	// Screen space edge functions, positive inside, and the depth plane offset to the farthest
+	// depth within a pixel.
+	struct Triangle {
+		float edgeA[3], edgeB[3], edgeC[3];
+		float depthA, depthB, depthC;
+		int32_t minX, minY, maxX, maxY;  // pixels, inclusive
+	};
+
+	void binTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c);
+	void rasterizeTile(uint32_t tile);
+	// runs job(i) for i in [0, count) on the workers and the calling thread, returns when
+	// all have finished
+	void parallelFor(uint32_t count, const std::function<void(uint32_t)> &job);
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t tilesX;
+	uint32_t tilesY;
+	glm::mat4 viewProjection{1.f};
+
+	std::vector<float> depth;
+	std::vector<float> blockDepth;  // farthest depth of every 8x8 block
+	std::vector<Triangle> triangles{};
+	std::vector<std::vector<uint32_t>> tileBins;
+	std::vector<glm::vec4> clipPositions{};
+	Stats stats{};
+
+	LveThreadPool threadPool;
+};
+
+}
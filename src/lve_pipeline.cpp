@@ -21,8 +21,8 @@ LvePipeline::~LvePipeline() {
 	vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
 }
 
-	void LvePipeline::bind(VkCommandBuffer commandBuffer) {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	void LvePipeline::bind(LveCommandRecorder& recorder) {
+	recorder.bindPipeline(graphicsPipeline);
 }
 
 	std::vector<char> LvePipeline::readFile(const std::string& filePath) {
@@ -59,7 +59,7 @@ LvePipeline::~LvePipeline() {
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = config.vertSpecializationInfo;
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
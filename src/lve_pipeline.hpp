@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include "lve_command_recorder.hpp"
 #include "lve_device.hpp"
 #include "vulkan/vulkan_core.h"
 
@@ -26,6 +27,7 @@ struct PipeLineConfigInfo {
 	VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
 	std::vector<VkDynamicState> dynamicStateEnables;
 	VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+	const VkSpecializationInfo* vertSpecializationInfo = nullptr;
 	VkPipelineLayout pipelineLayout = nullptr;
 	VkRenderPass renderPass = nullptr;
 	uint32_t subpass = 0;
@@ -43,11 +45,11 @@ public:
 	static void defaultPipelineConfigInfo(PipeLineConfigInfo& configInfo);
 	static void enableAlphaBlending(PipeLineConfigInfo& configInfo);
 
-	void bind(VkCommandBuffer commandBuffer);
+	void bind(LveCommandRecorder& recorder);
 
+	static std::vector<char> readFile(const std::string& filePath);
 
 private:
-	static std::vector<char> readFile(const std::string& filePath);
 	
 	void createGraphicsPipeline(const std::string& vertFilePath, const std::string& fragFilePath, const PipeLineConfigInfo& config);
 
@@ -12,7 +12,6 @@
 #include <ctime>
 #include <stdexcept>
 #include <array>
-#include <map>
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_FORCE_RADIANS
@@ -94,29 +93,33 @@ void LvePointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo) {
 }
 
 void LvePointLightSystem::render(FrameInfo &frameInfo) {
-      std::map<float, LveGameObject::id_t> sorted;
+      // back to front, lights at the same distance all stay
+      lights.clear();
+      renderQueue.clear();
       for (auto& kv : frameInfo.gameObjects) {
         auto& obj = kv.second;
         if (obj.pointLight == nullptr) continue;
 
-        // calculate distance
-        auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
-        float disSquared = glm::dot(offset, offset);
-        sorted[disSquared] = obj.getId();
+        float distance = glm::length(frameInfo.camera.getPosition() - obj.transform.translation);
+        renderQueue.push(
+            LveRenderQueue::makeKey(LveRenderQueue::Pass::Transparent, 0, 0, 0, 0, LveRenderQueue::depthKey(distance, true)),
+            static_cast<uint32_t>(lights.size()));
+        lights.push_back(&obj);
       }
-      lvePipeline->bind(frameInfo.commandBuffer);
+      renderQueue.sort();
+      lvePipeline->bind(frameInfo.commandRecorder);
 
-      vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+      frameInfo.commandRecorder.bindDescriptorSets(pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 1, &frameInfo.globalUboOffset);
 
-      for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
-        auto& obj = frameInfo.gameObjects.at(it->second);
+      for (const auto& packet : renderQueue.getPackets()) {
+        const LveGameObject& obj = *lights[packet.index];
 
         PointLightPushConstants push{};
         push.position = glm::vec4(obj.transform.translation, 1.f);
         push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
         push.radius = obj.transform.scale.x;
 
-        vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PointLightPushConstants), &push);
+        frameInfo.commandRecorder.pushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PointLightPushConstants), &push);
         vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
     
     }
@@ -7,6 +7,7 @@
 #include "lve_renderer.hpp"
 #include "lve_game_object.hpp"
 #include "lve_camera.hpp"
+#include "lve_render_queue.hpp"
 #include "vulkan/vulkan_core.h"
 
 #include <memory>
@@ -33,6 +34,9 @@ private:
 
 	std::unique_ptr<LvePipeline> lvePipeline;
 	VkPipelineLayout pipelineLayout;
+
+	LveRenderQueue renderQueue{};
+	std::vector<const LveGameObject*> lights{};
 };
 
 }
@@ -0,0 +1,58 @@
+#include "lve_render_queue.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lve {
+
+uint64_t LveRenderQueue::makeKey(Pass pass, uint32_t pipeline, uint32_t geometry, uint32_t model, uint32_t lod, uint16_t depth) {
+	return (static_cast<uint64_t>(pass) & 0x3) << 62 |
+		(static_cast<uint64_t>(pipeline) & 0x3f) << 56 |
+		(static_cast<uint64_t>(geometry) & 0xff) << 48 |
+		(static_cast<uint64_t>(model) & 0xffffff) << 24 |
+		(static_cast<uint64_t>(lod) & 0xff) << 16 |
+		static_cast<uint64_t>(depth);
+}
+
+uint16_t LveRenderQueue::depthKey(float distance, bool farthestFirst) {
+	// the bits of a positive float grow with its value, the sign bit is always clear
+	distance = std::max(distance, 0.f);
+	uint32_t bits;
+	std::memcpy(&bits, &distance, sizeof(bits));
+	uint16_t key = static_cast<uint16_t>(bits >> 15);
+	return farthestFirst ? static_cast<uint16_t>(0xffff - key) : key;
+}
+
+void LveRenderQueue::sort() {
+	constexpr int BYTES = sizeof(uint64_t);
+	const size_t count = packets.size();
+	if (count < 2) return;
+
+	// the histograms of all bytes in one pass over the keys
+	uint32_t histograms[BYTES][256] = {};
+	for (const Packet &packet : packets) {
+		for (int byte = 0; byte < BYTES; byte++) {
+			histograms[byte][(packet.key >> (byte * 8)) & 0xff]++;
+		}
+	}
+
+	scratch.resize(count);
+	for (int byte = 0; byte < BYTES; byte++) {
+		uint32_t *histogram = histograms[byte];
+		// all keys share this byte, the pass wouldn't move anything
+		if (histogram[(packets[0].key >> (byte * 8)) & 0xff] == count) continue;
+
+		uint32_t offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++) {
+			uint32_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (const Packet &packet : packets) {
+			scratch[histogram[(packet.key >> (byte * 8)) & 0xff]++] = packet;
+		}
+		packets.swap(scratch);
+	}
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Draw packets of a frame, ordered by 64 bit sort keys. A system pushes a key and an index
+// into its own draw data for everything it wants to draw, sort() orders the packets with a
+// radix sort, and the system records them in that order. Keys put the expensive state in the
+// high bits, so packets binding the same state end up next to each other.
+class LveRenderQueue {
+public:
+	enum class Pass : uint64_t {
+		Opaque = 0,       // front to back, early depth testing rejects what's hidden
+		Transparent = 1,  // back to front, after the opaque pass
+	};
+
+	struct Packet {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	// high to low bits: pass (2) | pipeline (6) | geometry (8) | model (24) | lod (8) | depth (16),
+	// every field is truncated to its bits
+	static uint64_t makeKey(Pass pass, uint32_t pipeline, uint32_t geometry, uint32_t model, uint32_t lod, uint16_t depth);
+	// Depth field for a distance from the camera, the top bits of the float so it is finer up
+	// close. Transparent packets sort back to front with farthestFirst.
+	static uint16_t depthKey(float distance, bool farthestFirst = false);
+
+	void clear() { packets.clear(); }
+	void reserve(size_t count) { packets.reserve(count); }
+	void push(uint64_t key, uint32_t index) { packets.push_back({key, index}); }
+	// Stable, skips the bytes every key has in common.
+	void sort();
+
+	const std::vector<Packet> &getPackets() const { return packets; }
+	size_t size() const { return packets.size(); }
+
+private:
+	std::vector<Packet> packets{};
+	std::vector<Packet> scratch{};
+};
+
+}
@@ -12,6 +12,12 @@
 #include <ctime>
 #include <stdexcept>
 #include <array>
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
 
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_FORCE_RADIANS
@@ -19,32 +25,65 @@
 
 namespace lve {
 
-struct SimplePushConstantData {
+// Instance in simple.vert, read with gl_InstanceIndex
+struct InstanceData {
 	glm::mat4 modelMatrix{1.0f};
 	glm::mat4 normalMatrix{1.0f};
 };
 
-LveRenderSystem::LveRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{device} {
+// projected diameter of the model's bounding sphere as a fraction of the viewport height
+static float projectedSize(const LveCamera& camera, const glm::mat4& modelMatrix, float maxScale, const LveModel& model) {
+	float radius = model.getBoundsRadius() * maxScale;
+	const glm::mat4& projection = camera.getProjection();
+
+	// orthographic, the size doesn't depend on the distance
+	if (projection[3][3] == 1.f) {
+		return radius * std::fabs(projection[1][1]);
+	}
+
+	glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(model.getBoundsCenter(), 1.f));
+	float distance = glm::length(center - camera.getPosition());
+	if (distance <= radius) {
+		return std::numeric_limits<float>::infinity();
+	}
+	return radius * std::fabs(projection[1][1]) / distance;
+}
+
+LveRenderSystem::LveRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, LveFrameAllocator& frameAllocator) : lveDevice{device} {
+  indirectDraw = device.getEnabledFeatures().drawIndirectFirstInstance;
+  createInstanceDescriptorSet(frameAllocator);
   createPipelineLayout(globalSetLayout);
   createPipeline(renderPass);
 }
 
 LveRenderSystem::~LveRenderSystem() { vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr); }
 
-void LveRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
-  VkPushConstantRange pushConstantRange{};
-  pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-  pushConstantRange.offset = 0;
-  pushConstantRange.size = sizeof(SimplePushConstantData);
+void LveRenderSystem::setIndirectDraw(bool enabled) {
+  assert((!enabled || lveDevice.getEnabledFeatures().drawIndirectFirstInstance) && "Indirect draws need drawIndirectFirstInstance");
+  indirectDraw = enabled;
+}
+
+void LveRenderSystem::createInstanceDescriptorSet(LveFrameAllocator& frameAllocator) {
+  // the frame allocator's buffer never changes, draws pick their instances through
+  // firstInstance instead of rebinding
+  instancePool = LveDescriptorPool::Builder(lveDevice).setMaxSets(1).addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1).build();
+  instanceSetLayout = LveDescriptorSetLayout::Builder(lveDevice).addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT).build();
 
-  std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+  VkDescriptorBufferInfo bufferInfo{frameAllocator.getBuffer(), 0, VK_WHOLE_SIZE};
+  if (!LveDescriptorWriter(*instanceSetLayout, *instancePool).writeBuffer(0, &bufferInfo).build(instanceDescriptorSet)) {
+    throw std::runtime_error("failed to allocate instance descriptor set!");
+  }
+}
+
+void LveRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+  std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, instanceSetLayout->getDescriptorSetLayout()};
 
   VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
   pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-  pipelineLayoutInfo.pushConstantRangeCount = 1;
-  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  pipelineLayoutInfo.pushConstantRangeCount = 0;
+  pipelineLayoutInfo.pPushConstantRanges = nullptr;
   if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
       VK_SUCCESS) {
     throw std::runtime_error("failed to create pipeline layout!");
@@ -63,25 +102,444 @@ void LveRenderSystem::createPipeline(VkRenderPass renderPass) {
       "shaders/simple.vert.spv",
       "shaders/simple.frag.spv",
       pipelineConfig);
+
+  // same shaders with QUANTIZED_VERTICES set for models using LveModel::QuantizedVertex
+  VkBool32 quantizedVertices = VK_TRUE;
+  VkSpecializationMapEntry specializationEntry{0, 0, sizeof(VkBool32)};
+  VkSpecializationInfo specializationInfo{};
+  specializationInfo.mapEntryCount = 1;
+  specializationInfo.pMapEntries = &specializationEntry;
+  specializationInfo.dataSize = sizeof(VkBool32);
+  specializationInfo.pData = &quantizedVertices;
+
+  pipelineConfig.bindingDescriptions = LveModel::QuantizedVertex::getBindingDescriptions();
+  pipelineConfig.attributeDescriptions = LveModel::QuantizedVertex::getAttributeDescriptions();
+  pipelineConfig.vertSpecializationInfo = &specializationInfo;
+  quantizedPipeline = std::make_unique<LvePipeline>(
+      lveDevice,
+      "shaders/simple.vert.spv",
+      "shaders/simple.frag.spv",
+      pipelineConfig);
 }
 
-void LveRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
-	lvePipeline->bind(frameInfo.commandBuffer);
+void LveRenderSystem::resetLodStats() {
+	lodStats.triangles = 0;
+	lodStats.fullDetailTriangles = 0;
+	lodStats.culledTriangles = 0;
+	lodStats.drawCalls = 0;
+	lodStats.indirectCommands = 0;
+	lodStats.frustumCulledObjects = 0;
+	lodStats.occlusionCulledObjects = 0;
+	std::fill(lodStats.objectsPerLod.begin(), lodStats.objectsPerLod.end(), 0u);
+}
 
-	vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frameInfo.globalDescriptorSet, 0, nullptr);
+bool LveRenderSystem::makeCullCandidate(LveGameObject& obj, CullCandidate& candidate) {
+	// Streamed in models show up once their upload has completed. Evicted ones are still
+	// culled with the bounds they had and reload once they become visible again.
+	glm::vec3 boundsMin, boundsMax;
+	if (!obj.model.getBounds(boundsMin, boundsMax)) return false;
+
+	const glm::vec3& scale = obj.transform.scale;
+	float maxScale = std::max({std::fabs(scale.x), std::fabs(scale.y), std::fabs(scale.z)});
+	glm::mat4 modelMatrix = obj.transform.mat4();
+	glm::vec3 center = glm::vec3(modelMatrix * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.f));
+	float radius = glm::length(boundsMax - boundsMin) * 0.5f * maxScale;
+	candidate = {&obj, obj.model.peek(), modelMatrix, center, radius, maxScale, boundsMin, boundsMax};
+	return true;
+}
 
+void LveRenderSystem::collectDrawItems(FrameInfo &frameInfo) {
+	resetLodStats();
+
+	// every object's world space bounding sphere, tested against the frustum in one pass
+	cullCandidates.clear();
+	frustumCuller.clear();
 	for (auto& kv : frameInfo.gameObjects) {
-		auto& obj = kv.second;
+		CullCandidate candidate;
+		if (!makeCullCandidate(kv.second, candidate)) continue;
+		frustumCuller.addSphere(candidate.center, candidate.radius);
+		cullCandidates.push_back(candidate);
+	}
+	visibleObjects.clear();
+	frustumCuller.cull(frameInfo.camera.getFrustum(), visibleObjects);
+	lodStats.frustumCulledObjects = static_cast<uint32_t>(cullCandidates.size() - visibleObjects.size());
+	if (occlusionCuller != nullptr) {
+		cullOccludedObjects(frameInfo);
+	}
+
+	drawItems.clear();
+	renderQueue.clear();
+	for (uint32_t index : visibleObjects) {
+		const CullCandidate& candidate = cullCandidates[index];
+		// only what survived culling counts as used, the rest may be evicted
+		candidate.object->model.touch();
+		if (candidate.model == nullptr) continue;
+		pushDrawItem(frameInfo, candidate);
+	}
+	sortDrawItems();
+}
+
+void LveRenderSystem::collectGpuDrawItems(FrameInfo &frameInfo) {
+	resetLodStats();
+
+	// no visibility on the CPU, everything with a model goes to the GPU culler
+	drawItems.clear();
+	renderQueue.clear();
+	evictedCandidates.clear();
+	for (auto& kv : frameInfo.gameObjects) {
+		CullCandidate candidate;
+		if (!makeCullCandidate(kv.second, candidate)) continue;
+		if (candidate.model == nullptr) {
+			evictedCandidates.push_back(candidate);
+			continue;
+		}
+		pushDrawItem(frameInfo, candidate);
+	}
+	sortDrawItems();
+}
+
+void LveRenderSystem::pushDrawItem(FrameInfo &frameInfo, const CullCandidate& candidate) {
+	LveModel* model = candidate.model;
+	const glm::mat4& modelMatrix = candidate.modelMatrix;
+
+	LvePipeline* pipeline = model->getVertexFormat() == LveModel::VertexFormat::Quantized
+		? quantizedPipeline.get()
+		: lvePipeline.get();
+
+	uint32_t lod = 0;
+	if (model->getLods().size() > 1) {
+		lod = model->selectLod(projectedSize(frameInfo.camera, modelMatrix, candidate.maxScale, *model));
+	}
+	if (!model->getLods().empty()) {
+		if (lodStats.objectsPerLod.size() <= lod) lodStats.objectsPerLod.resize(lod + 1, 0u);
+		lodStats.objectsPerLod[lod]++;
+		lodStats.triangles += model->getLods()[lod].indexCount / 3;
+		lodStats.fullDetailTriangles += model->getLods()[0].indexCount / 3;
+	}
+
+	// the arenas of a frame get small ids in order of appearance
+	const LveGeometryArena* arena = &model->getGeometryArena();
+	auto arenaIt = std::find(sortArenas.begin(), sortArenas.end(), arena);
+	if (arenaIt == sortArenas.end()) arenaIt = sortArenas.insert(sortArenas.end(), arena);
+	uint32_t geometry = static_cast<uint32_t>(arenaIt - sortArenas.begin()) << 1 |
+		(model->getIndexType() == VK_INDEX_TYPE_UINT32 ? 1u : 0u);
+
+	renderQueue.push(
+		LveRenderQueue::makeKey(
+			LveRenderQueue::Pass::Opaque,
+			pipeline == quantizedPipeline.get() ? 1 : 0,
+			geometry,
+			model->getId(),
+			lod,
+			LveRenderQueue::depthKey(glm::length(candidate.center - frameInfo.camera.getPosition()))),
+		static_cast<uint32_t>(drawItems.size()));
+	drawItems.push_back({candidate.object, model, pipeline, lod, modelMatrix, candidate.object->transform.normalMatrix()});
+}
+
+void LveRenderSystem::sortDrawItems() {
+	// Draws are ordered by pipeline, then bound buffers, model and LOD, and front to back
+	// within a model and LOD. That keeps the groups of instances and indirect batches
+	// contiguous, and the instances of a group reach early depth testing nearest first.
+	sortArenas.clear();
+	if (sortDraws) renderQueue.sort();
+	sortedDrawItems.clear();
+	for (const auto& packet : renderQueue.getPackets()) {
+		sortedDrawItems.push_back(drawItems[packet.index]);
+	}
+	drawItems.swap(sortedDrawItems);
+}
 
-		if (obj.model == nullptr) continue;		
-		SimplePushConstantData push{};
-		push.modelMatrix = obj.transform.mat4();
-		push.normalMatrix = obj.transform.normalMatrix();
+void LveRenderSystem::cullOccludedObjects(FrameInfo &frameInfo) {
+	occlusionCuller->beginFrame(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+	occlusionBoxes.clear();
+	for (uint32_t index : visibleObjects) {
+		const CullCandidate& candidate = cullCandidates[index];
+		if (candidate.object->occluder) {
+			occlusionCuller->addOccluder(*candidate.object->occluder, candidate.modelMatrix);
+		}
+		occlusionBoxes.push_back({candidate.modelMatrix, candidate.boundsMin, candidate.boundsMax});
+	}
+	if (occlusionCuller->getStats().occluders == 0) return;
+
+	occlusionCuller->rasterize();
+	occlusionCuller->testVisibility(occlusionBoxes, occlusionVisibility);
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < visibleObjects.size(); i++) {
+		if (occlusionVisibility[i]) visibleObjects[visibleCount++] = visibleObjects[i];
+	}
+	lodStats.occlusionCulledObjects = static_cast<uint32_t>(visibleObjects.size() - visibleCount);
+	visibleObjects.resize(visibleCount);
+}
+
+void LveRenderSystem::cullGameObjects(FrameInfo &frameInfo, LveGpuCuller &culler) {
+	touchVisibleObjects(frameInfo, culler);
+	collectGpuDrawItems(frameInfo);
+	cullObjects.clear();
+	cullBatches.clear();
+	indirectBatches.clear();
+	unculledItems.clear();
+	std::vector<LveGameObject::id_t>& owners = cullObjectOwners[frameInfo.frameIndex];
+
+	const uint32_t maxDrawCount = maxIndirectDrawCount();
+	for (const DrawItem& item : drawItems) {
+		LveModel* model = item.model;
+		if (!model->hasIndices()) {
+			// drawn without culling, so always in use
+			item.object->model.touch();
+			unculledItems.push_back(item);
+			continue;
+		}
 
-		vkCmdPushConstants(frameInfo.commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-		
-		obj.model->bind(frameInfo.commandBuffer);
-		obj.model->draw(frameInfo.commandBuffer);
+		float maxScale = std::max({
+			glm::length(glm::vec3(item.modelMatrix[0])),
+			glm::length(glm::vec3(item.modelMatrix[1])),
+			glm::length(glm::vec3(item.modelMatrix[2]))});
+		glm::vec4 boundingSphere{
+			glm::vec3(item.modelMatrix * glm::vec4(model->getBoundsCenter(), 1.f)),
+			model->getBoundsRadius() * maxScale};
+		glm::mat4 objectMatrix = item.modelMatrix * model->getPositionTransform();
+
+		// split meshes are an object per 16 bit range, culled alike
+		indirectCommands.clear();
+		const LveModel::Lod& lod = model->getLods()[item.lod];
+		model->appendDrawCommands(lod.firstIndex, lod.indexCount, 1, 0, indirectCommands);
+		for (const auto& command : indirectCommands) {
+			// a batch is one indirect count draw, which draws at most maxDrawCount commands
+			if (indirectBatches.empty() || indirectBatches.back().pipeline != item.pipeline ||
+					&indirectBatches.back().model->getGeometryArena() != &model->getGeometryArena() ||
+					indirectBatches.back().model->getIndexType() != model->getIndexType() ||
+					indirectBatches.back().commandCount == maxDrawCount) {
+				indirectBatches.push_back({item.pipeline, model, static_cast<uint32_t>(cullObjects.size()), 0});
+				cullBatches.push_back({0, static_cast<uint32_t>(cullObjects.size())});
+			}
+			cullObjects.push_back({
+				objectMatrix,
+				item.normalMatrix,
+				boundingSphere,
+				command.firstIndex,
+				command.indexCount,
+				command.vertexOffset,
+				static_cast<uint32_t>(cullBatches.size() - 1)});
+			owners.push_back(item.object->getId());
+			indirectBatches.back().commandCount++;
+		}
+	}
+
+	// Objects whose model was evicted draw nothing, they are culled only to learn whether to
+	// bring the model back. Their batch has no indirect draw, its commands are never read.
+	if (!evictedCandidates.empty()) {
+		const uint32_t batch = static_cast<uint32_t>(cullBatches.size());
+		cullBatches.push_back({0, static_cast<uint32_t>(cullObjects.size())});
+		for (const CullCandidate& candidate : evictedCandidates) {
+			cullObjects.push_back({
+				candidate.modelMatrix,
+				glm::mat4{1.f},
+				glm::vec4{candidate.center, candidate.radius},
+				0,
+				0,
+				0,
+				batch});
+			owners.push_back(candidate.object->getId());
+		}
 	}
+
+	cullOutput = culler.cull(frameInfo, cullObjects, cullBatches);
+	cullCompactsDraws = culler.compactsDraws();
+	gpuCulledFrame = true;
 }
+
+void LveRenderSystem::touchVisibleObjects(FrameInfo &frameInfo, LveGpuCuller &culler) {
+	// the results of the last cull with this frame index, the swap chain waited for it
+	std::vector<LveGameObject::id_t>& owners = cullObjectOwners[frameInfo.frameIndex];
+	uint32_t count = 0;
+	const uint32_t* visibility = culler.getVisibility(frameInfo.frameIndex, count);
+	for (uint32_t i = 0; i < count && i < owners.size(); i++) {
+		if (visibility[i] == 0) continue;
+		auto it = frameInfo.gameObjects.find(owners[i]);
+		if (it != frameInfo.gameObjects.end()) it->second.model.touch();
+	}
+	owners.clear();
+}
+
+void LveRenderSystem::renderGameObjects(FrameInfo &frameInfo) {
+	// the recorder counts the whole frame, this system's share is what it adds meanwhile
+	const LveCommandRecorder::Stats before = frameInfo.commandRecorder.getStats();
+	if (gpuCulledFrame) {
+		gpuCulledFrame = false;
+		renderCulledGameObjects(frameInfo);
+	} else {
+		collectDrawItems(frameInfo);
+		recordDrawItems(frameInfo);
+	}
+	const LveCommandRecorder::Stats& after = frameInfo.commandRecorder.getStats();
+	for (size_t i = 0; i < LveCommandRecorder::COMMAND_COUNT; i++) {
+		lodStats.commands.issued[i] = after.issued[i] - before.issued[i];
+		lodStats.commands.elided[i] = after.elided[i] - before.elided[i];
+	}
+}
+
+void LveRenderSystem::recordDrawItems(FrameInfo &frameInfo) {
+	if (drawItems.empty()) return;
+
+	auto instanceAllocation = frameInfo.frameAllocator.allocate(drawItems.size() * sizeof(InstanceData), sizeof(InstanceData));
+	auto* instances = static_cast<InstanceData*>(instanceAllocation.mapped);
+	for (size_t i = 0; i < drawItems.size(); i++) {
+		instances[i].modelMatrix = drawItems[i].modelMatrix * drawItems[i].model->getPositionTransform();
+		instances[i].normalMatrix = drawItems[i].normalMatrix;
+	}
+	const uint32_t baseInstance = static_cast<uint32_t>(instanceAllocation.offset / sizeof(InstanceData));
+
+	// both pipelines share the layout, so the descriptor sets survive switching between them
+	VkDescriptorSet descriptorSets[] = {frameInfo.globalDescriptorSet, instanceDescriptorSet};
+	frameInfo.commandRecorder.bindDescriptorSets(pipelineLayout, 0, 2, descriptorSets, 1, &frameInfo.globalUboOffset);
+	const glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+	indirectCommands.clear();
+	indirectBatches.clear();
+
+	for (size_t begin = 0, end = 0; begin < drawItems.size(); begin = end) {
+		const DrawItem& first = drawItems[begin];
+		end = begin + 1;
+		while (end < drawItems.size() && drawItems[end].model == first.model && drawItems[end].lod == first.lod) end++;
+
+		LveModel* model = first.model;
+		const uint32_t instanceCount = static_cast<uint32_t>(end - begin);
+		const uint32_t firstInstance = baseInstance + static_cast<uint32_t>(begin);
+
+		// meshlets only cover LOD 0, coarser LODs are small enough to draw whole. The group
+		// draws every meshlet any of its instances can see.
+		const auto& meshlets = model->getMeshlets();
+		const bool cullMeshlets = first.lod == 0 && !meshlets.empty();
+		if (cullMeshlets) {
+			meshletVisibility.assign(meshlets.size(), 0);
+			for (size_t i = begin; i < end; i++) {
+				const glm::mat4& modelMatrix = drawItems[i].modelMatrix;
+				LveFrustum frustum = LveFrustum::fromMatrix(viewProjection * modelMatrix);
+				glm::vec3 cameraPosition = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(frameInfo.camera.getPosition(), 1.f));
+				LveMeshletCuller::markVisible(meshlets, frustum, cameraPosition, meshletVisibility);
+			}
+
+			visibleMeshlets.clear();
+			uint32_t visibleTriangles = LveMeshletCuller::collectRanges(meshlets, meshletVisibility, visibleMeshlets);
+			uint32_t culledTriangles = (model->getLods()[0].indexCount / 3 - visibleTriangles) * instanceCount;
+			lodStats.culledTriangles += culledTriangles;
+			lodStats.triangles -= culledTriangles;
+			if (visibleMeshlets.empty()) continue;
+		}
+
+		if (indirectDraw && model->hasIndices()) {
+			if (indirectBatches.empty() || indirectBatches.back().pipeline != first.pipeline ||
+					&indirectBatches.back().model->getGeometryArena() != &model->getGeometryArena() ||
+					indirectBatches.back().model->getIndexType() != model->getIndexType()) {
+				indirectBatches.push_back({first.pipeline, model, static_cast<uint32_t>(indirectCommands.size()), 0});
+			}
+			if (cullMeshlets) {
+				for (const auto& range : visibleMeshlets) {
+					model->appendDrawCommands(range.firstIndex, range.indexCount, instanceCount, firstInstance, indirectCommands);
+				}
+			} else {
+				const LveModel::Lod& lod = model->getLods()[first.lod];
+				model->appendDrawCommands(lod.firstIndex, lod.indexCount, instanceCount, firstInstance, indirectCommands);
+			}
+			indirectBatches.back().commandCount = static_cast<uint32_t>(indirectCommands.size()) - indirectBatches.back().firstCommand;
+			continue;
+		}
+
+		first.pipeline->bind(frameInfo.commandRecorder);
+		model->bind(frameInfo.commandRecorder);
+
+		if (cullMeshlets) {
+			for (const auto& range : visibleMeshlets) {
+				model->drawIndexed(frameInfo.commandBuffer, range.firstIndex, range.indexCount, instanceCount, firstInstance);
+				lodStats.drawCalls++;
+			}
+		} else {
+			model->draw(frameInfo.commandBuffer, first.lod, instanceCount, firstInstance);
+			lodStats.drawCalls++;
+		}
+	}
+
+	if (indirectCommands.empty()) return;
+	auto commandAllocation = frameInfo.frameAllocator.upload(
+		indirectCommands.data(),
+		indirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand),
+		sizeof(VkDrawIndexedIndirectCommand));
+	recordIndirectBatches(frameInfo, commandAllocation.buffer, commandAllocation.offset, VK_WHOLE_SIZE);
+}
+
+void LveRenderSystem::renderCulledGameObjects(FrameInfo &frameInfo) {
+	VkDescriptorSet descriptorSets[] = {frameInfo.globalDescriptorSet, instanceDescriptorSet};
+	frameInfo.commandRecorder.bindDescriptorSets(pipelineLayout, 0, 2, descriptorSets, 1, &frameInfo.globalUboOffset);
+
+	// models without indices don't fit an indexed indirect draw, they are drawn as they are
+	if (!unculledItems.empty()) {
+		auto instanceAllocation = frameInfo.frameAllocator.allocate(unculledItems.size() * sizeof(InstanceData), sizeof(InstanceData));
+		auto* instances = static_cast<InstanceData*>(instanceAllocation.mapped);
+		const uint32_t baseInstance = static_cast<uint32_t>(instanceAllocation.offset / sizeof(InstanceData));
+		for (size_t i = 0; i < unculledItems.size(); i++) {
+			const DrawItem& item = unculledItems[i];
+			instances[i].modelMatrix = item.modelMatrix * item.model->getPositionTransform();
+			instances[i].normalMatrix = item.normalMatrix;
+			item.pipeline->bind(frameInfo.commandRecorder);
+			item.model->bind(frameInfo.commandRecorder);
+			item.model->draw(frameInfo.commandBuffer, item.lod, 1, baseInstance + static_cast<uint32_t>(i));
+			lodStats.drawCalls++;
+		}
+	}
+
+	if (cullObjects.empty()) return;
+	recordIndirectBatches(
+		frameInfo,
+		cullOutput.buffer,
+		cullOutput.drawCommandOffset,
+		cullCompactsDraws ? cullOutput.batchOffset : VK_WHOLE_SIZE);
+}
+
+void LveRenderSystem::recordIndirectBatches(
+		FrameInfo& frameInfo,
+		VkBuffer buffer,
+		VkDeviceSize commandOffset,
+		VkDeviceSize countOffset) {
+	constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	const uint32_t maxDrawCount = maxIndirectDrawCount();
+	for (size_t b = 0; b < indirectBatches.size(); b++) {
+		const IndirectBatch& batch = indirectBatches[b];
+		batch.pipeline->bind(frameInfo.commandRecorder);
+		batch.model->bind(frameInfo.commandRecorder);
+		lodStats.indirectCommands += batch.commandCount;
+
+		if (countOffset != VK_WHOLE_SIZE) {
+			// cullGameObjects() split the batches at the limit, the count is never above it
+			assert(batch.commandCount <= maxDrawCount && "Indirect count batch exceeds maxDrawIndirectCount");
+			lveDevice.cmdDrawIndexedIndirectCount(
+				frameInfo.commandBuffer,
+				buffer,
+				commandOffset + batch.firstCommand * stride,
+				buffer,
+				countOffset + b * sizeof(LveGpuCuller::Batch) + offsetof(LveGpuCuller::Batch, drawCount),
+				batch.commandCount,
+				stride);
+			lodStats.drawCalls++;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < batch.commandCount; i += maxDrawCount) {
+			uint32_t drawCount = std::min(maxDrawCount, batch.commandCount - i);
+			vkCmdDrawIndexedIndirect(
+				frameInfo.commandBuffer,
+				buffer,
+				commandOffset + (batch.firstCommand + i) * stride,
+				drawCount,
+				stride);
+			lodStats.drawCalls++;
+		}
+	}
+}
+
+uint32_t LveRenderSystem::maxIndirectDrawCount() const {
+	// without multiDrawIndirect every indirect draw reads a single command
+	return lveDevice.getEnabledFeatures().multiDrawIndirect
+		? std::max(lveDevice.properties.limits.maxDrawIndirectCount, 1u)
+		: 1u;
+}
+
 }
@@ -7,6 +7,14 @@
 #include "lve_renderer.hpp"
 #include "lve_game_object.hpp"
 #include "lve_camera.hpp"
+#include "lve_command_recorder.hpp"
+#include "lve_descriptors.hpp"
+#include "lve_frame_allocator.hpp"
+#include "lve_frustum_culler.hpp"
+#include "lve_gpu_culler.hpp"
+#include "lve_meshlet_culler.hpp"
+#include "lve_occlusion_culler.hpp"
+#include "lve_render_queue.hpp"
 #include "vulkan/vulkan_core.h"
 
 #include <memory>
@@ -16,21 +24,154 @@ namespace lve {
 
 class LveRenderSystem {
 public:
-	LveRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+	// instance data is streamed through frameAllocator
+	LveRenderSystem(LveDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, LveFrameAllocator& frameAllocator);
 	~LveRenderSystem();
 
 	LveRenderSystem(const LveRenderSystem&) = delete;
 	LveRenderSystem &operator=(const LveRenderSystem&) = delete;
 
+	// triangle counts of the last renderGameObjects call, before culling when it was culled on
+	// the GPU (see LveGpuCuller::getStats())
+	struct LodStats {
+		uint32_t triangles = 0;
+		uint32_t fullDetailTriangles = 0;  // what LOD 0 everywhere would have drawn
+		uint32_t culledTriangles = 0;      // LOD 0 triangles skipped by meshlet culling
+		uint32_t drawCalls = 0;
+		uint32_t indirectCommands = 0;    // draws the indirect calls among drawCalls carried
+		uint32_t frustumCulledObjects = 0;  // on the CPU, 0 when it was culled on the GPU
+		uint32_t occlusionCulledObjects = 0;
+		std::vector<uint32_t> objectsPerLod{};
+		// the recorder calls of renderGameObjects alone, binds it issued and binds it elided
+		LveCommandRecorder::Stats commands{};
+	};
+
 	void renderGameObjects(FrameInfo& frameInfo);
+	// GPU driven path: records the culling pass for the frame's objects, outside of the render
+	// pass. The next renderGameObjects() draws what survives with indirect count draws. The CPU
+	// culls nothing, every object goes to the culler, and the models of what it saw are
+	// touched for eviction once its results come back MAX_FRAMES_IN_FLIGHT frames later.
+	void cullGameObjects(FrameInfo& frameInfo, LveGpuCuller& culler);
+
+	const LodStats& getLodStats() const { return lodStats; }
+
+	// Indexed draws are written to an indirect buffer and recorded with one
+	// vkCmdDrawIndexedIndirect per pipeline and bound buffers, instead of one draw per model.
+	// On by default when the device supports drawIndirectFirstInstance.
+	void setIndirectDraw(bool enabled);
+	bool isIndirectDraw() const { return indirectDraw; }
+
+	// Draws are ordered by their render queue keys. Turned off, they are recorded in the order
+	// the objects were visited, for comparing the binds in LodStats::commands. On by default.
+	void setSortDraws(bool enabled) { sortDraws = enabled; }
+	bool isSortDraws() const { return sortDraws; }
+
+	// Objects that pass the frustum are also tested against the occluders of the objects in
+	// view before their draws are recorded. nullptr turns it off, the culler has to outlive
+	// the render system otherwise.
+	void setOcclusionCuller(LveOcclusionCuller* culler) { occlusionCuller = culler; }
+
 private:
+	// an object to draw, objects with the same model and LOD are drawn as one instanced draw
+	struct DrawItem {
+		LveGameObject* object;
+		LveModel* model;
+		LvePipeline* pipeline;
+		uint32_t lod;
+		glm::mat4 modelMatrix;
+		glm::mat4 normalMatrix;
+	};
+
+	// consecutive indirect commands that draw with the same pipeline and buffers as model
+	struct IndirectBatch {
+		LvePipeline* pipeline;
+		const LveModel* model;
+		uint32_t firstCommand;
+		uint32_t commandCount;
+	};
+
+	// an object with a model, before frustum culling
+	struct CullCandidate {
+		LveGameObject* object;
+		LveModel* model;  // nullptr while an evicted model reloads
+		glm::mat4 modelMatrix;
+		glm::vec3 center;  // of the world space bounding sphere
+		float radius;
+		float maxScale;
+		glm::vec3 boundsMin;  // model space
+		glm::vec3 boundsMax;
+	};
+
+	void createInstanceDescriptorSet(LveFrameAllocator& frameAllocator);
 	void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 	void createPipeline(VkRenderPass renderPass);
+	void resetLodStats();
+	// false for objects without a model or whose model hasn't been built yet
+	bool makeCullCandidate(LveGameObject& obj, CullCandidate& candidate);
+	// fills drawItems with the visible objects in render queue order, and the LOD stats
+	void collectDrawItems(FrameInfo& frameInfo);
+	// Same for cullGameObjects() without culling anything, every object with a resident model
+	// becomes a draw item. Objects whose model was evicted go to evictedCandidates.
+	void collectGpuDrawItems(FrameInfo& frameInfo);
+	// adds a draw item for the candidate's model at its LOD and its render queue key
+	void pushDrawItem(FrameInfo& frameInfo, const CullCandidate& candidate);
+	void sortDrawItems();
+	// touches the models of the objects the culler saw the last time it ran with this frame index
+	void touchVisibleObjects(FrameInfo& frameInfo, LveGpuCuller& culler);
+	// one instanced draw per run of drawItems with the same model and LOD
+	void recordDrawItems(FrameInfo& frameInfo);
+	// drops the objects in visibleObjects hidden behind occluders
+	void cullOccludedObjects(FrameInfo& frameInfo);
+	void renderCulledGameObjects(FrameInfo& frameInfo);
+	// Draws indirectBatches from the commands at commandOffset. countOffset is the
+	// LveGpuCuller::Batch array holding the draw counts, VK_WHOLE_SIZE draws every command.
+	void recordIndirectBatches(
+		FrameInfo& frameInfo,
+		VkBuffer buffer,
+		VkDeviceSize commandOffset,
+		VkDeviceSize countOffset);
+	// commands one vkCmdDrawIndexedIndirect(Count) may draw
+	uint32_t maxIndirectDrawCount() const;
 	
 	LveDevice& lveDevice;
 
+	std::unique_ptr<LveDescriptorPool> instancePool;
+	std::unique_ptr<LveDescriptorSetLayout> instanceSetLayout;
+	VkDescriptorSet instanceDescriptorSet;
+
 	std::unique_ptr<LvePipeline> lvePipeline;
+	std::unique_ptr<LvePipeline> quantizedPipeline;
 	VkPipelineLayout pipelineLayout;
+
+	LodStats lodStats{};
+
+	LveFrustumCuller frustumCuller{};
+	std::vector<CullCandidate> cullCandidates{};
+	std::vector<uint32_t> visibleObjects{};
+	LveOcclusionCuller* occlusionCuller = nullptr;
+	std::vector<LveOcclusionCuller::Box> occlusionBoxes{};
+	std::vector<uint8_t> occlusionVisibility{};
+	std::vector<DrawItem> drawItems{};
+	bool sortDraws = true;
+	LveRenderQueue renderQueue{};
+	std::vector<DrawItem> sortedDrawItems{};
+	std::vector<const LveGeometryArena*> sortArenas{};
+	std::vector<uint8_t> meshletVisibility{};
+	std::vector<LveMeshletCuller::Range> visibleMeshlets{};
+
+	bool indirectDraw = false;
+	std::vector<VkDrawIndexedIndirectCommand> indirectCommands{};
+	std::vector<IndirectBatch> indirectBatches{};
+
+	bool gpuCulledFrame = false;
+	bool cullCompactsDraws = false;
+	std::vector<LveGpuCuller::Object> cullObjects{};
+	std::vector<LveGpuCuller::Batch> cullBatches{};
+	std::vector<CullCandidate> evictedCandidates{};
+	// the game object of every entry of the object table, per frame in flight
+	std::vector<LveGameObject::id_t> cullObjectOwners[LveSwapChain::MAX_FRAMES_IN_FLIGHT];
+	std::vector<DrawItem> unculledItems{};
+	LveGpuCuller::Output cullOutput{};
 };
 
 }
@@ -11,7 +11,7 @@
 
 namespace lve {
 
-LveRenderer::LveRenderer(LveWindow& window, LveDevice& device) : lveWindow{window}, lveDevice{device} {
+LveRenderer::LveRenderer(LveWindow& window, LveDevice& device) : lveWindow{window}, lveDevice{device}, frameAllocator{device} {
 	recreateSwapChain();
 	createCommandBuffers();
 }
@@ -72,6 +72,8 @@ VkCommandBuffer LveRenderer::beginFrame() {
 	}
 
 	isFrameStarted = true;
+	// acquireNextImage waited for the fence of the last frame with this index
+	frameAllocator.beginFrame(currentFrameIndex);
 
 	auto commandBuffer = getCurrentCommandBuffer();
 	VkCommandBufferBeginInfo beginInfo{};
@@ -80,12 +82,14 @@ VkCommandBuffer LveRenderer::beginFrame() {
 	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
 		throw std::runtime_error("failed to begin recording command buffer!");
 	}
+	commandRecorder.begin(commandBuffer);
 	return commandBuffer;
 }
 
 void LveRenderer::endFrame() {
 	assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
 	auto commandBuffer = getCurrentCommandBuffer();
+	frameAllocator.endFrame();
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 		throw std::runtime_error("failed to record command buffer!");
 	}
@@ -2,7 +2,9 @@
 
 #include "glm/fwd.hpp"
 #include "lve_window.hpp"
+#include "lve_command_recorder.hpp"
 #include "lve_device.hpp"
+#include "lve_frame_allocator.hpp"
 #include "lve_swap_chain.hpp"
 #include "vulkan/vulkan_core.h"
 
@@ -38,6 +40,16 @@ public:
 	void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
 	float getAspectRatio() const { return lveSwapChain->extentAspectRatio(); }
+	VkExtent2D getSwapChainExtent() const { return lveSwapChain->getSwapChainExtent(); }
+	// depth buffer of the image being rendered, valid after its render pass has ended
+	LveDepthAttachment getCurrentDepthAttachment() const {
+		assert(isFrameStarted && "Cannot get depth attachment when frame not in progress");
+		return lveSwapChain->getDepthAttachment(currentImageIndex);
+	}
+	// per frame uniform/storage/draw data, reset at the start of every frame
+	LveFrameAllocator &getFrameAllocator() { return frameAllocator; }
+	// graphics state of the frame's command buffer, its stats count the frame so far
+	LveCommandRecorder &getCommandRecorder() { return commandRecorder; }
 
 private:
 	void createCommandBuffers();
@@ -49,6 +61,8 @@ private:
 	LveDevice& lveDevice;
 	std::unique_ptr<LveSwapChain> lveSwapChain;
 	std::vector<VkCommandBuffer> commandBuffers;
+	LveFrameAllocator frameAllocator;
+	LveCommandRecorder commandRecorder;
 
 	uint32_t currentImageIndex;
 	int currentFrameIndex{0};
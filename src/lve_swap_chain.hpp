@@ -12,6 +12,15 @@
 
 namespace lve {
 
+// depth buffer the render pass leaves in DEPTH_STENCIL_ATTACHMENT_OPTIMAL, stored and
+// sampleable so it can be read after the pass (see LveDepthPyramid)
+struct LveDepthAttachment {
+    VkImage image;
+    VkImageView view;
+    VkFormat format;
+    VkExtent2D extent;
+};
+
 class LveSwapChain {
 public:
     static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
@@ -26,6 +35,9 @@ public:
     VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
     VkRenderPass getRenderPass() { return renderPass; }
     VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+    LveDepthAttachment getDepthAttachment(int index) {
+        return {depthImages[index], depthImageViews[index], swapChainDepthFormat, swapChainExtent};
+    }
     size_t imageCount() { return swapChainImages.size(); }
     VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
     VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -68,7 +80,7 @@ private:
     VkRenderPass renderPass;
 
     std::vector<VkImage> depthImages;
-    std::vector<VkDeviceMemory> depthImageMemorys;
+    std::vector<LveMemoryAllocation> depthImageMemorys;
     std::vector<VkImageView> depthImageViews;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
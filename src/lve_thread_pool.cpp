@@ -0,0 +1,53 @@
+#include "lve_thread_pool.hpp"
+
+#include <algorithm>
+
+namespace lve {
+
+LveThreadPool::LveThreadPool(unsigned threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+	workers.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; i++) {
+		workers.emplace_back(&LveThreadPool::workerLoop, this);
+	}
+}
+
+LveThreadPool::~LveThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		stopping = true;
+		jobs.clear();
+	}
+	jobAvailable.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void LveThreadPool::submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		jobs.push_back(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+void LveThreadPool::workerLoop() {
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock{mutex};
+			jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+// Fixed set of worker threads running submitted jobs in FIFO order. Jobs still queued when
+// the pool is destroyed are dropped, running ones are waited for.
+class LveThreadPool {
+public:
+	// 0 picks one thread less than the hardware has, leaving a core for the render thread
+	explicit LveThreadPool(unsigned threadCount = 0);
+	~LveThreadPool();
+
+	LveThreadPool(const LveThreadPool &) = delete;
+	LveThreadPool &operator=(const LveThreadPool &) = delete;
+
+	void submit(std::function<void()> job);
+
+	size_t getThreadCount() const { return workers.size(); }
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	bool stopping = false;
+};
+
+}
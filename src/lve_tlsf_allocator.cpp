@@ -0,0 +1,213 @@
+#include "lve_tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lve {
+
+namespace {
+
+inline uint32_t highestBit(uint64_t value) { return 63 - static_cast<uint32_t>(__builtin_clzll(value)); }
+inline uint32_t lowestBit(uint64_t value) { return static_cast<uint32_t>(__builtin_ctzll(value)); }
+
+}  // namespace
+
+LveTlsfAllocator::LveTlsfAllocator(VkDeviceSize capacity) : capacity{capacity} {
+	for (auto &lists : freeLists) {
+		std::fill(std::begin(lists), std::end(lists), NONE);
+	}
+	if (capacity > 0) {
+		insertFree(createBlock(0, capacity));
+	}
+}
+
+void LveTlsfAllocator::mapping(VkDeviceSize size, uint32_t &firstLevel, uint32_t &secondLevel) {
+	if (size < SMALL_SIZE) {
+		firstLevel = 0;
+		secondLevel = static_cast<uint32_t>(size / (SMALL_SIZE / SECOND_LEVEL_COUNT));
+		return;
+	}
+	uint32_t msb = highestBit(size);
+	firstLevel = msb - SMALL_SIZE_BITS + 1;
+	secondLevel = static_cast<uint32_t>(size >> (msb - SECOND_LEVEL_BITS)) - SECOND_LEVEL_COUNT;
+}
+
+bool LveTlsfAllocator::findFreeBlock(VkDeviceSize size, uint32_t &firstLevel, uint32_t &secondLevel) const {
+	// round up to the next class so any block found there is large enough
+	if (size < SMALL_SIZE) {
+		size += SMALL_SIZE / SECOND_LEVEL_COUNT - 1;
+	} else {
+		size += (1ull << (highestBit(size) - SECOND_LEVEL_BITS)) - 1;
+	}
+	mapping(size, firstLevel, secondLevel);
+	if (firstLevel >= FIRST_LEVEL_COUNT) {
+		return false;
+	}
+
+	uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMap == 0) {
+		uint64_t firstLevelMap = firstLevel + 1 < 64 ? firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+		if (firstLevelMap == 0) {
+			return false;
+		}
+		firstLevel = lowestBit(firstLevelMap);
+		secondLevelMap = secondLevelBitmaps[firstLevel];
+	}
+	secondLevel = lowestBit(secondLevelMap);
+	return true;
+}
+
+LveTlsfAllocator::Handle LveTlsfAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+	assert(size > 0 && "Cannot allocate an empty block");
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	uint32_t firstLevel, secondLevel;
+	if (size + alignment - 1 > capacity || !findFreeBlock(size + alignment - 1, firstLevel, secondLevel)) {
+		return INVALID_HANDLE;
+	}
+
+	uint32_t block = freeLists[firstLevel][secondLevel];
+	removeFree(block);
+
+	// alignment padding in front stays free, it can't have a free neighbour in front of it
+	// because free blocks are always merged
+	VkDeviceSize aligned = (blocks[block].offset + alignment - 1) & ~(alignment - 1);
+	if (aligned > blocks[block].offset) {
+		uint32_t rest = split(block, aligned - blocks[block].offset);
+		insertFree(block);
+		block = rest;
+	}
+	if (blocks[block].size > size) {
+		insertFree(split(block, size));
+	}
+
+	blocks[block].free = false;
+	usedSize += size;
+	allocationCount++;
+	offset = blocks[block].offset;
+	return block;
+}
+
+void LveTlsfAllocator::free(Handle handle) {
+	assert(handle < blocks.size() && !blocks[handle].free && "Freeing a block that was never allocated");
+
+	uint32_t block = handle;
+	usedSize -= blocks[block].size;
+	allocationCount--;
+	blocks[block].free = true;
+
+	uint32_t previous = blocks[block].prevPhysical;
+	if (previous != NONE && blocks[previous].free) {
+		removeFree(previous);
+		block = merge(previous, block);
+	}
+	uint32_t next = blocks[block].nextPhysical;
+	if (next != NONE && blocks[next].free) {
+		removeFree(next);
+		block = merge(block, next);
+	}
+	insertFree(block);
+}
+
+VkDeviceSize LveTlsfAllocator::getLargestFreeBlock() const {
+	if (firstLevelBitmap == 0) {
+		return 0;
+	}
+	uint32_t firstLevel = highestBit(firstLevelBitmap);
+	uint32_t secondLevel = highestBit(secondLevelBitmaps[firstLevel]);
+	VkDeviceSize largest = 0;
+	for (uint32_t block = freeLists[firstLevel][secondLevel]; block != NONE; block = blocks[block].nextFree) {
+		largest = std::max(largest, blocks[block].size);
+	}
+	return largest;
+}
+
+uint32_t LveTlsfAllocator::createBlock(VkDeviceSize offset, VkDeviceSize size) {
+	uint32_t block;
+	if (!unusedBlocks.empty()) {
+		block = unusedBlocks.back();
+		unusedBlocks.pop_back();
+		blocks[block] = Block{};
+	} else {
+		block = static_cast<uint32_t>(blocks.size());
+		blocks.emplace_back();
+	}
+	blocks[block].offset = offset;
+	blocks[block].size = size;
+	return block;
+}
+
+void LveTlsfAllocator::destroyBlock(uint32_t block) {
+	unusedBlocks.push_back(block);
+}
+
+void LveTlsfAllocator::insertFree(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	mapping(blocks[block].size, firstLevel, secondLevel);
+
+	uint32_t head = freeLists[firstLevel][secondLevel];
+	blocks[block].free = true;
+	blocks[block].prevFree = NONE;
+	blocks[block].nextFree = head;
+	if (head != NONE) {
+		blocks[head].prevFree = block;
+	}
+	freeLists[firstLevel][secondLevel] = block;
+	firstLevelBitmap |= 1ull << firstLevel;
+	secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	freeBlockCount++;
+}
+
+void LveTlsfAllocator::removeFree(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	mapping(blocks[block].size, firstLevel, secondLevel);
+
+	uint32_t previous = blocks[block].prevFree;
+	uint32_t next = blocks[block].nextFree;
+	if (previous != NONE) {
+		blocks[previous].nextFree = next;
+	} else {
+		freeLists[firstLevel][secondLevel] = next;
+		if (next == NONE) {
+			secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+			if (secondLevelBitmaps[firstLevel] == 0) {
+				firstLevelBitmap &= ~(1ull << firstLevel);
+			}
+		}
+	}
+	if (next != NONE) {
+		blocks[next].prevFree = previous;
+	}
+	blocks[block].free = false;
+	freeBlockCount--;
+}
+
+uint32_t LveTlsfAllocator::split(uint32_t block, VkDeviceSize size) {
+	assert(size < blocks[block].size && "Nothing left to split off");
+	uint32_t rest = createBlock(blocks[block].offset + size, blocks[block].size - size);
+	blocks[block].size = size;
+
+	uint32_t next = blocks[block].nextPhysical;
+	blocks[rest].prevPhysical = block;
+	blocks[rest].nextPhysical = next;
+	blocks[block].nextPhysical = rest;
+	if (next != NONE) {
+		blocks[next].prevPhysical = rest;
+	}
+	return rest;
+}
+
+uint32_t LveTlsfAllocator::merge(uint32_t previous, uint32_t block) {
+	assert(blocks[previous].nextPhysical == block && "Only neighbours can be merged");
+	blocks[previous].size += blocks[block].size;
+
+	uint32_t next = blocks[block].nextPhysical;
+	blocks[previous].nextPhysical = next;
+	if (next != NONE) {
+		blocks[next].prevPhysical = previous;
+	}
+	destroyBlock(block);
+	return previous;
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Two level segregated fit allocator over a fixed range [0, capacity). Free blocks are kept in
+// size class lists (power of two classes, each split in SECOND_LEVEL_COUNT linear steps) with
+// a bitmap per level, so allocate and free are constant time no matter how fragmented the
+// range is. Like LveFreeListAllocator it only hands out offsets, the memory belongs to the
+// caller.
+class LveTlsfAllocator {
+public:
+	// identifies an allocation for free()
+	using Handle = uint32_t;
+	static constexpr Handle INVALID_HANDLE = ~0u;
+
+	explicit LveTlsfAllocator(VkDeviceSize capacity);
+
+	LveTlsfAllocator(const LveTlsfAllocator &) = delete;
+	LveTlsfAllocator &operator=(const LveTlsfAllocator &) = delete;
+
+	// alignment has to be a power of two. Returns INVALID_HANDLE when no free block is large
+	// enough.
+	Handle allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+	void free(Handle handle);
+
+	VkDeviceSize getCapacity() const { return capacity; }
+	VkDeviceSize getUsedSize() const { return usedSize; }
+	uint32_t getAllocationCount() const { return allocationCount; }
+	uint32_t getFreeBlockCount() const { return freeBlockCount; }
+	VkDeviceSize getLargestFreeBlock() const;
+	bool isEmpty() const { return allocationCount == 0; }
+
+private:
+	static constexpr uint32_t SECOND_LEVEL_BITS = 5;
+	static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_BITS;
+	// sizes below this share the first class, in steps of SMALL_SIZE / SECOND_LEVEL_COUNT
+	static constexpr uint32_t SMALL_SIZE_BITS = 8;
+	static constexpr VkDeviceSize SMALL_SIZE = 1ull << SMALL_SIZE_BITS;
+	static constexpr uint32_t FIRST_LEVEL_COUNT = 64 - SMALL_SIZE_BITS + 1;
+	static constexpr uint32_t NONE = ~0u;
+
+	struct Block {
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		uint32_t prevPhysical = NONE;
+		uint32_t nextPhysical = NONE;
+		uint32_t prevFree = NONE;
+		uint32_t nextFree = NONE;
+		bool free = false;
+	};
+
+	static void mapping(VkDeviceSize size, uint32_t &firstLevel, uint32_t &secondLevel);
+	bool findFreeBlock(VkDeviceSize size, uint32_t &firstLevel, uint32_t &secondLevel) const;
+	uint32_t createBlock(VkDeviceSize offset, VkDeviceSize size);
+	void destroyBlock(uint32_t block);
+	void insertFree(uint32_t block);
+	void removeFree(uint32_t block);
+	// shrinks block to size bytes and returns a new block for the rest
+	uint32_t split(uint32_t block, VkDeviceSize size);
+	// merges block into its predecessor, returns the predecessor
+	uint32_t merge(uint32_t previous, uint32_t block);
+
+	VkDeviceSize capacity;
+	VkDeviceSize usedSize = 0;
+	uint32_t allocationCount = 0;
+	uint32_t freeBlockCount = 0;
+
+	std::vector<Block> blocks;
+	std::vector<uint32_t> unusedBlocks;
+	uint64_t firstLevelBitmap = 0;
+	uint32_t secondLevelBitmaps[FIRST_LEVEL_COUNT] = {};
+	uint32_t freeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+};
+
+}
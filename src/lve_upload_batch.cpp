@@ -0,0 +1,361 @@
+#include "lve_upload_batch.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+// keeps staged data aligned for whatever gets written into it
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+// everything uploaded buffers are read by
+constexpr VkPipelineStageFlags CONSUMER_STAGES =
+	VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+constexpr VkAccessFlags CONSUMER_ACCESS =
+	VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+}  // namespace
+
+LveUploadBatch::LveUploadBatch(LveDevice &device, VkDeviceSize stagingSize)
+	: lveDevice{device}, capacity{stagingSize}, ownershipTransfer{device.hasDedicatedTransferQueue()} {
+	stagingBuffer = std::make_unique<LveBuffer>(
+		lveDevice,
+		1,
+		static_cast<uint32_t>(capacity),
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		1,
+		LveMemoryCategory::Staging);
+	stagingBuffer->map();
+}
+
+LveUploadBatch::~LveUploadBatch() {
+	flush();
+}
+
+void *LveUploadBatch::stage(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size) {
+	assert(size > 0 && "Cannot stage an empty upload");
+	retire(false);
+
+	if (size > capacity) {
+		auto dedicated = std::make_unique<LveBuffer>(
+			lveDevice,
+			1,
+			static_cast<uint32_t>(size),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			LveMemoryCategory::Staging);
+		dedicated->map();
+		recordCopy(dedicated->getBuffer(), 0, dstBuffer, dstOffset, size);
+		void *mapped = dedicated->getMappedMemory();
+		pendingDedicatedBuffers.push_back(std::move(dedicated));
+		return mapped;
+	}
+
+	VkDeviceSize offset;
+	while (!reserve(size, offset)) {
+		// the staged copies have to be on their way before their ring space can come back
+		if (hasPendingUploads()) {
+			submit();
+		}
+		retire(true);
+	}
+
+	recordCopy(stagingBuffer->getBuffer(), offset, dstBuffer, dstOffset, size);
+	return static_cast<char *>(stagingBuffer->getMappedMemory()) + offset;
+}
+
+void LveUploadBatch::upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size) {
+	std::memcpy(stage(dstBuffer, dstOffset, size), data, size);
+}
+
+bool LveUploadBatch::reserve(VkDeviceSize size, VkDeviceSize &offset) {
+	VkDeviceSize alignedSize = (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+	if (usedBytes == 0) {
+		head = tail = 0;
+	}
+	if (usedBytes == capacity) {
+		return false;
+	}
+
+	VkDeviceSize consumed;
+	if (head >= tail) {
+		if (head + size <= capacity) {
+			offset = head;
+			consumed = std::min(alignedSize, capacity - head);
+		} else if (size <= tail) {
+			// skip the end of the ring
+			offset = 0;
+			consumed = capacity - head + std::min(alignedSize, tail);
+		} else {
+			return false;
+		}
+	} else if (head + size <= tail) {
+		offset = head;
+		consumed = std::min(alignedSize, tail - head);
+	} else {
+		return false;
+	}
+
+	head = (head + consumed) % capacity;
+	usedBytes += consumed;
+	pendingBytes += consumed;
+	return true;
+}
+
+void LveUploadBatch::recordCopy(
+	VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size) {
+	if (commandBuffer == VK_NULL_HANDLE) {
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = lveDevice.getTransferCommandPool();
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate upload command buffer!");
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	}
+
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = srcOffset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+
+	if (ownershipTransfer) {
+		pendingRanges.push_back({dstBuffer, dstOffset, size});
+	}
+}
+
+LveUploadBatch::Token LveUploadBatch::submit() {
+	retire(false);
+	retireAcquires(false);
+	if (!hasPendingUploads()) {
+		return nextToken - 1;
+	}
+
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;
+	if (ownershipTransfer) {
+		// release the written ranges to the graphics family, the matching acquire runs there
+		std::vector<VkBufferMemoryBarrier> releases(pendingRanges.size());
+		for (size_t i = 0; i < pendingRanges.size(); i++) {
+			VkBufferMemoryBarrier &release = releases[i];
+			release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			release.dstAccessMask = 0;
+			release.srcQueueFamilyIndex = lveDevice.transferQueueFamily();
+			release.dstQueueFamilyIndex = lveDevice.graphicsQueueFamily();
+			release.buffer = pendingRanges[i].buffer;
+			release.offset = pendingRanges[i].offset;
+			release.size = pendingRanges[i].size;
+		}
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0,
+			nullptr,
+			static_cast<uint32_t>(releases.size()),
+			releases.data(),
+			0,
+			nullptr);
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create upload semaphore!");
+		}
+		acquireCommandBuffer = recordAcquire();
+	} else {
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = CONSUMER_ACCESS;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			CONSUMER_STAGES,
+			0,
+			1,
+			&barrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+	}
+	vkEndCommandBuffer(commandBuffer);
+
+	VkFence fence = createFence();
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = semaphore != VK_NULL_HANDLE ? 1 : 0;
+	submitInfo.pSignalSemaphores = &semaphore;
+	if (vkQueueSubmit(lveDevice.transferQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit upload command buffer!");
+	}
+
+	Token token = nextToken++;
+	submissions.push_back({
+		token,
+		fence,
+		commandBuffer,
+		head,
+		pendingBytes,
+		std::move(pendingDedicatedBuffers),
+		semaphore,
+		acquireCommandBuffer});
+	pendingDedicatedBuffers.clear();
+	pendingRanges.clear();
+	commandBuffer = VK_NULL_HANDLE;
+	pendingBytes = 0;
+	submissionCount++;
+	return token;
+}
+
+VkCommandBuffer LveUploadBatch::recordAcquire() {
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = lveDevice.getCommandPool();
+	allocInfo.commandBufferCount = 1;
+	VkCommandBuffer acquireCommandBuffer;
+	if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &acquireCommandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate upload command buffer!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(acquireCommandBuffer, &beginInfo);
+
+	std::vector<VkBufferMemoryBarrier> acquireBarriers(pendingRanges.size());
+	for (size_t i = 0; i < pendingRanges.size(); i++) {
+		VkBufferMemoryBarrier &acquire = acquireBarriers[i];
+		acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		acquire.srcAccessMask = 0;
+		acquire.dstAccessMask = CONSUMER_ACCESS;
+		acquire.srcQueueFamilyIndex = lveDevice.transferQueueFamily();
+		acquire.dstQueueFamilyIndex = lveDevice.graphicsQueueFamily();
+		acquire.buffer = pendingRanges[i].buffer;
+		acquire.offset = pendingRanges[i].offset;
+		acquire.size = pendingRanges[i].size;
+	}
+	vkCmdPipelineBarrier(
+		acquireCommandBuffer,
+		CONSUMER_STAGES,
+		CONSUMER_STAGES,
+		0,
+		0,
+		nullptr,
+		static_cast<uint32_t>(acquireBarriers.size()),
+		acquireBarriers.data(),
+		0,
+		nullptr);
+	vkEndCommandBuffer(acquireCommandBuffer);
+	return acquireCommandBuffer;
+}
+
+VkFence LveUploadBatch::createFence() {
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	VkFence fence;
+	if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create upload fence!");
+	}
+	return fence;
+}
+
+bool LveUploadBatch::isComplete(Token token) {
+	if (token > completedToken) {
+		retire(false);
+	}
+	return token <= completedToken;
+}
+
+void LveUploadBatch::wait(Token token) {
+	if (token >= nextToken) {
+		submit();
+	}
+	while (completedToken < token) {
+		retire(true);
+	}
+}
+
+void LveUploadBatch::flush() {
+	submit();
+	while (!submissions.empty()) {
+		retire(true);
+	}
+	retireAcquires(true);
+}
+
+void LveUploadBatch::retire(bool wait) {
+	while (!submissions.empty()) {
+		Submission &oldest = submissions.front();
+		if (wait) {
+			vkWaitForFences(lveDevice.device(), 1, &oldest.fence, VK_TRUE, UINT64_MAX);
+			waitCount++;
+		} else if (vkGetFenceStatus(lveDevice.device(), oldest.fence) != VK_SUCCESS) {
+			return;
+		}
+
+		if (oldest.acquireCommandBuffer != VK_NULL_HANDLE) {
+			// the copy is done, so the graphics queue only waits for the semaphore on paper
+			VkPipelineStageFlags waitStage = CONSUMER_STAGES;
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &oldest.semaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &oldest.acquireCommandBuffer;
+			VkFence acquireFence = createFence();
+			if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, acquireFence) != VK_SUCCESS) {
+				throw std::runtime_error("failed to submit upload acquire command buffer!");
+			}
+			acquires.push_back({acquireFence, oldest.acquireCommandBuffer, oldest.semaphore});
+		}
+
+		vkDestroyFence(lveDevice.device(), oldest.fence, nullptr);
+		vkFreeCommandBuffers(lveDevice.device(), lveDevice.getTransferCommandPool(), 1, &oldest.commandBuffer);
+		tail = oldest.ringEnd;
+		usedBytes -= oldest.ringBytes;
+		completedToken = oldest.token;
+		submissions.pop_front();
+
+		// waiting for one submission is enough, the rest is picked up as it completes
+		wait = false;
+	}
+}
+
+void LveUploadBatch::retireAcquires(bool wait) {
+	while (!acquires.empty()) {
+		Acquire &oldest = acquires.front();
+		if (wait) {
+			vkWaitForFences(lveDevice.device(), 1, &oldest.fence, VK_TRUE, UINT64_MAX);
+		} else if (vkGetFenceStatus(lveDevice.device(), oldest.fence) != VK_SUCCESS) {
+			return;
+		}
+
+		vkDestroyFence(lveDevice.device(), oldest.fence, nullptr);
+		vkDestroySemaphore(lveDevice.device(), oldest.semaphore, nullptr);
+		vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), 1, &oldest.commandBuffer);
+		acquires.pop_front();
+	}
+}
+
+}
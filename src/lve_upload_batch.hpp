@@ -0,0 +1,116 @@
+#pragma once
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+// Staging ring for buffer uploads. Copies are recorded into one command buffer as they are
+// staged and go to the transfer queue together on submit(), each submission with its own
+// fence; the ring space it used is recycled once that fence signals. Only when the ring is
+// full does staging wait, and then just for the oldest submission.
+//
+// With a dedicated transfer queue family the copied ranges are released to the graphics
+// family at the end of the transfer, and a small acquire submission on the graphics queue is
+// queued once the transfer has finished, so rendering never waits on a copy in progress.
+// Without one the copies run on the graphics queue and end with a barrier instead. Either
+// way, work submitted to the graphics queue after an upload's token completed sees its data.
+//
+// Uploads bigger than the whole ring get a staging buffer of their own.
+//
+// Not thread safe, it records into the device command pools.
+class LveUploadBatch {
+public:
+	static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull << 20;
+
+	// Completion token of a submission, tokens complete in order. Vulkan 1.0 has no timeline
+	// semaphores, so this is a counter backed by one fence per submission.
+	using Token = uint64_t;
+
+	LveUploadBatch(LveDevice &device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+	~LveUploadBatch();
+
+	LveUploadBatch(const LveUploadBatch &) = delete;
+	LveUploadBatch &operator=(const LveUploadBatch &) = delete;
+
+	// Reserves size bytes of staging memory that will be copied to dstBuffer at dstOffset.
+	// The returned pointer can be written until the next submit().
+	void *stage(VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size);
+	void upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size);
+
+	// token the uploads staged so far will complete with
+	Token getPendingToken() const { return nextToken; }
+	// Submits everything staged so far without waiting for it and returns its token. Also
+	// picks up submissions that completed in the meantime.
+	Token submit();
+	bool isComplete(Token token);
+	void wait(Token token);
+	// submits and waits until every upload has completed
+	void flush();
+
+	bool hasPendingUploads() const { return commandBuffer != VK_NULL_HANDLE; }
+	uint32_t getSubmissionCount() const { return submissionCount; }
+	uint32_t getWaitCount() const { return waitCount; }
+
+private:
+	struct Range {
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		VkDeviceSize size;
+	};
+
+	struct Submission {
+		Token token;
+		VkFence fence;
+		VkCommandBuffer commandBuffer;
+		VkDeviceSize ringEnd;
+		VkDeviceSize ringBytes;  // including the space skipped when wrapping
+		std::vector<std::unique_ptr<LveBuffer>> dedicatedBuffers;
+		// queue family ownership transfer only
+		VkSemaphore semaphore;
+		VkCommandBuffer acquireCommandBuffer;
+	};
+
+	struct Acquire {
+		VkFence fence;
+		VkCommandBuffer commandBuffer;
+		VkSemaphore semaphore;
+	};
+
+	bool reserve(VkDeviceSize size, VkDeviceSize &offset);
+	void recordCopy(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size);
+	VkCommandBuffer recordAcquire();
+	VkFence createFence();
+	// retires completed submissions, or waits for the oldest one
+	void retire(bool wait);
+	void retireAcquires(bool wait);
+
+	LveDevice &lveDevice;
+	std::unique_ptr<LveBuffer> stagingBuffer;
+	VkDeviceSize capacity;
+	const bool ownershipTransfer;
+
+	// ring bytes in use are [tail, head), wrapping around
+	VkDeviceSize head = 0;
+	VkDeviceSize tail = 0;
+	VkDeviceSize usedBytes = 0;
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	VkDeviceSize pendingBytes = 0;
+	std::vector<std::unique_ptr<LveBuffer>> pendingDedicatedBuffers;
+	std::vector<Range> pendingRanges;
+	std::deque<Submission> submissions;
+	std::deque<Acquire> acquires;
+
+	Token nextToken = 1;
+	Token completedToken = 0;
+	uint32_t submissionCount = 0;
+	uint32_t waitCount = 0;
+};
+
+}
@@ -0,0 +1,188 @@
+#include "lve_vertex_quantizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace lve {
+
+static_assert(sizeof(LveModel::QuantizedVertex) == 20, "QuantizedVertex must stay tightly packed");
+
+namespace {
+
+inline uint16_t toUnorm16(float value) {
+	return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+}
+
+inline uint8_t toUnorm8(float value) {
+	return static_cast<uint8_t>(std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+// matches the Vulkan SNORM -> float conversion
+inline float fromSnorm16(int16_t value) {
+	return std::max(static_cast<float>(value) / 32767.f, -1.f);
+}
+
+inline float signNotZero(float value) { return value >= 0.f ? 1.f : -1.f; }
+
+glm::vec3 octDecodeFloat(float x, float y) {
+	glm::vec3 n{x, y, 1.f - std::fabs(x) - std::fabs(y)};
+	if (n.z < 0.f) {
+		float nx = (1.f - std::fabs(n.y)) * signNotZero(n.x);
+		float ny = (1.f - std::fabs(n.x)) * signNotZero(n.y);
+		n.x = nx;
+		n.y = ny;
+	}
+	return glm::normalize(n);
+}
+
+}  // namespace
+
+LveVertexQuantizer::LveVertexQuantizer(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+	: origin{boundsMin}, extent{glm::max(boundsMax - boundsMin, glm::vec3{0.f})} {}
+
+LveVertexQuantizer LveVertexQuantizer::fromVertices(const LveModel::Vertex *vertices, uint32_t count) {
+	if (count == 0) {
+		return LveVertexQuantizer{glm::vec3{0.f}, glm::vec3{0.f}};
+	}
+
+	glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+	glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+	for (uint32_t i = 0; i < count; i++) {
+		boundsMin = glm::min(boundsMin, vertices[i].position);
+		boundsMax = glm::max(boundsMax, vertices[i].position);
+	}
+	return LveVertexQuantizer{boundsMin, boundsMax};
+}
+
+LveModel::QuantizedVertex LveVertexQuantizer::encode(const LveModel::Vertex &vertex) const {
+	LveModel::QuantizedVertex result{};
+	for (int i = 0; i < 3; i++) {
+		result.position[i] = extent[i] > 0.f ? toUnorm16((vertex.position[i] - origin[i]) / extent[i]) : 0;
+	}
+	result.position[3] = 0;
+
+	octEncode(vertex.normal, result.normal);
+
+	result.color[0] = toUnorm8(vertex.color.x);
+	result.color[1] = toUnorm8(vertex.color.y);
+	result.color[2] = toUnorm8(vertex.color.z);
+	result.color[3] = 255;
+
+	result.uv[0] = floatToHalf(vertex.uv.x);
+	result.uv[1] = floatToHalf(vertex.uv.y);
+	return result;
+}
+
+LveModel::Vertex LveVertexQuantizer::decode(const LveModel::QuantizedVertex &vertex) const {
+	LveModel::Vertex result{};
+	for (int i = 0; i < 3; i++) {
+		result.position[i] = origin[i] + static_cast<float>(vertex.position[i]) / 65535.f * extent[i];
+		result.color[i] = static_cast<float>(vertex.color[i]) / 255.f;
+	}
+	result.normal = octDecode(vertex.normal);
+	result.uv = {halfToFloat(vertex.uv[0]), halfToFloat(vertex.uv[1])};
+	return result;
+}
+
+glm::mat4 LveVertexQuantizer::positionTransform() const {
+	glm::mat4 transform{1.f};
+	transform[0][0] = extent.x;
+	transform[1][1] = extent.y;
+	transform[2][2] = extent.z;
+	transform[3] = glm::vec4{origin, 1.f};
+	return transform;
+}
+
+void LveVertexQuantizer::octEncode(const glm::vec3 &normal, int16_t out[2]) {
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (length == 0.f) {
+		// meshes without normals keep a zero normal either way, (0, 0) decodes to +z
+		out[0] = out[1] = 0;
+		return;
+	}
+
+	float x = normal.x / length;
+	float y = normal.y / length;
+	if (normal.z < 0.f) {
+		float ox = (1.f - std::fabs(y)) * signNotZero(x);
+		float oy = (1.f - std::fabs(x)) * signNotZero(y);
+		x = ox;
+		y = oy;
+	}
+
+	// rounding each axis on its own is not always the closest direction, try all four neighbours
+	const glm::vec3 n = glm::normalize(normal);
+	const float fx = std::floor(std::clamp(x, -1.f, 1.f) * 32767.f);
+	const float fy = std::floor(std::clamp(y, -1.f, 1.f) * 32767.f);
+	float bestDot = -2.f;
+	for (int i = 0; i < 4; i++) {
+		float cx = std::clamp(fx + (i & 1), -32767.f, 32767.f);
+		float cy = std::clamp(fy + (i >> 1), -32767.f, 32767.f);
+		float d = glm::dot(n, octDecodeFloat(cx / 32767.f, cy / 32767.f));
+		if (d > bestDot) {
+			bestDot = d;
+			out[0] = static_cast<int16_t>(cx);
+			out[1] = static_cast<int16_t>(cy);
+		}
+	}
+}
+
+glm::vec3 LveVertexQuantizer::octDecode(const int16_t in[2]) {
+	return octDecodeFloat(fromSnorm16(in[0]), fromSnorm16(in[1]));
+}
+
+uint16_t LveVertexQuantizer::floatToHalf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t magnitude = bits & 0x7fffffff;
+
+	if (magnitude >= 0x7f800000) {
+		// inf stays inf, nan stays a (quiet) nan
+		return static_cast<uint16_t>(sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00));
+	}
+	if (magnitude >= 0x477ff000) {
+		// 65520 and above round to inf
+		return static_cast<uint16_t>(sign | 0x7c00);
+	}
+	if (magnitude < 0x38800000) {
+		// below the smallest normal half, scaling by 2^24 is exact and rint rounds to even
+		float a;
+		std::memcpy(&a, &magnitude, sizeof(a));
+		return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(a * 16777216.f)));
+	}
+
+	const uint32_t mantissa = magnitude & 0x7fffff;
+	uint32_t half = ((((magnitude >> 23) - 127 + 15) << 10) | (mantissa >> 13));
+	const uint32_t rest = mantissa & 0x1fff;
+	// round to nearest even, a carry into the exponent is still the right encoding
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		half++;
+	}
+	return static_cast<uint16_t>(sign | half);
+}
+
+float LveVertexQuantizer::halfToFloat(uint16_t value) {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1f;
+	const uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		float result = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -result : result;
+	}
+
+	uint32_t bits;
+	if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+}
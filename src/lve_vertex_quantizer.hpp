@@ -0,0 +1,40 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+
+namespace lve {
+
+// Encodes LveModel::Vertex into LveModel::QuantizedVertex and back.
+//
+// Positions are stored as 16 bit unorm relative to the mesh bounds; positionTransform()
+// maps them back to model space and is folded into the model matrix, so the vertex shader
+// only has to decode the octahedral normal. Worst case errors:
+//   position  ~extent / 131070 per axis
+//   normal    ~0.04 degrees
+//   color     1 / 510
+//   uv        |uv| * 2^-11 (half float)
+class LveVertexQuantizer {
+public:
+	LveVertexQuantizer(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+
+	static LveVertexQuantizer fromVertices(const LveModel::Vertex *vertices, uint32_t count);
+
+	LveModel::QuantizedVertex encode(const LveModel::Vertex &vertex) const;
+	LveModel::Vertex decode(const LveModel::QuantizedVertex &vertex) const;
+
+	// unorm position -> model space
+	glm::mat4 positionTransform() const;
+
+	static void octEncode(const glm::vec3 &normal, int16_t out[2]);
+	static glm::vec3 octDecode(const int16_t in[2]);
+	static uint16_t floatToHalf(float value);
+	static float halfToFloat(uint16_t value);
+
+private:
+	glm::vec3 origin;
+	glm::vec3 extent;
+};
+
+}
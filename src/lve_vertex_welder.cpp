@@ -0,0 +1,173 @@
+#include "lve_vertex_welder.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace lve {
+
+namespace {
+
+// +0.0f and -0.0f compare equal, so they must hash the same as well
+inline uint32_t floatBits(float value) {
+	value += 0.0f;
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+inline uint64_t mix(uint64_t hash, uint32_t word) {
+	hash ^= word * 0x9e3779b97f4a7c15ull;
+	hash = (hash << 27) | (hash >> 37);
+	return hash * 0xbf58476d1ce4e5b9ull;
+}
+
+inline uint64_t finalize(uint64_t hash) {
+	hash ^= hash >> 31;
+	hash *= 0x94d049bb133111ebull;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+// hash of everything except the position
+inline uint64_t hashAttributes(const LveModel::Vertex &vertex, uint64_t hash) {
+	hash = mix(hash, floatBits(vertex.color.x));
+	hash = mix(hash, floatBits(vertex.color.y));
+	hash = mix(hash, floatBits(vertex.color.z));
+	hash = mix(hash, floatBits(vertex.normal.x));
+	hash = mix(hash, floatBits(vertex.normal.y));
+	hash = mix(hash, floatBits(vertex.normal.z));
+	hash = mix(hash, floatBits(vertex.uv.x));
+	hash = mix(hash, floatBits(vertex.uv.y));
+	return hash;
+}
+
+inline uint64_t hashVertex(const LveModel::Vertex &vertex) {
+	uint64_t hash = 0;
+	hash = mix(hash, floatBits(vertex.position.x));
+	hash = mix(hash, floatBits(vertex.position.y));
+	hash = mix(hash, floatBits(vertex.position.z));
+	return finalize(hashAttributes(vertex, hash));
+}
+
+inline bool sameAttributes(const LveModel::Vertex &a, const LveModel::Vertex &b) {
+	return a.color == b.color && a.normal == b.normal && a.uv == b.uv;
+}
+
+inline size_t tableSize(size_t count) {
+	// keeps the load factor at or below 0.8 when every index is a unique vertex
+	size_t size = 16;
+	while (size < count + count / 4) size *= 2;
+	return size;
+}
+
+}  // namespace
+
+LveVertexWelder::LveVertexWelder(std::vector<LveModel::Vertex> &vertices, size_t indexCount, float positionEpsilon)
+	: vertices{vertices}, epsilon{positionEpsilon} {
+	// cells twice as wide as epsilon mean a lookup never spans more than 2 cells per axis
+	inverseCellSize = epsilon > 0.f ? 1.f / (2.f * epsilon) : 0.f;
+	rehash(tableSize(indexCount + vertices.size()));
+}
+
+uint32_t LveVertexWelder::weld(const LveModel::Vertex &vertex) {
+	return epsilon > 0.f ? weldNearby(vertex) : weldExact(vertex);
+}
+
+uint32_t LveVertexWelder::weldExact(const LveModel::Vertex &vertex) {
+	uint64_t hash = hashVertex(vertex);
+	for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+		uint32_t index = slots[i];
+		if (index == EMPTY) {
+			return insert(vertex, hash);
+		}
+		if (vertices[index] == vertex) {
+			return index;
+		}
+	}
+}
+
+uint32_t LveVertexWelder::weldNearby(const LveModel::Vertex &vertex) {
+	const glm::vec3 &p = vertex.position;
+	const int32_t minX = static_cast<int32_t>(std::floor((p.x - epsilon) * inverseCellSize));
+	const int32_t minY = static_cast<int32_t>(std::floor((p.y - epsilon) * inverseCellSize));
+	const int32_t minZ = static_cast<int32_t>(std::floor((p.z - epsilon) * inverseCellSize));
+	const int32_t maxX = static_cast<int32_t>(std::floor((p.x + epsilon) * inverseCellSize));
+	const int32_t maxY = static_cast<int32_t>(std::floor((p.y + epsilon) * inverseCellSize));
+	const int32_t maxZ = static_cast<int32_t>(std::floor((p.z + epsilon) * inverseCellSize));
+
+	uint32_t best = EMPTY;
+	for (int32_t x = minX; x <= maxX; x++) {
+		for (int32_t y = minY; y <= maxY; y++) {
+			for (int32_t z = minZ; z <= maxZ; z++) {
+				for (uint64_t i = cellHash(vertex, x, y, z) & mask; slots[i] != EMPTY; i = (i + 1) & mask) {
+					uint32_t index = slots[i];
+					const LveModel::Vertex &other = vertices[index];
+					// lowest index wins so the result does not depend on probe order
+					if (index < best && sameAttributes(vertex, other) &&
+						std::fabs(other.position.x - p.x) <= epsilon &&
+						std::fabs(other.position.y - p.y) <= epsilon &&
+						std::fabs(other.position.z - p.z) <= epsilon) {
+						best = index;
+					}
+				}
+			}
+		}
+	}
+	if (best != EMPTY) {
+		return best;
+	}
+
+	return insert(
+		vertex,
+		cellHash(
+			vertex,
+			static_cast<int32_t>(std::floor(p.x * inverseCellSize)),
+			static_cast<int32_t>(std::floor(p.y * inverseCellSize)),
+			static_cast<int32_t>(std::floor(p.z * inverseCellSize))));
+}
+
+uint64_t LveVertexWelder::cellHash(const LveModel::Vertex &vertex, int32_t x, int32_t y, int32_t z) const {
+	uint64_t hash = 0;
+	hash = mix(hash, static_cast<uint32_t>(x));
+	hash = mix(hash, static_cast<uint32_t>(y));
+	hash = mix(hash, static_cast<uint32_t>(z));
+	return finalize(hashAttributes(vertex, hash));
+}
+
+uint32_t LveVertexWelder::insert(const LveModel::Vertex &vertex, uint64_t hash) {
+	uint32_t index = static_cast<uint32_t>(vertices.size());
+	vertices.push_back(vertex);
+
+	if (vertices.size() + vertices.size() / 4 > slots.size()) {
+		// the table was sized for fewer vertices than we got, rehash including the new one
+		rehash(slots.size() * 2);
+		return index;
+	}
+
+	uint64_t i = hash & mask;
+	while (slots[i] != EMPTY) i = (i + 1) & mask;
+	slots[i] = index;
+	return index;
+}
+
+void LveVertexWelder::rehash(size_t size) {
+	slots.assign(size, EMPTY);
+	mask = slots.size() - 1;
+
+	for (uint32_t index = 0; index < vertices.size(); index++) {
+		const LveModel::Vertex &vertex = vertices[index];
+		uint64_t hash = epsilon > 0.f
+			? cellHash(
+				vertex,
+				static_cast<int32_t>(std::floor(vertex.position.x * inverseCellSize)),
+				static_cast<int32_t>(std::floor(vertex.position.y * inverseCellSize)),
+				static_cast<int32_t>(std::floor(vertex.position.z * inverseCellSize)))
+			: hashVertex(vertex);
+
+		uint64_t i = hash & mask;
+		while (slots[i] != EMPTY) i = (i + 1) & mask;
+		slots[i] = index;
+	}
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Flat open addressing table used to deduplicate vertices while building index buffers.
+// Each call to weld() is a single hash + probe that either finds an identical vertex
+// already in `vertices` or appends the new one.
+//
+// Vertices already in `vertices` when the welder is created take part in the lookup.
+// With a positive positionEpsilon, vertices whose positions differ by at most epsilon per
+// axis (and whose other attributes match exactly) are welded onto the first one seen.
+class LveVertexWelder {
+public:
+	LveVertexWelder(std::vector<LveModel::Vertex> &vertices, size_t indexCount, float positionEpsilon = 0.f);
+
+	LveVertexWelder(const LveVertexWelder &) = delete;
+	LveVertexWelder &operator=(const LveVertexWelder &) = delete;
+
+	uint32_t weld(const LveModel::Vertex &vertex);
+
+private:
+	static constexpr uint32_t EMPTY = ~0u;
+
+	uint32_t weldExact(const LveModel::Vertex &vertex);
+	uint32_t weldNearby(const LveModel::Vertex &vertex);
+	uint32_t insert(const LveModel::Vertex &vertex, uint64_t hash);
+	uint64_t cellHash(const LveModel::Vertex &vertex, int32_t x, int32_t y, int32_t z) const;
+	void rehash(size_t size);
+
+	std::vector<LveModel::Vertex> &vertices;
+	std::vector<uint32_t> slots;
+	uint64_t mask;
+	float epsilon;
+	float inverseCellSize;
+};
+
+}
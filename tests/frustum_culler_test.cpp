@@ -0,0 +1,175 @@
+#include "lve_camera.hpp"
+#include "lve_frustum_culler.hpp"
+#include "lve_test.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+using lve::LveFrustum;
+using lve::LveFrustumCuller;
+
+constexpr LveFrustumCuller::Path PATHS[] = {
+	LveFrustumCuller::Path::Scalar,
+	LveFrustumCuller::Path::Sse,
+	LveFrustumCuller::Path::Avx,
+};
+
+const char *pathName(LveFrustumCuller::Path path) {
+	switch (path) {
+		case LveFrustumCuller::Path::Scalar: return "scalar";
+		case LveFrustumCuller::Path::Sse: return "sse";
+		case LveFrustumCuller::Path::Avx: return "avx";
+	}
+	return "unknown";
+}
+
+struct Sphere {
+	glm::vec3 center;
+	float radius;
+};
+
+// within float rounding of touching a plane, where a different summation order may disagree
+bool touchesPlane(const LveFrustum &frustum, const Sphere &sphere) {
+	for (const auto &plane : frustum.planes) {
+		float distance = glm::dot(glm::vec3(plane), sphere.center) + plane.w;
+		float scale = std::fabs(plane.w) + glm::length(sphere.center) + sphere.radius + 1.f;
+		if (std::fabs(distance + sphere.radius) <= scale * 1e-6f) return true;
+	}
+	return false;
+}
+
+// every available path returns exactly the spheres intersectsSphere accepts, in order
+void checkPaths(const LveFrustum &frustum, const std::vector<Sphere> &spheres) {
+	LveFrustumCuller culler{};
+	culler.reserve(spheres.size());
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < spheres.size(); i++) {
+		LVE_CHECK(culler.addSphere(spheres[i].center, spheres[i].radius) == i);
+		if (frustum.intersectsSphere(spheres[i].center, spheres[i].radius)) expected.push_back(i);
+	}
+	LVE_CHECK(culler.size() == spheres.size());
+
+	for (auto path : PATHS) {
+		if (!LveFrustumCuller::isAvailable(path)) continue;
+		std::vector<uint32_t> visible{};
+		culler.cull(frustum, visible, path);
+
+		// walk both sorted lists, differences have to sit right on a plane
+		size_t a = 0, b = 0;
+		bool ordered = true;
+		for (size_t k = 1; k < visible.size(); k++) ordered &= visible[k - 1] < visible[k];
+		LVE_CHECK(ordered);
+		while (a < expected.size() || b < visible.size()) {
+			if (a < expected.size() && b < visible.size() && expected[a] == visible[b]) {
+				a++;
+				b++;
+				continue;
+			}
+			uint32_t index = b >= visible.size() || (a < expected.size() && expected[a] < visible[b]) ? expected[a++] : visible[b++];
+			if (!touchesPlane(frustum, spheres[index])) {
+				std::printf("%s path disagrees on sphere %u of %zu\n", pathName(path), index, spheres.size());
+			}
+			LVE_CHECK(touchesPlane(frustum, spheres[index]));
+		}
+	}
+}
+
+LveFrustum cameraFrustum() {
+	lve::LveCamera camera{};
+	camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, 0.1f, 100.f);
+	camera.setViewDirection({1.f, -2.f, -5.f}, {0.2f, 0.1f, 1.f});
+	return camera.getFrustum();
+}
+
+std::vector<Sphere> randomSpheres(std::mt19937 &rng, size_t count) {
+	std::uniform_real_distribution<float> coordinate{-60.f, 60.f};
+	std::uniform_real_distribution<float> radius{0.f, 4.f};
+	std::vector<Sphere> spheres(count);
+	for (auto &sphere : spheres) {
+		// sequenced, argument evaluation order is unspecified
+		sphere.center.x = coordinate(rng);
+		sphere.center.y = coordinate(rng);
+		sphere.center.z = coordinate(rng) + 50.f;
+		sphere.radius = radius(rng);
+	}
+	return spheres;
+}
+
+void testRandom() {
+	std::mt19937 rng{7};
+	const LveFrustum frustum = cameraFrustum();
+	// tails of every length for both the 4 and 8 wide loops
+	for (size_t count = 0; count <= 33; count++) {
+		checkPaths(frustum, randomSpheres(rng, count));
+	}
+	for (size_t count : {1003u, 4097u, 100001u}) {
+		checkPaths(frustum, randomSpheres(rng, count));
+	}
+}
+
+void testTouching() {
+	// an axis aligned box, everything is exact so touching spheres have to be visible
+	LveFrustum frustum{};
+	frustum.planes[LveFrustum::Left] = {1.f, 0.f, 0.f, 10.f};
+	frustum.planes[LveFrustum::Right] = {-1.f, 0.f, 0.f, 10.f};
+	frustum.planes[LveFrustum::Bottom] = {0.f, 1.f, 0.f, 10.f};
+	frustum.planes[LveFrustum::Top] = {0.f, -1.f, 0.f, 10.f};
+	frustum.planes[LveFrustum::Near] = {0.f, 0.f, 1.f, 0.f};
+	frustum.planes[LveFrustum::Far] = {0.f, 0.f, -1.f, 20.f};
+
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	std::vector<Sphere> spheres = {
+		{{-12.f, 0.f, 5.f}, 2.f},     // touches left
+		{{-12.f, 0.f, 5.f}, 1.5f},    // outside left
+		{{0.f, 13.f, 5.f}, 3.f},      // touches top
+		{{0.f, 13.f, 5.f}, 2.75f},    // outside top
+		{{0.f, 0.f, -1.f}, 1.f},      // touches near
+		{{0.f, 0.f, 21.5f}, 1.f},     // outside far
+		{{0.f, 0.f, 10.f}, 0.f},      // point inside
+		{{10.f, 10.f, 20.f}, 0.f},    // corner point
+		{{nan, 0.f, 5.f}, 1.f},       // NaN is visible, like the scalar test
+		{{0.f, 0.f, 5.f}, nan},
+		{{100.f, 100.f, 100.f}, 200.f},
+	};
+	const bool visible[] = {true, false, true, false, true, false, true, true, true, true, true};
+
+	// every sphere in every lane position, and in the scalar tail
+	for (size_t shift = 0; shift < 8; shift++) {
+		std::vector<Sphere> shifted(shift, Sphere{{0.f, 0.f, 5.f}, 1.f});
+		shifted.insert(shifted.end(), spheres.begin(), spheres.end());
+		LveFrustumCuller culler{};
+		for (auto &sphere : shifted) culler.addSphere(sphere.center, sphere.radius);
+
+		for (auto path : PATHS) {
+			if (!LveFrustumCuller::isAvailable(path)) continue;
+			std::vector<uint8_t> flags(shifted.size(), 0);
+			std::vector<uint32_t> result{};
+			culler.cull(frustum, result, path);
+			for (uint32_t index : result) flags[index] = 1;
+			for (size_t i = 0; i < spheres.size(); i++) {
+				if (flags[shift + i] != visible[i]) {
+					std::printf("%s path: sphere %zu at lane %zu should be %s\n", pathName(path), i, shift + i, visible[i] ? "visible" : "culled");
+				}
+				LVE_CHECK(flags[shift + i] == visible[i]);
+			}
+		}
+	}
+}
+
+}
+
+int main() {
+	for (auto path : PATHS) {
+		std::printf("%s path %s\n", pathName(path), LveFrustumCuller::isAvailable(path) ? "tested" : "not available");
+	}
+	LVE_CHECK(LveFrustumCuller::isAvailable(LveFrustumCuller::getBestPath()));
+	testRandom();
+	testTouching();
+	return lve::test::failures();
+}
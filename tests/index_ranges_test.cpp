@@ -0,0 +1,138 @@
+#include "lve_index_ranges.hpp"
+#include "lve_test.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using lve::LveModel;
+
+// ranges are non-empty, cover the buffer in order and every index fits 16 bits
+bool validRanges(const std::vector<LveModel::IndexRange> &ranges, const std::vector<uint32_t> &indices) {
+	uint32_t next = 0;
+	for (auto &range : ranges) {
+		if (range.indexCount == 0 || range.firstIndex != next || range.vertexOffset < 0) return false;
+		for (uint32_t i = range.firstIndex; i < range.firstIndex + range.indexCount; i++) {
+			if (indices[i] < static_cast<uint32_t>(range.vertexOffset)) return false;
+			if (indices[i] - static_cast<uint32_t>(range.vertexOffset) > 65535) return false;
+		}
+		next = range.firstIndex + range.indexCount;
+	}
+	return next == indices.size();
+}
+
+// triangles along a strip of vertices, each only referencing its neighbours
+void appendStrip(std::vector<uint32_t> &indices, uint32_t firstVertex, uint32_t vertexCount) {
+	for (uint32_t v = firstVertex; v + 2 < firstVertex + vertexCount; v++) {
+		indices.insert(indices.end(), {v, v + 1, v + 2});
+	}
+}
+
+size_t rangesIn(const std::vector<LveModel::IndexRange> &ranges, const LveModel::Lod &lod) {
+	size_t count = 0;
+	for (auto &range : ranges) {
+		bool inside = range.firstIndex >= lod.firstIndex && range.firstIndex + range.indexCount <= lod.firstIndex + lod.indexCount;
+		bool outside = range.firstIndex + range.indexCount <= lod.firstIndex || range.firstIndex >= lod.firstIndex + lod.indexCount;
+		LVE_CHECK(inside || outside);
+		if (inside) count++;
+	}
+	return count;
+}
+
+void testSmallMesh() {
+	std::vector<uint32_t> indices;
+	appendStrip(indices, 0, 65536);
+	auto ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), 65536, nullptr, 0);
+	LVE_CHECK(ranges.size() == 1);
+	LVE_CHECK(validRanges(ranges, indices));
+}
+
+void testSplit() {
+	std::vector<uint32_t> indices;
+	appendStrip(indices, 0, 200000);
+	auto ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), 200000, nullptr, 0);
+	LVE_CHECK(ranges.size() == 4);
+	LVE_CHECK(validRanges(ranges, indices));
+}
+
+void testWideTriangle() {
+	// the very first triangle spans more than 16 bits, this used to emit {0, 0, -1}
+	std::vector<uint32_t> indices{0, 1, 70000};
+	appendStrip(indices, 0, 100000);
+	auto ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), 100000, nullptr, 0);
+	LVE_CHECK(ranges.empty());
+
+	// and in the middle of the buffer
+	indices.clear();
+	appendStrip(indices, 0, 100000);
+	indices.insert(indices.end(), {99999, 5, 6});
+	appendStrip(indices, 0, 1000);
+	ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), 100000, nullptr, 0);
+	LVE_CHECK(ranges.empty());
+
+	// exactly 65535 apart still fits
+	indices = {0, 1, 65535, 65535, 65536, 100000};
+	ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), 100001, nullptr, 0);
+	LVE_CHECK(ranges.size() == 2);
+	LVE_CHECK(validRanges(ranges, indices));
+}
+
+void testLods() {
+	// every LOD walks the whole vertex buffer again, splitting the combined buffer would need
+	// more than MAX_16BIT_INDEX_RANGES ranges while every LOD needs only a few
+	constexpr uint32_t vertexCount = 300000;
+	std::vector<uint32_t> indices;
+	std::vector<LveModel::Lod> lods;
+	for (uint32_t lod = 0; lod < 4; lod++) {
+		uint32_t first = static_cast<uint32_t>(indices.size());
+		uint32_t step = 1u << lod;
+		for (uint32_t v = 0; v + 2 * step < vertexCount; v += step) {
+			indices.insert(indices.end(), {v, v + step, v + 2 * step});
+		}
+		lods.push_back({first, static_cast<uint32_t>(indices.size()) - first, 0.f});
+	}
+
+	auto ranges = lve::split16BitIndexRanges(
+		indices.data(),
+		static_cast<uint32_t>(indices.size()),
+		vertexCount,
+		lods.data(),
+		static_cast<uint32_t>(lods.size()));
+	LVE_CHECK(!ranges.empty());
+	LVE_CHECK(ranges.size() > lve::MAX_16BIT_INDEX_RANGES);
+	LVE_CHECK(validRanges(ranges, indices));
+	for (auto &lod : lods) {
+		size_t count = rangesIn(ranges, lod);
+		LVE_CHECK(count > 0 && count <= lve::MAX_16BIT_INDEX_RANGES);
+	}
+}
+
+void testFallback() {
+	// a single LOD needing more than MAX_16BIT_INDEX_RANGES ranges stays 32 bit
+	constexpr uint32_t vertexCount = 65536 * (lve::MAX_16BIT_INDEX_RANGES + 1);
+	std::vector<uint32_t> indices;
+	appendStrip(indices, 0, vertexCount);
+	LveModel::Lod lod{0, static_cast<uint32_t>(indices.size()), 0.f};
+	auto ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), vertexCount, &lod, 1);
+	LVE_CHECK(ranges.empty());
+
+	// one range short of the limit still splits
+	indices.clear();
+	appendStrip(indices, 0, 65536 * lve::MAX_16BIT_INDEX_RANGES - 1000);
+	lod = {0, static_cast<uint32_t>(indices.size()), 0.f};
+	ranges = lve::split16BitIndexRanges(indices.data(), static_cast<uint32_t>(indices.size()), vertexCount, &lod, 1);
+	LVE_CHECK(ranges.size() == lve::MAX_16BIT_INDEX_RANGES);
+	LVE_CHECK(validRanges(ranges, indices));
+}
+
+}
+
+int main() {
+	testSmallMesh();
+	testSplit();
+	testWideTriangle();
+	testLods();
+	testFallback();
+	return lve::test::failures();
+}
@@ -0,0 +1,100 @@
+#include "lve_lock_free_queue.hpp"
+#include "lve_test.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using lve::LveLockFreeQueue;
+
+void testSingleThreaded() {
+	LveLockFreeQueue<int> queue{8};
+	int value = 0;
+	LVE_CHECK(!queue.tryPop(value));
+
+	// fills up, keeps FIFO order, wraps around
+	for (int round = 0; round < 3; round++) {
+		for (int i = 0; i < 8; i++) {
+			int pushed = round * 8 + i;
+			LVE_CHECK(queue.tryPush(pushed));
+		}
+		int extra = -1;
+		LVE_CHECK(!queue.tryPush(extra));
+		LVE_CHECK(extra == -1);
+		for (int i = 0; i < 8; i++) {
+			LVE_CHECK(queue.tryPop(value) && value == round * 8 + i);
+		}
+		LVE_CHECK(!queue.tryPop(value));
+	}
+}
+
+void testOwnership() {
+	// values are moved in and out, and the destructor frees what was never popped
+	LveLockFreeQueue<std::unique_ptr<int>> queue{4};
+	for (int i = 0; i < 3; i++) {
+		auto value = std::make_unique<int>(i);
+		LVE_CHECK(queue.tryPush(value));
+		LVE_CHECK(value == nullptr);
+	}
+	std::unique_ptr<int> popped;
+	LVE_CHECK(queue.tryPop(popped) && popped && *popped == 0);
+}
+
+// Producers push disjoint ranges while consumers pop, every value has to arrive exactly once.
+// Run it under -fsanitize=thread to check the memory ordering too.
+void testConcurrent(unsigned producers, unsigned consumers, uint32_t perProducer, size_t capacity) {
+	LveLockFreeQueue<uint32_t> queue{capacity};
+	const uint32_t total = producers * perProducer;
+	std::vector<std::atomic<uint8_t>> seen(total);
+	std::atomic<uint32_t> popped{0};
+	std::atomic<uint32_t> duplicates{0};
+
+	std::vector<std::thread> threads;
+	for (unsigned p = 0; p < producers; p++) {
+		threads.emplace_back([&, p] {
+			for (uint32_t i = 0; i < perProducer; i++) {
+				uint32_t value = p * perProducer + i;
+				while (!queue.tryPush(value)) std::this_thread::yield();
+			}
+		});
+	}
+	for (unsigned c = 0; c < consumers; c++) {
+		threads.emplace_back([&] {
+			uint32_t value;
+			while (popped.load(std::memory_order_relaxed) < total) {
+				if (!queue.tryPop(value)) {
+					std::this_thread::yield();
+					continue;
+				}
+				if (value >= total || seen[value].fetch_add(1, std::memory_order_relaxed) != 0) duplicates++;
+				popped++;
+			}
+		});
+	}
+	for (auto &thread : threads) thread.join();
+
+	LVE_CHECK(popped == total);
+	LVE_CHECK(duplicates == 0);
+	uint32_t missing = 0;
+	for (auto &flag : seen) {
+		if (flag.load() != 1) missing++;
+	}
+	LVE_CHECK(missing == 0);
+	uint32_t value;
+	LVE_CHECK(!queue.tryPop(value));
+}
+
+}
+
+int main() {
+	testSingleThreaded();
+	testOwnership();
+	testConcurrent(1, 1, 200000, 64);
+	testConcurrent(7, 1, 200000, 256);
+	testConcurrent(4, 4, 200000, 2);
+	return lve::test::failures();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal check helpers for the CPU side tests. A failed check is reported and counted,
+// main returns lve::test::failures() so make test stops on the first failing binary.
+namespace lve {
+namespace test {
+
+inline int &failureCount() {
+	static int count = 0;
+	return count;
+}
+
+inline int failures() {
+	if (failureCount() > 0) {
+		std::printf("%d check(s) failed\n", failureCount());
+	}
+	return failureCount();
+}
+
+}
+}
+
+#define LVE_CHECK(condition)                                                    \
+	do {                                                                        \
+		if (!(condition)) {                                                     \
+			std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			lve::test::failureCount()++;                                        \
+		}                                                                       \
+	} while (0)
@@ -0,0 +1,212 @@
+#include "lve_memory_allocator.hpp"
+#include "lve_test.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+// LveMemoryAllocator only talks to the driver through these, the test links its own fake
+// device instead: two heaps, a device local type and a coherent and a non-coherent host
+// visible one.
+namespace {
+
+constexpr VkDeviceSize DEVICE_HEAP_SIZE = 8ull << 30;
+constexpr VkDeviceSize HOST_HEAP_SIZE = 256ull << 20;
+constexpr VkDeviceSize ATOM_SIZE = 64;
+
+enum MemoryType : uint32_t { DeviceLocal, HostCoherent, HostCached, MEMORY_TYPE_COUNT };
+
+struct DriverAllocation {
+	VkDeviceSize size;
+	uint32_t heapIndex;
+	void *mapped;
+};
+
+struct FakeDriver {
+	std::map<uintptr_t, DriverAllocation> allocations;
+	uintptr_t nextHandle = 1;
+	VkDeviceSize heapBytes[2] = {};
+	uint32_t mapCount = 0;
+} driver;
+
+uint32_t heapOf(uint32_t memoryTypeIndex) { return memoryTypeIndex == DeviceLocal ? 0 : 1; }
+
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties *properties) {
+	*properties = VkPhysicalDeviceMemoryProperties{};
+	properties->memoryHeapCount = 2;
+	properties->memoryHeaps[0].size = DEVICE_HEAP_SIZE;
+	properties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	properties->memoryHeaps[1].size = HOST_HEAP_SIZE;
+	properties->memoryTypeCount = MEMORY_TYPE_COUNT;
+	properties->memoryTypes[DeviceLocal] = {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0};
+	properties->memoryTypes[HostCoherent] = {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1};
+	properties->memoryTypes[HostCached] = {VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1};
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties *properties) {
+	*properties = VkPhysicalDeviceProperties{};
+	properties->limits.nonCoherentAtomSize = ATOM_SIZE;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(
+		VkDevice, const VkMemoryAllocateInfo *info, const VkAllocationCallbacks *, VkDeviceMemory *memory) {
+	uintptr_t handle = driver.nextHandle++;
+	uint32_t heapIndex = heapOf(info->memoryTypeIndex);
+	driver.allocations[handle] = {info->allocationSize, heapIndex, nullptr};
+	driver.heapBytes[heapIndex] += info->allocationSize;
+	*memory = (VkDeviceMemory)handle;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks *) {
+	auto it = driver.allocations.find((uintptr_t)memory);
+	LVE_CHECK(it != driver.allocations.end());
+	if (it == driver.allocations.end()) return;
+	LVE_CHECK(it->second.mapped == nullptr);
+	driver.heapBytes[it->second.heapIndex] -= it->second.size;
+	driver.allocations.erase(it);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(
+		VkDevice, VkDeviceMemory memory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void **data) {
+	DriverAllocation &allocation = driver.allocations.at((uintptr_t)memory);
+	LVE_CHECK(allocation.mapped == nullptr);
+	// never written, the pages stay untouched
+	allocation.mapped = std::malloc(allocation.size);
+	driver.mapCount++;
+	*data = allocation.mapped;
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(VkDevice, VkDeviceMemory memory) {
+	DriverAllocation &allocation = driver.allocations.at((uintptr_t)memory);
+	std::free(allocation.mapped);
+	allocation.mapped = nullptr;
+	driver.mapCount--;
+}
+
+namespace {
+
+using lve::LveMemoryAllocation;
+using lve::LveMemoryAllocator;
+using lve::LveMemoryCategory;
+
+constexpr uint32_t CATEGORY_COUNT = lve::LVE_MEMORY_CATEGORY_COUNT;
+
+// Random allocations and frees across the memory types, kinds and categories. After every
+// step the per-heap, per-category counters match the live allocations and the allocated
+// bytes match what the fake driver holds; everything returns to zero at the end.
+void testCounters(uint32_t seed) {
+	{
+		LveMemoryAllocator allocator{VK_NULL_HANDLE, VK_NULL_HANDLE, 16ull << 20};
+		std::mt19937 rng{seed};
+		std::uniform_int_distribution<int> action{0, 99};
+		std::uniform_int_distribution<uint32_t> memoryType{0, MEMORY_TYPE_COUNT - 1};
+		std::uniform_int_distribution<uint32_t> category{0, CATEGORY_COUNT - 1};
+		std::uniform_int_distribution<int> kind{0, 1};
+		std::uniform_int_distribution<int> sizeKind{0, 99};
+		std::uniform_int_distribution<int> alignmentBits{0, 12};
+
+		std::vector<LveMemoryAllocation> live;
+		VkDeviceSize expectedUsed[2][CATEGORY_COUNT] = {};
+		bool countersMatch = true;
+		bool roundedToAtoms = true;
+		for (int step = 0; step < 20000; step++) {
+			int allocateChance = (step / 2000) % 2 == 0 ? 65 : 35;
+			if (live.empty() || action(rng) < allocateChance) {
+				VkMemoryRequirements requirements{};
+				int k = sizeKind(rng);
+				// mostly sub-allocated, a few dedicated ones past half a block
+				requirements.size = k < 95
+					? std::uniform_int_distribution<VkDeviceSize>{1, 512 << 10}(rng)
+					: std::uniform_int_distribution<VkDeviceSize>{8ull << 20, 24ull << 20}(rng);
+				requirements.alignment = VkDeviceSize{1} << alignmentBits(rng);
+				uint32_t type = memoryType(rng);
+				LveMemoryAllocation allocation = allocator.allocate(
+					requirements,
+					type,
+					kind(rng) == 0 ? LveMemoryAllocator::ResourceKind::Buffer : LveMemoryAllocator::ResourceKind::Image,
+					static_cast<LveMemoryCategory>(category(rng)));
+				LVE_CHECK(allocation.memory != VK_NULL_HANDLE && allocation.size >= requirements.size);
+				if (type == HostCached && (allocation.size % ATOM_SIZE != 0 || allocation.offset % ATOM_SIZE != 0)) {
+					roundedToAtoms = false;
+				}
+				LVE_CHECK((type != DeviceLocal) == (allocation.mapped != nullptr));
+				expectedUsed[heapOf(type)][static_cast<uint32_t>(allocation.category)] += allocation.size;
+				live.push_back(allocation);
+			} else {
+				size_t index = std::uniform_int_distribution<size_t>{0, live.size() - 1}(rng);
+				LveMemoryAllocation &allocation = live[index];
+				expectedUsed[heapOf(allocation.memoryTypeIndex)][static_cast<uint32_t>(allocation.category)] -= allocation.size;
+				allocator.free(allocation);
+				LVE_CHECK(allocation.memory == VK_NULL_HANDLE);
+				live[index] = live.back();
+				live.pop_back();
+			}
+
+			for (uint32_t heap = 0; heap < 2; heap++) {
+				if (allocator.getHeapAllocatedSize(heap) != driver.heapBytes[heap]) countersMatch = false;
+				for (uint32_t c = 0; c < CATEGORY_COUNT; c++) {
+					if (allocator.getHeapUsedSize(heap, static_cast<LveMemoryCategory>(c)) != expectedUsed[heap][c]) {
+						countersMatch = false;
+					}
+				}
+			}
+		}
+		LVE_CHECK(countersMatch);
+		LVE_CHECK(roundedToAtoms);
+
+		LveMemoryAllocator::Stats stats = allocator.getStats();
+		LVE_CHECK(stats.allocationCount == live.size());
+		LVE_CHECK(stats.bytesAllocated == driver.heapBytes[0] + driver.heapBytes[1]);
+
+		for (auto &allocation : live) allocator.free(allocation);
+		for (uint32_t heap = 0; heap < 2; heap++) {
+			for (uint32_t c = 0; c < CATEGORY_COUNT; c++) {
+				LVE_CHECK(allocator.getHeapUsedSize(heap, static_cast<LveMemoryCategory>(c)) == 0);
+			}
+			LVE_CHECK(allocator.getHeapAllocatedSize(heap) == driver.heapBytes[heap]);
+		}
+
+		// at most one empty block per memory type and kind stays around, no dedicated memory
+		stats = allocator.getStats();
+		LVE_CHECK(stats.allocationCount == 0 && stats.bytesUsed == 0 && stats.dedicatedAllocationCount == 0);
+		LVE_CHECK(stats.blockCount <= MEMORY_TYPE_COUNT * 2);
+	}
+	// the destructor gives the rest back
+	LVE_CHECK(driver.allocations.empty());
+	LVE_CHECK(driver.heapBytes[0] == 0 && driver.heapBytes[1] == 0);
+	LVE_CHECK(driver.mapCount == 0);
+}
+
+void testSmallHeapBlocks() {
+	// the host heap gets blocks of an eighth of it, a request past half of that is dedicated
+	LveMemoryAllocator allocator{VK_NULL_HANDLE, VK_NULL_HANDLE};
+	const VkDeviceSize hostBlock = LveMemoryAllocator::heapBlockSize(LveMemoryAllocator::DEFAULT_BLOCK_SIZE, HOST_HEAP_SIZE, ATOM_SIZE);
+	LVE_CHECK(hostBlock == HOST_HEAP_SIZE / 8);
+
+	VkMemoryRequirements requirements{hostBlock / 2, 256, 0};
+	LveMemoryAllocation shared = allocator.allocate(requirements, HostCoherent, LveMemoryAllocator::ResourceKind::Buffer, LveMemoryCategory::Staging);
+	requirements.size = hostBlock / 2 + 1;
+	LveMemoryAllocation dedicated = allocator.allocate(requirements, HostCoherent, LveMemoryAllocator::ResourceKind::Buffer, LveMemoryCategory::Staging);
+	LVE_CHECK(shared.block != ~0u);
+	LVE_CHECK(dedicated.block == ~0u);
+	LVE_CHECK(allocator.getHeapAllocatedSize(1) == hostBlock + hostBlock / 2 + 1);
+	LVE_CHECK(allocator.getHeapUsedSize(1, LveMemoryCategory::Staging) == hostBlock + 1);
+	allocator.free(shared);
+	allocator.free(dedicated);
+	LVE_CHECK(allocator.getHeapUsedSize(1, LveMemoryCategory::Staging) == 0);
+}
+
+}
+
+int main() {
+	testCounters(1);
+	testCounters(2);
+	testSmallHeapBlocks();
+	return lve::test::failures();
+}
@@ -0,0 +1,139 @@
+#include "lve_meshlet_builder.hpp"
+#include "lve_meshlet_culler.hpp"
+#include "lve_test.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lve::LveMeshletBuilder;
+using lve::LveMeshletCuller;
+using lve::LveModel;
+
+constexpr float PI = 3.14159265f;
+
+// closed unit sphere, poles and the seam share their vertices, triangles wound outwards
+void buildSphere(uint32_t rings, uint32_t segments, std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices) {
+	vertices.clear();
+	indices.clear();
+	auto addVertex = [&](const glm::vec3 &position) {
+		LveModel::Vertex v{};
+		v.position = position;
+		v.color = {1.f, 1.f, 1.f};
+		v.normal = position;
+		vertices.push_back(v);
+		return static_cast<uint32_t>(vertices.size() - 1);
+	};
+
+	const uint32_t top = addVertex({0.f, 0.f, 1.f});
+	for (uint32_t ring = 1; ring < rings; ring++) {
+		float theta = PI * ring / rings;
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			float phi = 2.f * PI * segment / segments;
+			addVertex({std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)});
+		}
+	}
+	const uint32_t bottom = addVertex({0.f, 0.f, -1.f});
+
+	auto ringVertex = [&](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+	auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+		const glm::vec3 &pa = vertices[a].position;
+		glm::vec3 normal = glm::cross(vertices[b].position - pa, vertices[c].position - pa);
+		if (glm::dot(normal, pa + vertices[b].position + vertices[c].position) < 0.f) {
+			std::swap(b, c);
+		}
+		indices.insert(indices.end(), {a, b, c});
+	};
+	for (uint32_t segment = 0; segment < segments; segment++) {
+		addTriangle(top, ringVertex(1, segment), ringVertex(1, segment + 1));
+		addTriangle(bottom, ringVertex(rings - 1, segment + 1), ringVertex(rings - 1, segment));
+		for (uint32_t ring = 1; ring + 1 < rings; ring++) {
+			addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment), ringVertex(ring + 1, segment + 1));
+			addTriangle(ringVertex(ring, segment), ringVertex(ring + 1, segment + 1), ringVertex(ring, segment + 1));
+		}
+	}
+}
+
+// a frustum far larger than the sphere, only the cone test can cull
+lve::LveFrustum everything() {
+	lve::LveFrustum frustum{};
+	frustum.planes[lve::LveFrustum::Left] = {1.f, 0.f, 0.f, 1e4f};
+	frustum.planes[lve::LveFrustum::Right] = {-1.f, 0.f, 0.f, 1e4f};
+	frustum.planes[lve::LveFrustum::Bottom] = {0.f, 1.f, 0.f, 1e4f};
+	frustum.planes[lve::LveFrustum::Top] = {0.f, -1.f, 0.f, 1e4f};
+	frustum.planes[lve::LveFrustum::Near] = {0.f, 0.f, 1.f, 1e4f};
+	frustum.planes[lve::LveFrustum::Far] = {0.f, 0.f, -1.f, 1e4f};
+	return frustum;
+}
+
+bool isFrontFacing(const std::vector<LveModel::Vertex> &vertices, const uint32_t *corners, const glm::vec3 &camera) {
+	const glm::vec3 &a = vertices[corners[0]].position;
+	glm::vec3 normal = glm::cross(vertices[corners[1]].position - a, vertices[corners[2]].position - a);
+	return glm::dot(normal, camera - a) > 0.f;
+}
+
+void testSphere(const glm::vec3 &viewDirection, float distance) {
+	std::vector<LveModel::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	buildSphere(48, 96, vertices, indices);
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	auto meshlets = LveMeshletBuilder::build(vertices, indices.data(), static_cast<uint32_t>(indices.size()), 64, 124);
+	LVE_CHECK(!meshlets.empty());
+
+	// every triangle is in exactly one meshlet and every meshlet got a cone on the closed mesh
+	uint32_t meshletTriangles = 0;
+	for (auto &meshlet : meshlets) {
+		meshletTriangles += meshlet.indexCount / 3;
+		LVE_CHECK(meshlet.indexCount <= 124 * 3);
+		LVE_CHECK(meshlet.coneCutoff < 1.f);
+	}
+	LVE_CHECK(meshletTriangles == triangleCount);
+
+	const glm::vec3 camera = -glm::normalize(viewDirection) * distance;
+	std::vector<uint8_t> visible(meshlets.size(), 0);
+	LveMeshletCuller::markVisible(meshlets, everything(), camera, visible);
+	std::vector<LveMeshletCuller::Range> ranges;
+	const uint32_t surviving = LveMeshletCuller::collectRanges(meshlets, visible, ranges);
+
+	// cone culling is conservative, no triangle facing the camera may be culled
+	uint32_t frontFacing = 0;
+	uint32_t frontFacingCulled = 0;
+	for (size_t m = 0; m < meshlets.size(); m++) {
+		for (uint32_t i = meshlets[m].firstIndex; i < meshlets[m].firstIndex + meshlets[m].indexCount; i += 3) {
+			if (isFrontFacing(vertices, indices.data() + i, camera)) {
+				frontFacing++;
+				if (!visible[m]) frontFacingCulled++;
+			}
+		}
+	}
+
+	std::printf(
+		"view (%.2f, %.2f, %.2f) at %.0f: %u of %u triangles survive, %u face the camera\n",
+		viewDirection.x,
+		viewDirection.y,
+		viewDirection.z,
+		distance,
+		surviving,
+		triangleCount,
+		frontFacing);
+	LVE_CHECK(frontFacingCulled == 0);
+	LVE_CHECK(surviving >= frontFacing);
+	// a far camera sees just under half of the sphere, the cones must cull most of the rest
+	LVE_CHECK(frontFacing <= triangleCount / 2 + triangleCount / 50);
+	LVE_CHECK(surviving <= triangleCount * 7 / 10);
+}
+
+}
+
+int main() {
+	testSphere({0.f, 0.f, -1.f}, 100.f);
+	testSphere({1.f, 0.f, 0.f}, 100.f);
+	testSphere({1.f, -1.f, 0.5f}, 100.f);
+	testSphere({0.f, 0.f, -1.f}, 3.f);
+	return lve::test::failures();
+}
@@ -0,0 +1,235 @@
+#include "lve_camera.hpp"
+#include "lve_occlusion_culler.hpp"
+#include "lve_test.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace {
+
+using lve::LveCamera;
+using lve::LveOccluder;
+using lve::LveOcclusionCuller;
+
+constexpr uint32_t WIDTH = 256;
+constexpr uint32_t HEIGHT = 128;
+// pixels, well past the culler's one pixel margin and its rounding
+constexpr float MARGIN = 3.f;
+
+enum class Expect { Hidden, Visible, Either };
+
+// a 10 x 10 wall in the z = 0 plane, centered on the origin
+LveOccluder makeWall() {
+	LveOccluder wall{};
+	wall.positions = {{-5.f, -5.f, 0.f}, {5.f, -5.f, 0.f}, {5.f, 5.f, 0.f}, {-5.f, 5.f, 0.f}};
+	wall.indices = {0, 1, 2, 0, 2, 3};
+	return wall;
+}
+
+LveOcclusionCuller::Box makeBox(const glm::vec3 &center, float halfSize) {
+	return {glm::mat4{1.f}, center - glm::vec3{halfSize}, center + glm::vec3{halfSize}};
+}
+
+glm::vec3 toScreen(const glm::mat4 &viewProjection, const glm::vec3 &position) {
+	glm::vec4 clip = viewProjection * glm::vec4(position, 1.f);
+	return {
+		(clip.x / clip.w * .5f + .5f) * WIDTH,
+		(clip.y / clip.w * .5f + .5f) * HEIGHT,
+		clip.z / clip.w};
+}
+
+// signed pixel distance inside the convex screen quad, negative outside
+float insideQuad(const glm::vec3 quad[4], const glm::vec2 &point) {
+	float orientation = 0.f;
+	for (int i = 0; i < 4; i++) {
+		const glm::vec3 &a = quad[i], &b = quad[(i + 1) % 4];
+		orientation += (b.x - a.x) * (b.y + a.y);
+	}
+	float sign = orientation < 0.f ? 1.f : -1.f;
+	float distance = 1e30f;
+	for (int i = 0; i < 4; i++) {
+		glm::vec2 a{quad[i].x, quad[i].y}, b{quad[(i + 1) % 4].x, quad[(i + 1) % 4].y};
+		glm::vec2 edge = b - a;
+		float cross = edge.x * (point.y - a.y) - edge.y * (point.x - a.x);
+		distance = std::min(distance, sign * cross / glm::length(edge));
+	}
+	return distance;
+}
+
+// What the wall has to do to the box, worked out from the geometry instead of a depth buffer.
+// Only decided cases are asserted, boxes right at the silhouette may go either way.
+Expect expected(const LveCamera &camera, const glm::mat4 &viewProjection, const LveOcclusionCuller::Box &box) {
+	const glm::vec3 cameraPosition = camera.getPosition();
+	const LveOccluder wall = makeWall();
+
+	glm::vec3 corners[8];
+	for (int corner = 0; corner < 8; corner++) {
+		corners[corner] = {
+			(corner & 1) ? box.max.x : box.min.x,
+			(corner & 2) ? box.max.y : box.min.y,
+			(corner & 4) ? box.max.z : box.min.z};
+		// the segment to a point on the camera's side of the wall never crosses it
+		if ((corners[corner].z > 0.f) == (cameraPosition.z > 0.f)) return Expect::Visible;
+	}
+
+	glm::vec3 quad[4];
+	for (int i = 0; i < 4; i++) {
+		glm::vec4 clip = viewProjection * glm::vec4(wall.positions[i], 1.f);
+		if (clip.w < 0.5f) return Expect::Either;  // wall crosses the near plane
+		quad[i] = toScreen(viewProjection, wall.positions[i]);
+	}
+
+	glm::vec2 screenMin{1e30f}, screenMax{-1e30f};
+	float nearestDepth = 1.f;
+	for (auto &corner : corners) {
+		glm::vec3 screen = toScreen(viewProjection, corner);
+		bool onScreen = screen.x > MARGIN && screen.y > MARGIN && screen.x < WIDTH - MARGIN && screen.y < HEIGHT - MARGIN;
+		// a corner the wall doesn't cover is in sight
+		if (onScreen && insideQuad(quad, {screen.x, screen.y}) < -MARGIN) return Expect::Visible;
+		screenMin = glm::min(screenMin, glm::vec2{screen.x, screen.y});
+		screenMax = glm::max(screenMax, glm::vec2{screen.x, screen.y});
+		nearestDepth = std::min(nearestDepth, screen.z);
+	}
+
+	// off screen is the frustum's job, the culler keeps those visible
+	if (screenMin.x < MARGIN || screenMin.y < MARGIN || screenMax.x > WIDTH - MARGIN || screenMax.y > HEIGHT - MARGIN) {
+		return Expect::Either;
+	}
+
+	// Hidden when the wall covers the box's screen rectangle with margin and is nearer than
+	// the box's nearest corner all over it. Depth is affine over the wall on screen.
+	const glm::vec2 rect[4] = {
+		screenMin - glm::vec2{MARGIN},
+		{screenMax.x + MARGIN, screenMin.y - MARGIN},
+		screenMax + glm::vec2{MARGIN},
+		{screenMin.x - MARGIN, screenMax.y + MARGIN}};
+	const glm::vec3 &a = quad[0], &b = quad[1], &c = quad[2];
+	const float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+	for (const auto &point : rect) {
+		if (insideQuad(quad, point) < MARGIN) return Expect::Either;
+		float u = ((b.y - c.y) * (point.x - c.x) + (c.x - b.x) * (point.y - c.y)) / area;
+		float v = ((c.y - a.y) * (point.x - c.x) + (a.x - c.x) * (point.y - c.y)) / area;
+		float wallDepth = u * a.z + v * b.z + (1.f - u - v) * c.z;
+		if (wallDepth >= nearestDepth - 1e-4f) return Expect::Either;
+	}
+	return Expect::Hidden;
+}
+
+struct PathResult {
+	uint32_t hidden = 0;
+	uint32_t visible = 0;
+};
+
+// Moves the camera along a path, culls the boxes against the wall at every step and checks
+// the decided cases.
+PathResult runPath(
+	const char *name,
+	LveOcclusionCuller &culler,
+	const std::vector<LveOcclusionCuller::Box> &boxes,
+	uint32_t steps,
+	const std::function<void(float, LveCamera &)> &place) {
+	const LveOccluder wall = makeWall();
+	PathResult result{};
+	std::vector<uint8_t> visible;
+	for (uint32_t step = 0; step <= steps; step++) {
+		LveCamera camera{};
+		camera.setPerspectiveProjection(glm::radians(60.f), static_cast<float>(WIDTH) / HEIGHT, 0.1f, 100.f);
+		place(static_cast<float>(step) / steps, camera);
+		const glm::mat4 viewProjection = camera.getProjection() * camera.getView();
+
+		culler.beginFrame(viewProjection);
+		culler.addOccluder(wall, glm::mat4{1.f});
+		culler.rasterize();
+		culler.testVisibility(boxes, visible);
+
+		for (size_t i = 0; i < boxes.size(); i++) {
+			LVE_CHECK(visible[i] == (culler.isVisible(boxes[i]) ? 1 : 0));
+			Expect expect = expected(camera, viewProjection, boxes[i]);
+			if (expect == Expect::Either) continue;
+			bool expectVisible = expect == Expect::Visible;
+			if ((visible[i] != 0) != expectVisible) {
+				std::printf(
+					"%s step %u: box %zu should be %s\n", name, step, i, expectVisible ? "visible" : "hidden");
+			}
+			LVE_CHECK((visible[i] != 0) == expectVisible);
+			(expectVisible ? result.visible : result.hidden)++;
+		}
+	}
+	std::printf("%s: %u hidden, %u visible decided\n", name, result.hidden, result.visible);
+	return result;
+}
+
+void testStatic(LveOcclusionCuller &culler) {
+	// straight on from 20 in front of the wall
+	LveCamera camera{};
+	camera.setPerspectiveProjection(glm::radians(60.f), static_cast<float>(WIDTH) / HEIGHT, 0.1f, 100.f);
+	camera.setViewTarget({0.f, 0.f, -20.f}, {0.f, 0.f, 0.f});
+	culler.beginFrame(camera.getProjection() * camera.getView());
+	culler.addOccluder(makeWall(), glm::mat4{1.f});
+	culler.rasterize();
+
+	const std::vector<LveOcclusionCuller::Box> boxes = {
+		makeBox({0.f, 0.f, 5.f}, 1.f),     // right behind the wall
+		makeBox({3.f, -3.f, 10.f}, 1.f),   // behind, off center, still covered
+		makeBox({0.f, 0.f, -5.f}, 1.f),    // in front of the wall
+		makeBox({0.f, 0.f, 0.f}, 1.f),     // pokes through the wall
+		makeBox({9.f, 0.f, 10.f}, 1.f),    // behind, but past the silhouette
+		makeBox({6.5f, 0.f, 10.f}, 0.5f),  // behind the edge, inside its shadow
+		makeBox({0.f, 0.f, 60.f}, 20.f),   // larger than the wall, far behind
+		makeBox({0.f, 0.f, -20.f}, 1.f),   // around the camera, crosses the near plane
+		makeBox({0.f, 0.f, -40.f}, 1.f),   // behind the camera
+	};
+	const bool expectVisible[] = {false, false, true, true, true, false, true, true, true};
+
+	std::vector<uint8_t> visible;
+	culler.testVisibility(boxes, visible);
+	for (size_t i = 0; i < boxes.size(); i++) {
+		if ((visible[i] != 0) != expectVisible[i]) {
+			std::printf("static box %zu should be %s\n", i, expectVisible[i] ? "visible" : "hidden");
+		}
+		LVE_CHECK((visible[i] != 0) == expectVisible[i]);
+	}
+	LVE_CHECK(culler.getStats().occluders == 1);
+	LVE_CHECK(culler.getStats().occluderTriangles == 2);
+	LVE_CHECK(culler.getStats().testedBoxes == boxes.size());
+	LVE_CHECK(culler.getStats().occludedBoxes == 3);
+}
+
+}
+
+int main() {
+	LveOcclusionCuller culler{WIDTH, HEIGHT, 2};
+	testStatic(culler);
+
+	std::vector<LveOcclusionCuller::Box> boxes;
+	for (float x = -8.f; x <= 8.f; x += 2.f) {
+		for (float z : {-3.f, 2.f, 6.f, 15.f}) {
+			boxes.push_back(makeBox({x, x * 0.25f, z}, 0.75f));
+		}
+	}
+
+	// strafe past the wall, boxes slide out from behind its edges
+	auto strafe = runPath("strafe", culler, boxes, 80, [](float t, LveCamera &camera) {
+		glm::vec3 position{-30.f + 60.f * t, 0.f, -25.f};
+		camera.setViewDirection(position, {0.f, 0.f, 1.f});
+	});
+	// orbit around the wall looking at its center, the wall turns edge on
+	auto orbit = runPath("orbit", culler, boxes, 90, [](float t, LveCamera &camera) {
+		float angle = glm::radians(-85.f + 170.f * t);
+		camera.setViewTarget({25.f * std::sin(angle), 2.f, -25.f * std::cos(angle)}, {0.f, 0.f, 0.f});
+	});
+	// walk up to the wall and through it, the occluder gets clipped by the near plane
+	auto approach = runPath("approach", culler, boxes, 80, [](float t, LveCamera &camera) {
+		camera.setViewDirection({0.5f, 0.3f, -40.f + 45.f * t}, {0.f, 0.f, 1.f});
+	});
+
+	// every path has to decide both ways, or it tests nothing
+	for (const auto &result : {strafe, orbit, approach}) {
+		LVE_CHECK(result.hidden > 0 && result.visible > 0);
+	}
+	return lve::test::failures();
+}
@@ -0,0 +1,104 @@
+#include "lve_thread_pool.hpp"
+#include "lve_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using lve::LveThreadPool;
+
+// blocks until count jobs have called done()
+class Latch {
+public:
+	explicit Latch(int count) : remaining{count} {}
+
+	void done() {
+		std::lock_guard<std::mutex> lock{mutex};
+		if (--remaining == 0) finished.notify_all();
+	}
+
+	bool wait() {
+		std::unique_lock<std::mutex> lock{mutex};
+		return finished.wait_for(lock, std::chrono::seconds{30}, [this] { return remaining == 0; });
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable finished;
+	int remaining;
+};
+
+void testThreadCount() {
+	LveThreadPool defaultPool{};
+	LVE_CHECK(defaultPool.getThreadCount() >= 1);
+	LveThreadPool pool{3};
+	LVE_CHECK(pool.getThreadCount() == 3);
+}
+
+void testEveryJobRuns() {
+	constexpr int JOBS = 100000;
+	LveThreadPool pool{4};
+	std::atomic<int> sum{0};
+	Latch latch{JOBS};
+	for (int i = 0; i < JOBS; i++) {
+		pool.submit([&, i] {
+			sum += i % 7;
+			latch.done();
+		});
+	}
+	LVE_CHECK(latch.wait());
+	int expected = 0;
+	for (int i = 0; i < JOBS; i++) expected += i % 7;
+	LVE_CHECK(sum == expected);
+}
+
+void testFifoOnOneThread() {
+	LveThreadPool pool{1};
+	std::vector<int> order;
+	Latch latch{1000};
+	for (int i = 0; i < 1000; i++) {
+		pool.submit([&, i] {
+			order.push_back(i);
+			latch.done();
+		});
+	}
+	LVE_CHECK(latch.wait());
+	bool inOrder = order.size() == 1000;
+	for (size_t i = 0; inOrder && i < order.size(); i++) inOrder = order[i] == static_cast<int>(i);
+	LVE_CHECK(inOrder);
+}
+
+void testDestroyWaitsForRunningJobs() {
+	// The running job finishes before the destructor returns, the queued ones are dropped.
+	std::atomic<bool> started{false};
+	std::atomic<bool> finished{false};
+	std::atomic<int> dropped{0};
+	{
+		LveThreadPool pool{1};
+		pool.submit([&] {
+			started = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds{50});
+			finished = true;
+		});
+		for (int i = 0; i < 100; i++) {
+			pool.submit([&] { dropped++; });
+		}
+		while (!started) std::this_thread::yield();
+	}
+	LVE_CHECK(finished);
+	LVE_CHECK(dropped == 0);
+}
+
+}
+
+int main() {
+	testThreadCount();
+	testEveryJobRuns();
+	testFifoOnOneThread();
+	testDestroyWaitsForRunningJobs();
+	return lve::test::failures();
+}
@@ -0,0 +1,154 @@
+#include "lve_memory_allocator.hpp"
+#include "lve_test.hpp"
+#include "lve_tlsf_allocator.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+using lve::LveMemoryAllocator;
+using lve::LveTlsfAllocator;
+
+struct Live {
+	VkDeviceSize size;
+	VkDeviceSize alignment;
+	LveTlsfAllocator::Handle handle;
+};
+
+// live allocations by offset, so overlaps only need checking against the neighbours
+bool insertChecked(std::map<VkDeviceSize, Live> &live, VkDeviceSize offset, const Live &allocation, VkDeviceSize capacity) {
+	if (offset % allocation.alignment != 0 || offset + allocation.size > capacity) return false;
+	auto next = live.lower_bound(offset);
+	if (next != live.end() && offset + allocation.size > next->first) return false;
+	if (next != live.begin()) {
+		auto previous = std::prev(next);
+		if (previous->first + previous->second.size > offset) return false;
+	}
+	live.emplace(offset, allocation);
+	return true;
+}
+
+VkDeviceSize randomSize(std::mt19937 &rng) {
+	// mostly small, some medium, a few large
+	std::uniform_int_distribution<int> kind{0, 99};
+	int k = kind(rng);
+	if (k < 70) return std::uniform_int_distribution<VkDeviceSize>{1, 4096}(rng);
+	if (k < 95) return std::uniform_int_distribution<VkDeviceSize>{4097, 256 << 10}(rng);
+	return std::uniform_int_distribution<VkDeviceSize>{256 << 10, 4 << 20}(rng);
+}
+
+void testStress(uint32_t seed) {
+	constexpr VkDeviceSize capacity = 64ull << 20;
+	LveTlsfAllocator allocator{capacity};
+	std::map<VkDeviceSize, Live> live;
+	std::mt19937 rng{seed};
+	std::uniform_int_distribution<int> alignmentBits{0, 16};
+	std::uniform_int_distribution<int> action{0, 99};
+
+	VkDeviceSize usedSize = 0;
+	uint32_t failedAllocations = 0;
+	for (int step = 0; step < 200000; step++) {
+		// drift between filling up and draining so the allocator runs both nearly full and fragmented
+		int allocateChance = (step / 20000) % 2 == 0 ? 60 : 40;
+		if (live.empty() || action(rng) < allocateChance) {
+			Live allocation{randomSize(rng), VkDeviceSize{1} << alignmentBits(rng), LveTlsfAllocator::INVALID_HANDLE};
+			VkDeviceSize offset = 0;
+			allocation.handle = allocator.allocate(allocation.size, allocation.alignment, offset);
+			if (allocation.handle == LveTlsfAllocator::INVALID_HANDLE) {
+				failedAllocations++;
+				// Only allowed when no free block could hold the size with worst case padding. The
+				// lookup rounds the request up to the next size class, up to 1/32 larger.
+				VkDeviceSize request = allocation.size + allocation.alignment - 1;
+				LVE_CHECK(allocator.getLargestFreeBlock() < request + request / 32 + 8);
+				continue;
+			}
+			LVE_CHECK(insertChecked(live, offset, allocation, capacity));
+			usedSize += allocation.size;
+		} else {
+			auto it = live.begin();
+			std::advance(it, std::uniform_int_distribution<size_t>{0, live.size() - 1}(rng));
+			allocator.free(it->second.handle);
+			usedSize -= it->second.size;
+			live.erase(it);
+		}
+		LVE_CHECK(allocator.getUsedSize() == usedSize);
+		LVE_CHECK(allocator.getAllocationCount() == live.size());
+	}
+	// the run has to get the allocator full enough to refuse requests
+	LVE_CHECK(failedAllocations > 0);
+
+	for (auto &kv : live) {
+		allocator.free(kv.second.handle);
+	}
+	// every free neighbour merged back into one block spanning the range
+	LVE_CHECK(allocator.isEmpty());
+	LVE_CHECK(allocator.getUsedSize() == 0);
+	LVE_CHECK(allocator.getFreeBlockCount() == 1);
+	LVE_CHECK(allocator.getLargestFreeBlock() == capacity);
+
+	VkDeviceSize offset = 1;
+	auto handle = allocator.allocate(capacity, 1, offset);
+	LVE_CHECK(handle != LveTlsfAllocator::INVALID_HANDLE && offset == 0);
+	allocator.free(handle);
+}
+
+void testExactFit() {
+	// The range can be carved into equal pieces without any slack and all of them merge again.
+	// Alignment 1, a larger one reserves worst case padding and can't use the last piece.
+	constexpr VkDeviceSize capacity = 1 << 20;
+	LveTlsfAllocator allocator{capacity};
+	std::vector<LveTlsfAllocator::Handle> handles;
+	VkDeviceSize offset;
+	for (VkDeviceSize i = 0; i < capacity / 4096; i++) {
+		handles.push_back(allocator.allocate(4096, 1, offset));
+		LVE_CHECK(handles.back() != LveTlsfAllocator::INVALID_HANDLE && offset == i * 4096);
+	}
+	LVE_CHECK(allocator.getFreeBlockCount() == 0);
+	LVE_CHECK(allocator.allocate(1, 1, offset) == LveTlsfAllocator::INVALID_HANDLE);
+
+	// free every other one, then the rest, in both directions
+	for (size_t i = 0; i < handles.size(); i += 2) allocator.free(handles[i]);
+	LVE_CHECK(allocator.getFreeBlockCount() == handles.size() / 2);
+	for (size_t i = handles.size() - 1; i < handles.size(); i -= 2) allocator.free(handles[i]);
+	LVE_CHECK(allocator.getFreeBlockCount() == 1);
+	LVE_CHECK(allocator.getLargestFreeBlock() == capacity);
+}
+
+void testDedicatedThreshold() {
+	constexpr VkDeviceSize blockSize = LveMemoryAllocator::DEFAULT_BLOCK_SIZE;
+
+	// large heaps use the full block size, small ones an eighth of the heap
+	LVE_CHECK(LveMemoryAllocator::heapBlockSize(blockSize, 8ull << 30, 1) == blockSize);
+	LVE_CHECK(LveMemoryAllocator::heapBlockSize(blockSize, 256ull << 20, 1) == 32ull << 20);
+	// rounded down to whole atoms
+	LVE_CHECK(LveMemoryAllocator::heapBlockSize(blockSize, 1000, 64) == 64);
+	LVE_CHECK(LveMemoryAllocator::heapBlockSize(blockSize, (256ull << 20) + 8 * 100, 256) % 256 == 0);
+
+	for (VkDeviceSize heapSize : {8ull << 30, 256ull << 20, 96ull << 20}) {
+		for (VkDeviceSize atom : {1ull, 64ull, 256ull}) {
+			VkDeviceSize size = LveMemoryAllocator::heapBlockSize(blockSize, heapSize, atom);
+			LVE_CHECK(!LveMemoryAllocator::isDedicated(size / 2, size));
+			LVE_CHECK(LveMemoryAllocator::isDedicated(size / 2 + 1, size));
+
+			// the largest request that isn't dedicated always fits an empty block, even with
+			// the largest alignment a resource asks for in practice
+			LveTlsfAllocator allocator{size};
+			VkDeviceSize offset;
+			LVE_CHECK(allocator.allocate(size / 2, 64 << 10, offset) != LveTlsfAllocator::INVALID_HANDLE);
+		}
+	}
+}
+
+}
+
+int main() {
+	testStress(1);
+	testStress(2);
+	testExactFit();
+	testDedicatedThreshold();
+	return lve::test::failures();
+}
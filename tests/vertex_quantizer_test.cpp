@@ -0,0 +1,202 @@
+#include "lve_test.hpp"
+#include "lve_vertex_quantizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using lve::LveModel;
+using lve::LveVertexQuantizer;
+
+// the worst case errors documented in lve_vertex_quantizer.hpp
+constexpr float MAX_NORMAL_DEGREES = 0.04f;
+constexpr float MAX_COLOR_ERROR = 1.f / 510.f;
+
+float angleDegrees(const glm::vec3 &a, const glm::vec3 &b) {
+	float d = std::clamp(glm::dot(glm::normalize(a), glm::normalize(b)), -1.f, 1.f);
+	return std::acos(d) * 180.f / 3.14159265f;
+}
+
+glm::vec3 randomDirection(std::mt19937 &rng) {
+	std::normal_distribution<float> gauss{0.f, 1.f};
+	glm::vec3 v{};
+	while (glm::dot(v, v) < 1e-6f) {
+		v.x = gauss(rng);
+		v.y = gauss(rng);
+		v.z = gauss(rng);
+	}
+	return glm::normalize(v);
+}
+
+void checkNormal(const glm::vec3 &normal) {
+	int16_t encoded[2];
+	LveVertexQuantizer::octEncode(normal, encoded);
+	glm::vec3 decoded = LveVertexQuantizer::octDecode(encoded);
+	float error = angleDegrees(normal, decoded);
+	if (error > MAX_NORMAL_DEGREES) {
+		std::printf(
+			"normal (%f, %f, %f) decoded with %f degrees error\n", normal.x, normal.y, normal.z, error);
+	}
+	LVE_CHECK(error <= MAX_NORMAL_DEGREES);
+}
+
+void testPositions() {
+	std::mt19937 rng{1};
+	std::uniform_real_distribution<float> coordinate{-50.f, 50.f};
+
+	std::vector<LveModel::Vertex> vertices(4096);
+	for (auto &v : vertices) {
+		v.position = {coordinate(rng), coordinate(rng) * 0.01f, coordinate(rng) * 3.f};
+	}
+	auto quantizer = LveVertexQuantizer::fromVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
+
+	glm::vec3 boundsMin{1e30f}, boundsMax{-1e30f};
+	for (auto &v : vertices) {
+		boundsMin = glm::min(boundsMin, v.position);
+		boundsMax = glm::max(boundsMax, v.position);
+	}
+	const glm::vec3 extent = boundsMax - boundsMin;
+	const glm::mat4 transform = quantizer.positionTransform();
+
+	for (auto &v : vertices) {
+		auto encoded = quantizer.encode(v);
+		auto decoded = quantizer.decode(encoded);
+		// what the vertex shader sees, unorm times the transform folded into the model matrix
+		glm::vec4 unorm{
+			encoded.position[0] / 65535.f, encoded.position[1] / 65535.f, encoded.position[2] / 65535.f, 1.f};
+		glm::vec4 shader = transform * unorm;
+		for (int i = 0; i < 3; i++) {
+			// half a step plus float rounding of the bounds
+			float tolerance = extent[i] / 131070.f + std::fabs(v.position[i]) * 1e-6f;
+			LVE_CHECK(std::fabs(decoded.position[i] - v.position[i]) <= tolerance);
+			LVE_CHECK(std::fabs(shader[i] - v.position[i]) <= tolerance);
+		}
+	}
+
+	// corners of the bounds are exact
+	LveModel::Vertex corner{};
+	corner.position = boundsMax;
+	auto decoded = quantizer.decode(quantizer.encode(corner));
+	for (int i = 0; i < 3; i++) {
+		LVE_CHECK(std::fabs(decoded.position[i] - boundsMax[i]) <= std::fabs(boundsMax[i]) * 1e-6f);
+	}
+
+	// a flat mesh keeps its flat axis
+	LveModel::Vertex flat[2]{};
+	flat[0].position = {-1.f, 2.f, -1.f};
+	flat[1].position = {1.f, 2.f, 1.f};
+	auto flatQuantizer = LveVertexQuantizer::fromVertices(flat, 2);
+	LVE_CHECK(flatQuantizer.decode(flatQuantizer.encode(flat[1])).position.y == 2.f);
+}
+
+void testNormals() {
+	// poles, axes and the fold seam between the two hemispheres
+	const glm::vec3 special[] = {
+		{0.f, 0.f, 1.f},
+		{0.f, 0.f, -1.f},
+		{1.f, 0.f, 0.f},
+		{-1.f, 0.f, 0.f},
+		{0.f, 1.f, 0.f},
+		{0.f, -1.f, 0.f},
+		{1.f, 1.f, 0.f},
+		{-1.f, 1.f, 0.f},
+		{1.f, -1.f, 0.f},
+		{-1.f, -1.f, 0.f},
+		{1e-4f, 1e-4f, -1.f},
+		{-1e-4f, 1e-4f, -1.f},
+		{1e-4f, -1e-4f, -1.f},
+		{-1e-4f, -1e-4f, -1.f},
+		{0.3f, 0.7f, 1e-5f},
+		{0.3f, 0.7f, -1e-5f},
+		{-0.6f, 0.2f, -1e-6f},
+		{1.f, 1e-6f, -1e-6f},
+	};
+	for (auto &n : special) {
+		checkNormal(glm::normalize(n));
+	}
+
+	// sweep around the seam z = 0 from both sides
+	for (int i = 0; i < 3600; i++) {
+		float a = i * 3.14159265f / 1800.f;
+		for (float z : {-1e-3f, -1e-6f, 0.f, 1e-6f, 1e-3f}) {
+			checkNormal(glm::normalize(glm::vec3{std::cos(a), std::sin(a), z}));
+		}
+	}
+
+	std::mt19937 rng{2};
+	for (int i = 0; i < 100000; i++) {
+		checkNormal(randomDirection(rng));
+	}
+
+	// a zero normal stays zero length after encoding, it decodes to +z
+	int16_t encoded[2];
+	LveVertexQuantizer::octEncode(glm::vec3{0.f}, encoded);
+	LVE_CHECK(encoded[0] == 0 && encoded[1] == 0);
+}
+
+void testColors() {
+	LveVertexQuantizer quantizer{glm::vec3{0.f}, glm::vec3{1.f}};
+	for (int i = 0; i <= 1000; i++) {
+		LveModel::Vertex v{};
+		float c = i / 1000.f;
+		v.color = {c, 1.f - c, c * c};
+		auto encoded = quantizer.encode(v);
+		LVE_CHECK(encoded.color[3] == 255);
+		auto decoded = quantizer.decode(encoded);
+		for (int k = 0; k < 3; k++) {
+			LVE_CHECK(std::fabs(decoded.color[k] - v.color[k]) <= MAX_COLOR_ERROR + 1e-6f);
+		}
+	}
+
+	// out of range colors clamp
+	LveModel::Vertex v{};
+	v.color = {-0.5f, 2.f, 0.5f};
+	auto encoded = quantizer.encode(v);
+	LVE_CHECK(encoded.color[0] == 0);
+	LVE_CHECK(encoded.color[1] == 255);
+}
+
+void testUvs() {
+	std::mt19937 rng{3};
+	std::uniform_real_distribution<float> uv{-8.f, 8.f};
+	auto check = [](float value) {
+		float decoded = LveVertexQuantizer::halfToFloat(LveVertexQuantizer::floatToHalf(value));
+		// relative 2^-11 for normal halfs, half the subnormal step 2^-25 below that
+		float tolerance = std::max(std::fabs(value) * std::ldexp(1.f, -11), std::ldexp(1.f, -25));
+		LVE_CHECK(std::fabs(decoded - value) <= tolerance);
+	};
+	for (int i = 0; i < 100000; i++) {
+		check(uv(rng));
+	}
+	for (float value : {0.f, 1.f, 0.5f, 0.25f, 1.f / 3.f, 0.999f, 1e-5f, 6.1e-5f, 1e-7f, 1024.f, 65504.f}) {
+		check(value);
+		check(-value);
+	}
+
+	// every half survives the trip through float
+	for (uint32_t h = 0; h < 0x10000; h++) {
+		uint16_t half = static_cast<uint16_t>(h);
+		bool nan = (half & 0x7c00) == 0x7c00 && (half & 0x3ff) != 0;
+		if (!nan) {
+			LVE_CHECK(LveVertexQuantizer::floatToHalf(LveVertexQuantizer::halfToFloat(half)) == half);
+		}
+	}
+
+	LVE_CHECK(LveVertexQuantizer::floatToHalf(65520.f) == 0x7c00);
+	LVE_CHECK(LveVertexQuantizer::floatToHalf(-1e9f) == 0xfc00);
+	LVE_CHECK(std::isnan(LveVertexQuantizer::halfToFloat(LveVertexQuantizer::floatToHalf(NAN))));
+}
+
+}
+
+int main() {
+	testPositions();
+	testNormals();
+	testColors();
+	testUvs();
+	return lve::test::failures();
+}